@@ -37,10 +37,28 @@ namespace vp {
 
     clock_master();
 
+    // Slaves in analytic mode are not given the edges
     inline void sync(bool value)
     {
       if (next) next->sync(value);
-      sync_meth(this->get_remote_context(), value);
+      if (sync_phase_meth == NULL) sync_meth(this->get_remote_context(), value);
+    }
+
+    // Analytic mode. Gives the time of a clock edge and the level of the clock after it.
+    // The clock then toggles at twice the frequency given with set_frequency, until the
+    // next call. This is sent instead of the edges to the slaves which registered a phase
+    // method, so that they can compute the edges and only wake up at the ones they need.
+    inline void sync_phase(int64_t time, bool value)
+    {
+      if (next) next->sync_phase(time, value);
+      if (sync_phase_meth) sync_phase_meth(this->get_remote_context(), time, value);
+    }
+
+    // Tells if all the slaves are in analytic mode, in which case edges do not need to
+    // be generated
+    inline bool is_analytic()
+    {
+      return sync_phase_meth != NULL && (next == NULL || next->is_analytic());
     }
 
     inline void set_frequency(int64_t frequency)
@@ -49,6 +67,14 @@ namespace vp {
       set_frequency_meth(this->get_remote_context(), frequency);
     }
 
+    // Same as set_frequency but only for the slaves in analytic mode, so that the other
+    // slaves keep on following the edges when both kinds are bound
+    inline void set_phase_frequency(int64_t frequency)
+    {
+      if (next) next->set_phase_frequency(frequency);
+      if (sync_phase_meth) set_frequency_meth(this->get_remote_context(), frequency);
+    }
+
     void bind_to(vp::port *port, vp::config *config);
 
     bool is_bound() { return slave_port != NULL; }
@@ -63,6 +89,7 @@ namespace vp {
     static inline void sync_default(void *, bool value);
     static inline void set_frequency_default(void *, int64_t value);
     static inline void set_frequency_freq_cross_stub(clock_master *_this, int64_t value);
+    static inline void sync_phase_freq_cross_stub(clock_master *_this, int64_t time, bool value);
 
     void (*sync_meth)(void *, bool value);
     void (*sync_meth_mux)(void *, bool value, int id);
@@ -72,6 +99,9 @@ namespace vp {
     void (*set_frequency_meth_mux)(void *, int64_t frequency, int id);
     void (*set_frequency_meth_freq_cross)(void *, int64_t value);
 
+    void (*sync_phase_meth)(void *, int64_t time, bool value);
+    void (*sync_phase_meth_freq_cross)(void *, int64_t time, bool value);
+
     vp::component *comp_mux;
     int sync_mux;
     clock_slave *slave_port = NULL;
@@ -96,6 +126,12 @@ namespace vp {
     void set_set_frequency_meth(void (*)(void *_this, int64_t frequency));
     void set_set_frequency_meth_muxed(void (*)(void *_this, int64_t, int), int id);
 
+    // Registering this method puts the slave in analytic mode, see clock_master::sync_phase.
+    // A clock generator then also sends its frequency to the slave, including the ramp at
+    // power-up and a zero frequency when it is powered off, so this must only be done by
+    // slaves which track the generator, and not for example by clock domains.
+    void set_sync_phase_meth(void (*)(void *_this, int64_t time, bool value));
+
     inline void bind_to(vp::port *_port, vp::config *config);
 
 
@@ -107,6 +143,8 @@ namespace vp {
     void (*set_frequency)(void *comp, int64_t frequency);
     void (*set_frequency_mux)(void *comp, int64_t frequency, int id);
 
+    void (*sync_phase)(void *comp, int64_t time, bool value);
+
     int sync_mux_id;
   };
 
@@ -38,6 +38,12 @@ namespace vp {
   typedef void (cpi_sync_cycle_meth_t)(void *, int href, int vsync, int data);
   typedef void (cpi_sync_cycle_meth_muxed_t)(void *, int href, int vsync, int data, int id);
 
+  // Line-level transfer, giving all the bytes of a line in one call instead of one sync
+  // per pixel clock edge. href is active during the whole line, which lasts duration
+  // picoseconds. This is optional, the camera must check that the receiver supports it
+  // and otherwise fall back to the pixel clock sync.
+  typedef void (cpi_sync_line_meth_t)(void *, int vsync, uint8_t *data, int size, int64_t duration);
+
 
   class cpi_master : public vp::master_port
   {
@@ -57,6 +63,18 @@ namespace vp {
       return sync_cycle_meth(this->get_remote_context(), href, vsync, data);
     }
 
+    // Send a whole line, returns false if the receiver does not support it
+    inline bool sync_line(int vsync, uint8_t *data, int size, int64_t duration)
+    {
+      if (this->sync_line_meth == NULL)
+        return false;
+
+      this->sync_line_meth(this->get_remote_context(), vsync, data, size, duration);
+      return true;
+    }
+
+    inline bool has_sync_line() { return this->sync_line_meth != NULL; }
+
     void bind_to(vp::port *port, vp::config *config);
 
     bool is_bound() { return slave_port != NULL; }
@@ -72,6 +90,8 @@ namespace vp {
     void (*sync_cycle_meth)(void *, int href, int vsync, int data);
     void (*sync_cycle_meth_mux)(void *, int href, int vsync, int data, int mux);
 
+    cpi_sync_line_meth_t *sync_line_meth;
+
     vp::component *comp_mux;
     int sync_mux;
     cpi_slave *slave_port = NULL;
@@ -95,6 +115,8 @@ namespace vp {
     inline void set_sync_cycle_meth(cpi_sync_cycle_meth_t *meth);
     inline void set_sync_cycle_meth_muxed(cpi_sync_cycle_meth_muxed_t *meth, int id);
 
+    inline void set_sync_line_meth(cpi_sync_line_meth_t *meth);
+
     inline void bind_to(vp::port *_port, vp::config *config);
 
   private:
@@ -105,6 +127,8 @@ namespace vp {
     void (*sync_cycle_meth)(void *comp, int href, int vsync, int data);
     void (*sync_cycle_mux_meth)(void *comp, int href, int vsync, int data, int mux);
 
+    cpi_sync_line_meth_t *sync_line_meth = NULL;
+
     static inline void sync_default(cpi_slave *, int pclk, int href, int vsync, int data);
     static inline void sync_cycle_default(cpi_slave *, int href, int vsync, int data);
 
@@ -114,6 +138,7 @@ namespace vp {
 
 
   inline cpi_master::cpi_master() {
+    sync_line_meth = NULL;
   }
 
 
@@ -136,6 +161,7 @@ namespace vp {
     {
       sync_meth = port->sync_meth;
       sync_cycle_meth = port->sync_cycle_meth;
+      sync_line_meth = port->sync_line_meth;
       set_remote_context(port->get_context());
     }
     else
@@ -146,6 +172,8 @@ namespace vp {
       sync_cycle_meth_mux = port->sync_cycle_mux_meth;
       sync_cycle_meth = (cpi_sync_cycle_meth_t *)&cpi_master::sync_cycle_muxed_stub;
 
+      sync_line_meth = NULL;
+
       set_remote_context(this);
       comp_mux = (vp::component *)port->get_context();
       sync_mux = port->mux_id;
@@ -188,6 +216,11 @@ namespace vp {
     mux_id = id;
   }
 
+  inline void cpi_slave::set_sync_line_meth(cpi_sync_line_meth_t *meth)
+  {
+    sync_line_meth = meth;
+  }
+
   inline void cpi_slave::sync_default(cpi_slave *, int pclk, int href, int vsync, int data)
   {
   }
@@ -39,6 +39,23 @@ namespace vp {
   typedef void (hyper_cs_sync_meth_muxed_t)(void *, int cs, int active, int id);
 
 
+
+  // Burst-level transfer of a whole HyperBus transaction, from chip select activation
+  // to deactivation. This can replace the per-byte sync_cycle when the slave supports it.
+  typedef struct
+  {
+    int cs;                // Chip select of the slave
+    uint8_t ca[6];         // Command-address bytes, in the order they are sent on the bus
+    uint8_t *data;         // Data to be written, or filled by the slave for reads
+    int size;              // Data size in bytes
+    int64_t duration;      // Duration of the command-address and data phases in picoseconds
+    int latency;           // Initial latency in bus clock cycles, set by the slave. The
+                           // master must add it to the duration of the transfer.
+  } hyper_burst_t;
+
+  typedef void (hyper_burst_meth_t)(void *, hyper_burst_t *burst);
+
+
   class hyper_master : public vp::master_port
   {
     friend class hyper_slave;
@@ -57,6 +74,20 @@ namespace vp {
       return cs_sync_meth(this->get_remote_context(), cs, active);
     }
 
+    // Send a whole transaction at once. This returns false if the slave does not support
+    // it, in which case the transaction must be sent byte by byte with sync_cycle and cs_sync.
+    inline bool burst(hyper_burst_t *burst)
+    {
+      if (burst_meth == NULL)
+        return false;
+
+      burst->latency = 0;
+      burst_meth(this->get_remote_context(), burst);
+      return true;
+    }
+
+    inline bool has_burst() { return burst_meth != NULL; }
+
     void bind_to(vp::port *port, vp::config *config);
 
     inline void set_sync_cycle_meth(hyper_sync_cycle_meth_t *meth);
@@ -76,6 +107,7 @@ namespace vp {
     void (*sync_cycle_meth_mux)(void *, int data, int mux);
     void (*cs_sync_meth)(void *, int cs, int active);
     void (*cs_sync_meth_mux)(void *, int cs, int active, int mux);
+    hyper_burst_meth_t *burst_meth;
 
     static inline void sync_cycle_default(void *, int data);
 
@@ -108,6 +140,9 @@ namespace vp {
     inline void set_cs_sync_meth(hyper_cs_sync_meth_t *meth);
     inline void set_cs_sync_meth_muxed(hyper_cs_sync_meth_muxed_t *meth, int id);
 
+    // Declare that whole transactions can be received at once
+    inline void set_burst_meth(hyper_burst_meth_t *meth);
+
     inline void bind_to(vp::port *_port, vp::config *config);
 
     static inline void sync_cycle_muxed_stub(hyper_slave *_this, int data);
@@ -122,6 +157,7 @@ namespace vp {
     void (*sync_cycle_mux_meth)(void *comp, int data, int mux);
     void (*cs_sync)(void *comp, int cs, int active);
     void (*cs_sync_mux)(void *comp, int cs, int active, int mux);
+    hyper_burst_meth_t *burst;
 
     static inline void sync_cycle_default(hyper_slave *, int data);
     static inline void cs_sync_default(hyper_slave *, int cs, int active);
@@ -137,6 +173,7 @@ namespace vp {
   inline hyper_master::hyper_master() {
     slave_sync_cycle = &hyper_master::sync_cycle_default;
     slave_sync_cycle_mux = NULL;
+    burst_meth = NULL;
   }
 
 
@@ -180,6 +217,7 @@ namespace vp {
     {
       sync_cycle_meth = port->sync_cycle_meth;
       cs_sync_meth = port->cs_sync;
+      burst_meth = port->burst;
       this->set_remote_context(port->get_context());
     }
     else
@@ -190,6 +228,9 @@ namespace vp {
       cs_sync_meth_mux = port->cs_sync_mux;
       cs_sync_meth = (hyper_cs_sync_meth_t *)&hyper_master::cs_sync_muxed_stub;
 
+      // Bursts are not supported on multiplexed ports
+      burst_meth = NULL;
+
       this->set_remote_context(this);
       comp_mux = (vp::component *)port->get_context();
       sync_mux = port->mux_id;
@@ -222,7 +263,7 @@ namespace vp {
     }
   }
 
-  inline hyper_slave::hyper_slave() : sync_cycle_meth(NULL), sync_cycle_mux_meth(NULL) {
+  inline hyper_slave::hyper_slave() : sync_cycle_meth(NULL), sync_cycle_mux_meth(NULL), burst(NULL) {
     sync_cycle_meth = (hyper_sync_cycle_meth_t *)&hyper_slave::sync_cycle_default;
     cs_sync = (hyper_cs_sync_meth_t *)&hyper_slave::cs_sync_default;
   }
@@ -253,6 +294,11 @@ namespace vp {
     mux_id = id;
   }
 
+  inline void hyper_slave::set_burst_meth(hyper_burst_meth_t *meth)
+  {
+    burst = meth;
+  }
+
   inline void hyper_slave::sync_cycle_default(hyper_slave *, int data)
   {
   }
@@ -41,6 +41,34 @@ namespace vp {
 
 
 
+  // Transaction-level transfer, describing a whole message (start, address, data bytes,
+  // acks and optional stop) instead of the scl/sda changes producing it.
+  // The initiator fills the request and sends it to the bus, which gives it to all the
+  // other devices. The device matching the address acknowledges it and handles the data.
+  // This is optional, the bus can refuse the transfer, for example if a device only
+  // handles pins or if another master is using the bus, and the initiator must then fall
+  // back to the pins.
+  typedef struct
+  {
+    int addr;                 // 7 bits address of the target
+    bool is_write;
+    uint8_t *data;            // Bytes sent by the initiator, or filled by the target for reads
+    int size;                 // Number of data bytes
+    bool stop;                // True if the transfer ends with a stop, otherwise a restart follows
+    int64_t duration;         // Duration of the whole transfer on the bus in picoseconds
+    bool addr_ack;            // Set by the target if it acknowledged the address
+    int nb_acked;             // Set by the target on writes, number of data bytes acknowledged
+    void *initiator;          // Set by the interface to skip the initiator when broadcasting
+  } i2c_transfer_t;
+
+  // Returns false if the transfer could not be done at transaction level
+  typedef bool (i2c_transfer_meth_t)(void *, i2c_transfer_t *req);
+  typedef bool (i2c_transfer_meth_demuxed_t)(void *, i2c_transfer_t *req, int id);
+
+  typedef void (i2c_slave_transfer_meth_t)(void *, i2c_transfer_t *req);
+
+
+
   class i2c_master : public vp::master_port
   {
     friend class i2c_slave;
@@ -54,17 +82,37 @@ namespace vp {
       return sync_meth(this->get_remote_context(), scl, sda);
     }
 
+    // Send a whole transfer, returns false if it must be done with the pins instead
+    inline bool transfer(i2c_transfer_t *req)
+    {
+      if (transfer_meth == NULL)
+        return false;
+
+      req->initiator = this;
+      req->addr_ack = false;
+      req->nb_acked = 0;
+      return transfer_meth(this->get_remote_context(), req);
+    }
+
     void bind_to(vp::port *port, vp::config *config);
 
     inline void set_sync_meth(i2c_slave_sync_meth_t *meth);
 
     inline void set_sync_meth_muxed(i2c_slave_sync_meth_muxed_t *meth, int id);
 
+    // Method called when this device is the target of a transfer from another device
+    inline void set_transfer_meth(i2c_slave_transfer_meth_t *meth);
+
     bool is_bound() { return slave_port != NULL; }
 
   private:
 
     static inline void sync_muxed_stub(i2c_master *_this, int scl, int sda);
+    static inline bool transfer_muxed_stub(i2c_master *_this, i2c_transfer_t *req);
+
+    i2c_transfer_meth_t *transfer_meth = NULL;
+    i2c_transfer_meth_demuxed_t *transfer_meth_mux = NULL;
+    i2c_slave_transfer_meth_t *slave_transfer = NULL;
 
     void (*slave_sync)(void *comp, int scl, int sda);
     void (*slave_sync_mux)(void *comp, int scl, int sda, int id);
@@ -102,9 +150,36 @@ namespace vp {
       slave_sync_meth(this->get_remote_context(), scl, sda);
     }
 
+    // Give a transfer to all the devices bound to this port, except its initiator
+    inline void transfer(i2c_transfer_t *req)
+    {
+      if (next)
+      {
+        next->transfer(req);
+      }
+      if (req->initiator != this->master_port)
+      {
+        slave_transfer_meth(this->get_remote_context(), req);
+      }
+    }
+
+    // Tell if all the devices bound to this port, except the initiator of the request,
+    // handle transfers
+    inline bool is_transfer_supported(i2c_transfer_t *req)
+    {
+      for (i2c_slave *current = this; current; current = current->next)
+      {
+        if (current->master_port != req->initiator && current->slave_transfer_meth == NULL)
+          return false;
+      }
+      return true;
+    }
+
     inline void set_sync_meth(i2c_sync_meth_t *meth);
     inline void set_sync_meth_muxed(i2c_sync_meth_muxed_t *meth, int id);
     inline void set_sync_meth_demuxed(i2c_sync_meth_demuxed_t *meth);
+    inline void set_transfer_meth(i2c_transfer_meth_t *meth);
+    inline void set_transfer_meth_demuxed(i2c_transfer_meth_demuxed_t *meth);
 
     inline void bind_to(vp::port *_port, vp::config *config);
 
@@ -119,12 +194,17 @@ namespace vp {
     void (*sync_meth)(void *comp, int scl, int sda);
     void (*sync_mux_meth)(void *comp, int scl, int sda, int mux);
 
+    i2c_transfer_meth_t *transfer_meth = NULL;
+    i2c_transfer_meth_demuxed_t *transfer_mux_meth = NULL;
+    i2c_slave_transfer_meth_t *slave_transfer_meth = NULL;
+
     static inline void sync_default(i2c_slave *, int scl, int sda);
 
     vp::component *comp_mux;
     int sync_mux;
     int mux_id;
     int demux_id;
+    i2c_master *master_port = NULL;
     i2c_slave *next = NULL;
   };
 
@@ -145,12 +225,18 @@ namespace vp {
 
 
 
+  inline bool i2c_master::transfer_muxed_stub(i2c_master *_this, i2c_transfer_t *req)
+  {
+    return _this->transfer_meth_mux(_this->comp_mux, req, _this->sync_mux);
+  }
+
   inline void i2c_master::bind_to(vp::port *_port, vp::config *config)
   {
     i2c_slave *port = (i2c_slave *)_port;
     if (port->sync_mux_meth == NULL)
     {
       sync_meth = port->sync_meth;
+      transfer_meth = port->transfer_meth;
       this->set_remote_context(port->get_context());
     }
     else
@@ -159,6 +245,11 @@ namespace vp {
       this->set_remote_context(this);
       comp_mux = (vp::component *)port->get_context();
       sync_meth = (i2c_sync_meth_t *)&i2c_master::sync_muxed_stub;
+      if (port->transfer_mux_meth)
+      {
+        transfer_meth_mux = port->transfer_mux_meth;
+        transfer_meth = (i2c_transfer_meth_t *)&i2c_master::transfer_muxed_stub;
+      }
       if (port->demux_id >= 0)
       {
         sync_mux = port->demux_id;
@@ -185,6 +276,11 @@ namespace vp {
     mux_id = id;
   }
 
+  inline void i2c_master::set_transfer_meth(i2c_slave_transfer_meth_t *meth)
+  {
+    slave_transfer = meth;
+  }
+
   inline void i2c_master::sync_default(void *, int scl, int sda)
   {
   }
@@ -210,9 +306,11 @@ namespace vp {
     {
       slave_port::bind_to(_port, config);
       port->slave_port = this;
+      this->master_port = port;
       if (port->slave_sync_mux == NULL)
       {
         this->slave_sync_meth = port->slave_sync;
+        this->slave_transfer_meth = port->slave_transfer;
         this->set_remote_context(port->get_context());
       }
       else
@@ -252,6 +350,16 @@ namespace vp {
     demux_id = 0;
   }
 
+  inline void i2c_slave::set_transfer_meth(i2c_transfer_meth_t *meth)
+  {
+    transfer_meth = meth;
+  }
+
+  inline void i2c_slave::set_transfer_meth_demuxed(i2c_transfer_meth_demuxed_t *meth)
+  {
+    transfer_mux_meth = meth;
+  }
+
   inline void i2c_slave::sync_default(i2c_slave *, int scl, int sda)
   {
   }
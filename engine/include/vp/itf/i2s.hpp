@@ -37,6 +37,27 @@ namespace vp {
 
 
 
+  // Frame-level transfer, exchanging all the slots of a frame in one call instead of
+  // one sync per clock edge. The side generating the clock and word select fills the
+  // words it drives and the frame duration, and the other side fills the words it drives
+  // in return. Words are given as seen on the wire, MSB first, with width bits.
+  // This is optional, the side generating the clock must check that the other side
+  // supports it and otherwise fall back to the bit-level sync.
+  typedef struct
+  {
+    int nb_slots;            // Number of slots of the frame, at most 32
+    int width;               // Number of bits of each slot, at most 32
+    uint32_t *master_data;   // Words driven by the master side, one per slot
+    uint32_t master_valid;   // Bit i is set if the master drives slot i
+    uint32_t *slave_data;    // Words driven by the slave side, one per slot
+    uint32_t slave_valid;    // Bit i is set if the slave drives slot i
+    int64_t duration;        // Duration of the frame in picoseconds
+  } i2s_frame_t;
+
+  typedef void (i2s_frame_meth_t)(void *, i2s_frame_t *frame);
+
+
+
   class i2s_master : public vp::master_port
   {
     friend class i2s_slave;
@@ -47,10 +68,16 @@ namespace vp {
 
     inline void sync(int sck, int ws, int sd, bool full_duplex);
 
+    // Send a whole frame to the slave, returns false if the slave does not support it
+    inline bool sync_frame(i2s_frame_t *frame);
+
+    inline bool has_sync_frame();
+
     void bind_to(vp::port *port, vp::config *config);
 
     inline void set_sync_meth(i2s_sync_meth_t *meth);
     inline void set_sync_meth_muxed(i2s_sync_meth_muxed_t *meth, int id);
+    inline void set_sync_frame_meth(i2s_frame_meth_t *meth);
 
     bool is_bound() { return slave_port != NULL; }
 
@@ -66,6 +93,10 @@ namespace vp {
 
     static inline void sync_default(void *, int sck, int ws, int sd, bool full_duplex);
 
+    // Frame method of this component, given to the slave, and frame method of the slave
+    i2s_frame_meth_t *slave_frame;
+    i2s_frame_meth_t *frame_meth;
+
     vp::component *comp_mux;
     int sync_mux;
     i2s_slave *slave_port = NULL;
@@ -92,8 +123,14 @@ namespace vp {
       slave_sync_meth(this->get_remote_context(), sck, ws, sd, full_duplex);
     }
 
+    // Send a whole frame to the master, returns false if the master does not support it
+    inline bool sync_frame(i2s_frame_t *frame);
+
+    inline bool has_sync_frame();
+
     inline void set_sync_meth(i2s_sync_meth_t *meth);
     inline void set_sync_meth_muxed(i2s_sync_meth_muxed_t *meth, int id);
+    inline void set_sync_frame_meth(i2s_frame_meth_t *meth);
 
     inline void bind_to(vp::port *_port, vp::config *config);
 
@@ -113,11 +150,18 @@ namespace vp {
 
     static inline void sync_default(i2s_slave *, int sck, int ws, int sd, bool full_duplex);
 
+    // Frame method of this component, given to the master, and frame method of the master
+    i2s_frame_meth_t *frame_meth = NULL;
+    i2s_frame_meth_t *slave_frame_meth = NULL;
+
     vp::component *comp_mux;
     int sync_mux;
     int mux_id;
     i2s_master *master_port = NULL;
     i2s_slave *next = NULL;
+    // Set when several masters share this slave. Their data must then be resolved
+    // bit per bit, which is not possible at frame level.
+    bool shared = false;
 
   };
 
@@ -125,6 +169,8 @@ namespace vp {
   inline i2s_master::i2s_master() {
     slave_sync = &i2s_master::sync_default;
     slave_sync_mux = NULL;
+    slave_frame = NULL;
+    frame_meth = NULL;
     this->sd = 2;
   }
 
@@ -142,12 +188,14 @@ namespace vp {
     if (port->sync_mux_meth == NULL)
     {
       sync_meth = port->sync_meth;
+      frame_meth = port->frame_meth;
       set_remote_context(port->get_context());
     }
     else
     {
       sync_meth_mux = port->sync_mux_meth;
       sync_meth = (i2s_sync_meth_t *)&i2s_master::sync_muxed_stub;
+      frame_meth = NULL;
 
       set_remote_context(this);
       comp_mux = (vp::component *)port->get_context();
@@ -167,10 +215,43 @@ namespace vp {
     mux_id = id;
   }
 
+  inline void i2s_master::set_sync_frame_meth(i2s_frame_meth_t *meth)
+  {
+    slave_frame = meth;
+  }
+
   inline void i2s_master::sync_default(void *, int sck, int ws, int sd, bool full_duplex)
   {
   }
 
+  inline bool i2s_master::has_sync_frame()
+  {
+    return this->frame_meth != NULL && this->slave_port != NULL && !this->slave_port->shared;
+  }
+
+  inline bool i2s_master::sync_frame(i2s_frame_t *frame)
+  {
+    if (!this->has_sync_frame())
+      return false;
+
+    this->frame_meth(this->get_remote_context(), frame);
+    return true;
+  }
+
+  inline bool i2s_slave::has_sync_frame()
+  {
+    return this->slave_frame_meth != NULL && !this->shared;
+  }
+
+  inline bool i2s_slave::sync_frame(i2s_frame_t *frame)
+  {
+    if (!this->has_sync_frame())
+      return false;
+
+    this->slave_frame_meth(this->get_remote_context(), frame);
+    return true;
+  }
+
   inline void i2s_master::sync(int sck, int ws, int sd, bool full_duplex)
   {
     this->sd = sd;
@@ -224,6 +305,11 @@ namespace vp {
       slave->bind_to(_port, config);
       slave->next = this->next;
       this->next = slave;
+
+      for (i2s_slave *current = this; current; current = current->next)
+      {
+        current->shared = true;
+      }
     }
     else
     {
@@ -233,6 +319,7 @@ namespace vp {
       if (port->slave_sync_mux == NULL)
       {
         this->slave_sync_meth = port->slave_sync;
+        this->slave_frame_meth = port->slave_frame;
         this->set_remote_context(port->get_context());
       }
       else
@@ -264,6 +351,11 @@ namespace vp {
     mux_id = id;
   }
 
+  inline void i2s_slave::set_sync_frame_meth(i2s_frame_meth_t *meth)
+  {
+    frame_meth = meth;
+  }
+
   inline void i2s_slave::sync_default(i2s_slave *, int sck, int ws, int sd, bool full_duplex)
   {
   }
@@ -28,6 +28,7 @@ namespace vp {
   {
     this->sync_meth = &clock_master::sync_default;
     this->set_frequency_meth = &clock_master::set_frequency_default;
+    this->sync_phase_meth = NULL;
   }
 
   inline void clock_master::bind_to(vp::port *_port, vp::config *config)
@@ -50,6 +51,7 @@ namespace vp {
       {
         sync_meth = port->sync;
         set_frequency_meth = port->set_frequency;
+        sync_phase_meth = port->sync_phase;
         set_remote_context(port->get_context());
       }
       else
@@ -100,6 +102,14 @@ namespace vp {
     return _this->set_frequency_meth_freq_cross((component *)_this->slave_context_for_freq_cross, value);
   }
 
+  inline void clock_master::sync_phase_freq_cross_stub(clock_master *_this, int64_t time, bool value)
+  {
+    // Same as for the other stubs, first synchronize the target engine
+    if (_this->remote_port->get_owner()->get_clock())
+      _this->remote_port->get_owner()->get_clock()->sync();
+    return _this->sync_phase_meth_freq_cross((component *)_this->slave_context_for_freq_cross, time, value);
+  }
+
   inline void clock_master::set_frequency_muxed(clock_master *_this, int64_t frequency)
   {
     return _this->set_frequency_meth_mux(_this->comp_mux, frequency, _this->sync_mux);
@@ -119,6 +129,12 @@ namespace vp {
       this->set_frequency_meth_freq_cross = this->set_frequency_meth;
       this->set_frequency_meth = (void (*)(void *, int64_t))&clock_master::set_frequency_freq_cross_stub;
 
+      if (this->sync_phase_meth)
+      {
+        this->sync_phase_meth_freq_cross = this->sync_phase_meth;
+        this->sync_phase_meth = (void (*)(void *, int64_t, bool))&clock_master::sync_phase_freq_cross_stub;
+      }
+
       this->slave_context_for_freq_cross = this->get_remote_context();
       this->set_remote_context(this);
     }
@@ -168,7 +184,12 @@ namespace vp {
     sync_mux_id = id;
   }
 
-  inline clock_slave::clock_slave() : sync(NULL), sync_mux(NULL), set_frequency(NULL), set_frequency_mux(NULL)
+  inline void clock_slave::set_sync_phase_meth(void (*meth)(void *, int64_t, bool))
+  {
+    sync_phase = meth;
+  }
+
+  inline clock_slave::clock_slave() : sync(NULL), sync_mux(NULL), set_frequency(NULL), set_frequency_mux(NULL), sync_phase(NULL)
   {
     this->sync = &clock_master::sync_default;
     this->set_frequency = &clock_master::set_frequency_default;
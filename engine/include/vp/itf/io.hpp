@@ -43,8 +43,39 @@ namespace vp {
     IO_REQ_FLAGS_DEBUG = (1<<0)
   } io_req_flags_e;
 
+  // Size of the payload, which is only allocated when it is used
   #define IO_REQ_PAYLOAD_SIZE 64
+
+  // Maximum number of arguments which can be pushed on a request. It can be reduced at
+  // compile-time to get smaller requests if the platform does not need many of them.
+  #ifndef IO_REQ_NB_ARGS
   #define IO_REQ_NB_ARGS 16
+  #endif
+
+  // Chunk of a burst, with its address relative to the request address
+  typedef struct
+  {
+    uint64_t offset;
+    uint64_t size;
+  } io_req_chunk_t;
+
+  // Optional descriptor which can be attached to a request to describe a burst made of
+  // several chunks, so that strided or scatter-gather transfers can cross the interconnect
+  // as one request instead of one request per chunk.
+  // The chunks are either given as a list, or are count chunks of the request size,
+  // each one stride bytes after the previous one. Their addresses are relative to the
+  // request address so that components remapping the request do not have to update the
+  // descriptor, and the request data is the concatenation of all the chunks.
+  // Bursts must only be sent to components which handle them, which are so far the
+  // router, the interleaver, the converter and the memory.
+  class io_req_burst
+  {
+  public:
+    uint64_t stride = 0;
+    int count = 1;
+    io_req_chunk_t *chunks = NULL;
+    int nb_chunks = 0;
+  };
 
   typedef io_req_status_e (io_req_meth_t)(void *, io_req *);
   typedef io_req_status_e (io_req_meth_muxed_t)(void *, io_req *, int id);
@@ -66,6 +97,12 @@ namespace vp {
       init();
     }
 
+    ~io_req() { delete[] this->payload; }
+
+    // Requests own their payload and must not be copied
+    io_req(const io_req &) = delete;
+    io_req &operator=(const io_req &) = delete;
+
     io_slave *get_resp_port() { return resp_port;}
     void set_next(io_req *req) { next = req; }
     io_req *get_next() { return next; }
@@ -98,7 +135,12 @@ namespace vp {
     void set_data(uint8_t *data) { this->data = data; }
 
     inline int get_payload_size() { return IO_REQ_PAYLOAD_SIZE; }
-    inline uint8_t *get_payload() { return payload; }
+    inline uint8_t *get_payload()
+    {
+      if (this->payload == NULL)
+        this->payload = new uint8_t[IO_REQ_PAYLOAD_SIZE];
+      return this->payload;
+    }
 
     inline int get_nb_args() { return IO_REQ_NB_ARGS; }
     inline void **get_args() { return args; }
@@ -106,6 +148,21 @@ namespace vp {
     inline void set_int(int index, int value) { *(int *)&get_args()[index] = value; }
     inline int get_int(int index) { return *(int *)&get_args()[index]; }
 
+    inline void set_burst(io_req_burst *burst) { this->burst = burst; }
+    inline io_req_burst *get_burst() { return this->burst; }
+
+    // Number of chunks of the request, 1 if it is not a burst
+    inline int get_nb_chunks();
+
+    // Absolute address and size of a chunk of the request
+    inline void get_chunk(int index, uint64_t *addr, uint64_t *size);
+
+    // Total number of bytes transferred by the request
+    inline uint64_t get_burst_size();
+
+    // Number of bytes between the request address and the end of the last chunk
+    inline uint64_t get_burst_extent();
+
     inline bool is_debug() { return this->flags & IO_REQ_FLAGS_DEBUG; }
     inline void set_debug(bool debug)
     {
@@ -126,25 +183,26 @@ namespace vp {
     inline void **arg_get_last() { return &args[current_arg]; }
 
     inline void prepare() { latency = 0; duration=0; flags=0; }
-    inline void init() { prepare(); current_arg=0; }
+    inline void init() { prepare(); current_arg=0; burst=NULL; }
 
-    uint64_t flags;
     uint64_t addr;
     uint8_t *data;
     uint64_t size;
     uint64_t actual_size;
-    bool is_write;
-    io_req_status_e status;
     io_slave *resp_port;
+    uint32_t flags;
+    io_req_status_e status;
+    bool is_write;
 
 
   private:
+    int current_arg = 0;
     io_req *next;
     int64_t latency;
     int64_t duration;
-    uint8_t payload[IO_REQ_PAYLOAD_SIZE];
+    uint8_t *payload = NULL;
+    io_req_burst *burst = NULL;
     void *args[IO_REQ_NB_ARGS];
-    int current_arg = 0;
   };
 
 
@@ -162,9 +220,13 @@ namespace vp {
      */
 
     // Can be called to allocate an IO request.
+    // Requests are taken from a pool owned by this port, and only allocated when the
+    // pool is empty.
     inline io_req *req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write);
 
     // Can be called to deallocate an IO request.
+    // The request is put back into the pool of this port, it should be the port which
+    // allocated it so that the pools stay balanced.
     inline void req_del(io_req *req);
 
     // Return if this master port is bound.
@@ -296,6 +358,9 @@ namespace vp {
     // For that, a slave port is associated to each master port and can
     // be used by the real slave port to reply to a specific master port.
     io_slave *slave_port = NULL;
+
+    // Pool of free requests, chained with their next field
+    io_req *free_reqs = NULL;
   };
 
 
@@ -474,8 +539,19 @@ namespace vp {
 
   inline io_req *io_master::req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
   {
-    // For now we allocate new requests but this would be better to manage a pool of requests
-    io_req *req = new io_req(addr, data, size, is_write);
+    io_req *req = this->free_reqs;
+    if (req == NULL)
+    {
+      return new io_req(addr, data, size, is_write);
+    }
+
+    this->free_reqs = req->next;
+
+    req->addr = addr;
+    req->data = data;
+    req->size = size;
+    req->is_write = is_write;
+    req->init();
 
     return req;
   }
@@ -484,7 +560,8 @@ namespace vp {
 
   inline void io_master::req_del(io_req *req)
   {
-    delete req;
+    req->next = this->free_reqs;
+    this->free_reqs = req;
   }
 
 
@@ -699,6 +776,66 @@ namespace vp {
     }
   }
 
+  inline int io_req::get_nb_chunks()
+  {
+    if (this->burst == NULL)
+      return 1;
+    return this->burst->chunks ? this->burst->nb_chunks : this->burst->count;
+  }
+
+  inline void io_req::get_chunk(int index, uint64_t *addr, uint64_t *size)
+  {
+    if (this->burst == NULL)
+    {
+      *addr = this->addr;
+      *size = this->size;
+    }
+    else if (this->burst->chunks)
+    {
+      *addr = this->addr + this->burst->chunks[index].offset;
+      *size = this->burst->chunks[index].size;
+    }
+    else
+    {
+      *addr = this->addr + index * this->burst->stride;
+      *size = this->size;
+    }
+  }
+
+  inline uint64_t io_req::get_burst_size()
+  {
+    if (this->burst == NULL)
+      return this->size;
+
+    if (this->burst->chunks == NULL)
+      return this->size * this->burst->count;
+
+    uint64_t size = 0;
+    for (int i=0; i<this->burst->nb_chunks; i++)
+    {
+      size += this->burst->chunks[i].size;
+    }
+    return size;
+  }
+
+  inline uint64_t io_req::get_burst_extent()
+  {
+    if (this->burst == NULL)
+      return this->size;
+
+    if (this->burst->chunks == NULL)
+      return this->burst->count > 0 ? (this->burst->count - 1) * this->burst->stride + this->size : 0;
+
+    uint64_t extent = 0;
+    for (int i=0; i<this->burst->nb_chunks; i++)
+    {
+      uint64_t end = this->burst->chunks[i].offset + this->burst->chunks[i].size;
+      if (end > extent)
+        extent = end;
+    }
+    return extent;
+  }
+
   inline void io_req::save()
   {
     arg_push((void *)(long)this->addr);
@@ -43,6 +43,28 @@ namespace vp {
 
 
 
+  // Burst-level transfer, covering a whole SPI transaction, from chip select activation
+  // to deactivation. This can replace the edge-level sync when the slave supports it.
+  // The command is always sent on one line, while the address and the data are sent on
+  // the specified number of lines.
+  typedef struct
+  {
+    int cs;                // Chip select of the slave
+    uint8_t cmd;           // Command opcode
+    int addr_size;         // Number of address bytes, 0 if there is no address phase
+    uint32_t addr;
+    int dummy_cycles;      // SCK cycles between the address and the data, including mode bits
+    int lines;             // Number of lines used for address and data (1, 2 or 4)
+    bool is_write;         // Data is sent from master to slave if true
+    uint8_t *data;         // Data to be sent, or filled by the slave for reads
+    int size;              // Data size in bytes
+    int64_t duration;      // Duration of the whole transfer in picoseconds
+  } qspim_burst_t;
+
+  typedef void (qspim_burst_meth_t)(void *, qspim_burst_t *burst);
+
+
+
   class qspim_master : public vp::master_port
   {
     friend class qspim_slave;
@@ -61,6 +83,19 @@ namespace vp {
       return cs_sync_meth(this->get_remote_context(), cs, active);
     }
 
+    // Send a whole transaction at once. This returns false if the slave does not support
+    // it, in which case the transaction must be sent edge by edge with sync and cs_sync.
+    inline bool burst(qspim_burst_t *burst)
+    {
+      if (burst_meth == NULL)
+        return false;
+
+      burst_meth(this->get_remote_context(), burst);
+      return true;
+    }
+
+    inline bool has_burst() { return burst_meth != NULL; }
+
     void bind_to(vp::port *port, vp::config *config);
 
     inline void set_sync_meth(qspim_slave_sync_meth_t *meth);
@@ -81,6 +116,7 @@ namespace vp {
     void (*sync_meth_mux)(void *, int sck, int data_0, int data_1, int data_2, int data_3, int mask, int mux);
     void (*cs_sync_meth)(void *, int cs, int active);
     void (*cs_sync_meth_mux)(void *, int cs, int active, int mux);
+    qspim_burst_meth_t *burst_meth;
 
     static inline void sync_default(void *, int sck, int data_0, int data_1, int data_2, int data_3, int mask);
 
@@ -114,6 +150,10 @@ namespace vp {
     inline void set_cs_sync_meth(qspim_cs_sync_meth_t *meth);
     inline void set_cs_sync_meth_muxed(qspim_cs_sync_meth_muxed_t *meth, int id);
 
+    // Declare that whole transactions can be received at once. Protocol checkers which
+    // need to see every edge should not set it.
+    inline void set_burst_meth(qspim_burst_meth_t *meth);
+
     inline void bind_to(vp::port *_port, vp::config *config);
 
   private:
@@ -128,6 +168,7 @@ namespace vp {
     void (*sync_mux_meth)(void *comp, int sck, int data_0, int data_1, int data_2, int data_3, int mask, int mux);
     void (*cs_sync)(void *comp, int cs, int active);
     void (*cs_sync_mux)(void *comp, int cs, int active, int mux);
+    qspim_burst_meth_t *burst;
 
     static inline void sync_default(qspim_slave *, int sck, int data_0, int data_1, int data_2, int data_3, int mask);
     static inline void cs_sync_default(qspim_slave *, int cs, int active);
@@ -143,6 +184,7 @@ namespace vp {
   inline qspim_master::qspim_master() {
     slave_sync = &qspim_master::sync_default;
     slave_sync_mux = NULL;
+    burst_meth = NULL;
   }
 
 
@@ -169,6 +211,7 @@ namespace vp {
     {
       sync_meth = port->sync_meth;
       cs_sync_meth = port->cs_sync;
+      burst_meth = port->burst;
       this->set_remote_context(port->get_context());
     }
     else
@@ -179,6 +222,9 @@ namespace vp {
       cs_sync_meth_mux = port->cs_sync_mux;
       cs_sync_meth = (qspim_cs_sync_meth_t *)&qspim_master::cs_sync_muxed_stub;
 
+      // Bursts are not supported on multiplexed ports
+      burst_meth = NULL;
+
       this->set_remote_context(this);
       comp_mux = (vp::component *)port->get_context();
       sync_mux = port->mux_id;
@@ -227,7 +273,7 @@ namespace vp {
     }
   }
 
-  inline qspim_slave::qspim_slave() : sync_meth(NULL), sync_mux_meth(NULL) {
+  inline qspim_slave::qspim_slave() : sync_meth(NULL), sync_mux_meth(NULL), burst(NULL) {
     sync_meth = (qspim_sync_meth_t *)&qspim_slave::sync_default;
     cs_sync = (qspim_cs_sync_meth_t *)&qspim_slave::cs_sync_default;
   }
@@ -258,6 +304,11 @@ namespace vp {
     mux_id = id;
   }
 
+  inline void qspim_slave::set_burst_meth(qspim_burst_meth_t *meth)
+  {
+    burst = meth;
+  }
+
   inline void qspim_slave::sync_default(qspim_slave *, int sck, int data_0, int data_1, int data_2, int data_3, int mask)
   {
   }
@@ -38,6 +38,12 @@ namespace vp {
   typedef void (uart_sync_full_meth_t)(void *, int data, int sck, int rtr, unsigned int mask);
   typedef void (uart_sync_full_meth_muxed_t)(void *, int data, int sck, int rtr, unsigned int mask, int id);
 
+  // Transaction-level transfer of several frames at once. The frames are delivered when
+  // the first start bit would be sent, and duration gives in picoseconds the time during
+  // which the line is busy with them, including start, parity and stop bits.
+  // The line is idle (1) before and after the transfer.
+  typedef void (uart_sync_buffer_meth_t)(void *, uint8_t *data, int size, int64_t duration);
+
 
 
   class uart_master : public vp::master_port
@@ -61,6 +67,24 @@ namespace vp {
       return this->sync(data);
     }
 
+    // Send whole frames instead of bits. This returns false if the slave does not support
+    // it, in which case the frames must be sent bit by bit with sync.
+    inline bool sync_buffer(uint8_t *data, int size, int64_t duration)
+    {
+      if (sync_buffer_meth == NULL)
+        return false;
+
+      sync_buffer_meth(this->get_remote_context(), data, size, duration);
+      return true;
+    }
+
+    inline bool sync_byte(uint8_t data, int64_t duration)
+    {
+      return this->sync_buffer(&data, 1, duration);
+    }
+
+    inline bool has_sync_buffer() { return sync_buffer_meth != NULL; }
+
     void bind_to(vp::port *port, vp::config *config);
 
     inline void set_sync_meth(uart_sync_meth_t *meth);
@@ -69,6 +93,10 @@ namespace vp {
     inline void set_sync_full_meth(uart_sync_full_meth_t *meth);
     inline void set_sync_full_meth_muxed(uart_sync_full_meth_muxed_t *meth, int id);
 
+    // Declare that frames sent by the slave can be received at transaction level.
+    // This should not be set when the component needs to see every bit.
+    inline void set_sync_buffer_meth(uart_sync_buffer_meth_t *meth);
+
     bool is_bound() { return slave_port != NULL; }
 
   private:
@@ -82,12 +110,16 @@ namespace vp {
     void (*slave_sync_full)(void *comp, int data, int sck, int rtr, unsigned int mask);
     void (*slave_sync_full_mux)(void *comp, int data, int sck, int rtr, unsigned int mask, int mux);
 
+    uart_sync_buffer_meth_t *slave_sync_buffer;
+
     void (*sync_meth)(void *, int data);
     void (*sync_meth_mux)(void *, int data, int mux);
 
     void (*sync_full_meth)(void *, int data, int sck, int rtr, unsigned int mask);
     void (*sync_full_meth_mux)(void *, int data, int sck, int rtr, unsigned int mask, int mux);
 
+    uart_sync_buffer_meth_t *sync_buffer_meth;
+
     static inline void sync_default(void *, int data);
 
     vp::component *comp_mux;
@@ -125,12 +157,34 @@ namespace vp {
       }
     }
 
+    // Send whole frames instead of bits. This returns false if the master does not support
+    // it, in which case the frames must be sent bit by bit with sync.
+    inline bool sync_buffer(uint8_t *data, int size, int64_t duration)
+    {
+      if (slave_sync_buffer_meth == NULL)
+        return false;
+
+      slave_sync_buffer_meth(this->get_remote_context(), data, size, duration);
+      return true;
+    }
+
+    inline bool sync_byte(uint8_t data, int64_t duration)
+    {
+      return this->sync_buffer(&data, 1, duration);
+    }
+
+    inline bool has_sync_buffer() { return slave_sync_buffer_meth != NULL; }
+
     inline void set_sync_meth(uart_sync_meth_t *meth);
     inline void set_sync_meth_muxed(uart_sync_meth_muxed_t *meth, int id);
 
     inline void set_sync_full_meth(uart_sync_full_meth_t *meth);
     inline void set_sync_full_meth_muxed(uart_sync_full_meth_muxed_t *meth, int id);
 
+    // Declare that frames sent by the master can be received at transaction level.
+    // This should not be set when the component needs to see every bit.
+    inline void set_sync_buffer_meth(uart_sync_buffer_meth_t *meth);
+
     inline void bind_to(vp::port *_port, vp::config *config);
 
   private:
@@ -144,12 +198,16 @@ namespace vp {
     void (*slave_sync_full_meth)(void *, int data, int sck, int rtr, unsigned int mask);
     void (*slave_sync_full_meth_mux)(void *, int data, int sck, int rtr, unsigned int mask, int mux);
 
+    uart_sync_buffer_meth_t *slave_sync_buffer_meth;
+
     void (*sync_meth)(void *comp, int data);
     void (*sync_mux_meth)(void *comp, int data, int mux);
 
     void (*sync_full_meth)(void *comp, int data, int sck, int rtr, unsigned int mask);
     void (*sync_full_mux_meth)(void *comp, int data, int sck, int rtr, unsigned int mask, int mux);
 
+    uart_sync_buffer_meth_t *sync_buffer_meth;
+
     static inline void sync_default(uart_slave *, int data);
 
     vp::component *comp_mux;
@@ -164,6 +222,8 @@ namespace vp {
     slave_sync_mux = NULL;
     slave_sync_full = NULL;
     slave_sync_full_mux = NULL;
+    slave_sync_buffer = NULL;
+    sync_buffer_meth = NULL;
   }
 
 
@@ -186,6 +246,7 @@ namespace vp {
     {
       sync_meth = port->sync_meth;
       sync_full_meth = port->sync_full_meth;
+      sync_buffer_meth = port->sync_buffer_meth;
       set_remote_context(port->get_context());
     }
     else
@@ -194,6 +255,8 @@ namespace vp {
       sync_meth = (uart_sync_meth_t *)&uart_master::sync_muxed_stub;
       sync_full_meth_mux = port->sync_full_mux_meth;
       sync_full_meth = (uart_sync_full_meth_t *)&uart_master::sync_full_muxed_stub;
+      // Transaction-level transfers are not supported on multiplexed ports
+      sync_buffer_meth = NULL;
 
       set_remote_context(this);
       comp_mux = (vp::component *)port->get_context();
@@ -225,6 +288,11 @@ namespace vp {
     mux_id = id;
   }
 
+  inline void uart_master::set_sync_buffer_meth(uart_sync_buffer_meth_t *meth)
+  {
+    slave_sync_buffer = meth;
+  }
+
   inline void uart_master::sync_default(void *, int data)
   {
   }
@@ -248,6 +316,7 @@ namespace vp {
     {
       this->slave_sync_meth = port->slave_sync;
       this->slave_sync_full_meth = port->slave_sync_full;
+      this->slave_sync_buffer_meth = port->slave_sync_buffer;
       this->set_remote_context(port->get_context());
     }
     else
@@ -261,13 +330,15 @@ namespace vp {
       else
         this->slave_sync_full_meth = (uart_sync_full_meth_t *)&uart_slave::sync_full_muxed_stub;
 
+      this->slave_sync_buffer_meth = NULL;
+
       set_remote_context(this);
       comp_mux = (vp::component *)port->get_context();
       sync_mux = port->mux_id;
     }
   }
 
-  inline uart_slave::uart_slave() : sync_meth(NULL), sync_mux_meth(NULL), sync_full_meth(NULL), sync_full_mux_meth(NULL) {
+  inline uart_slave::uart_slave() : slave_sync_buffer_meth(NULL), sync_meth(NULL), sync_mux_meth(NULL), sync_full_meth(NULL), sync_full_mux_meth(NULL), sync_buffer_meth(NULL) {
     sync_meth = (uart_sync_meth_t *)&uart_slave::sync_default;
     sync_full_meth = NULL;
   }
@@ -302,6 +373,11 @@ namespace vp {
     mux_id = id;
   }
 
+  inline void uart_slave::set_sync_buffer_meth(uart_sync_buffer_meth_t *meth)
+  {
+    sync_buffer_meth = meth;
+  }
+
 
 
 };
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __VP_MEM_FILE_HPP__
+#define __VP_MEM_FILE_HPP__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace vp {
+
+  // Map a file into the process to back the content of a memory or flash array of the
+  // specified size, instead of reading it into a private buffer.
+  //
+  // In copy-on-write mode, the file is mapped privately, so that the pages which are
+  // never written are shared through the page cache between all the simulations using
+  // the same file, and the writes stay private to the simulation. The part of the array
+  // which is not covered by the file is filled with the specified value.
+  //
+  // In writeback mode, the file is mapped shared and extended to the array size if
+  // needed, so that the writes to the array end up in the file.
+  //
+  // Returns NULL and sets errno in case of error.
+  uint8_t *mem_file_map(std::string path, size_t size, uint8_t fill, bool writeback);
+
+  // Unmap an array returned by mem_file_map
+  void mem_file_unmap(uint8_t *data, size_t size);
+
+};
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __VP_PCM_FILE_HPP__
+#define __VP_PCM_FILE_HPP__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+namespace vp {
+
+  // Sequential reader of raw sample files, used by the models streaming audio stimuli.
+  // The file is mapped into the process so that each sample is read with a copy from
+  // memory instead of one stdio call.
+  // In wrap mode, reading goes back to the beginning of the file once the end is reached,
+  // so that a short stimuli can feed a long simulation.
+  class Pcm_file_reader
+  {
+  public:
+    Pcm_file_reader(std::string path, bool wrap);
+    ~Pcm_file_reader();
+
+    // Returns false if the file could not be opened, errno is then set
+    bool is_open() { return this->opened; }
+
+    // Read the next sample of size bytes, returns false if there is no more sample
+    inline bool read(void *value, int size);
+
+  private:
+    uint8_t *data = NULL;
+    size_t size = 0;
+    size_t offset = 0;
+    bool wrap;
+    bool opened = false;
+  };
+
+  // Open a raw sample file for writing, with a large stdio buffer so that samples
+  // written one at a time end up in few system calls. The remaining samples are written
+  // by fclose, or when the process exits.
+  // Returns NULL and sets errno in case of error.
+  FILE *pcm_file_open_writer(std::string path);
+
+};
+
+inline bool vp::Pcm_file_reader::read(void *value, int size)
+{
+  if (this->offset + size > this->size)
+  {
+    if (!this->wrap || (size_t)size > this->size)
+      return false;
+
+    this->offset = 0;
+  }
+
+  memcpy(value, this->data + this->offset, size);
+  this->offset += size;
+
+  return true;
+}
+
+#endif
@@ -86,6 +86,13 @@ public:
     inline void retain() { retain_count++; }
     inline void release() { retain_count--; }
 
+#ifdef __VP_USE_SYSTEMC
+    // Called by components which forward a transaction to SystemC, so that the engine
+    // stays synchronized with SystemC time until the transaction is released.
+    inline void systemc_sync_retain() { systemc_sync_count++; sync_event.notify(); }
+    inline void systemc_sync_release() { systemc_sync_count--; }
+#endif
+
     inline void fatal(const char *fmt, ...);
 
     inline void update(int64_t time);
@@ -117,6 +124,12 @@ private:
 #ifdef __VP_USE_SYSTEMC
     sc_event sync_event;
     bool started = false;
+    // The engine can run ahead of SystemC time up to this amount of picoseconds,
+    // as long as no transaction is in flight with SystemC. 0 means lock-step.
+    int64_t systemc_quantum = 0;
+    int systemc_sync_count = 0;
+
+    inline bool systemc_can_run_ahead(int64_t time);
 #endif
 
 private:
@@ -165,6 +178,14 @@ protected:
     bool is_enqueued = false;
 };
 
+#ifdef __VP_USE_SYSTEMC
+inline bool vp::time_engine::systemc_can_run_ahead(int64_t time)
+{
+    return this->systemc_sync_count == 0 &&
+        time - (int64_t)sc_time_stamp().to_double() <= this->systemc_quantum;
+}
+#endif
+
 // This can be called from anywhere so just propagate the stop request
 // to the main python thread which will take care of stopping the engine.
 inline void vp::time_engine::stop_engine(int status, bool force, bool no_retain)
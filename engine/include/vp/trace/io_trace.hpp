@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __VP_TRACE_IO_TRACE_HPP__
+#define __VP_TRACE_IO_TRACE_HPP__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+
+namespace vp {
+
+  // Binary stream of memory accesses, used to record the accesses done by a master
+  // (e.g. core data and fetch ports) and to replay them later on without simulating
+  // the master, for example to explore cache or interconnect configurations.
+  //
+  // The file is made of a header followed by LZ4-compressed blocks of records.
+  // Each block is preceded by its uncompressed and compressed sizes.
+
+  #define IO_TRACE_MAGIC   "GVIOTRC1"
+
+  typedef enum
+  {
+    IO_TRACE_FLAGS_WRITE = (1<<0),
+    IO_TRACE_FLAGS_FETCH = (1<<1)
+  } io_trace_flags_e;
+
+  typedef struct
+  {
+    int64_t timestamp;      // Time in ps when the request was issued
+    uint64_t addr;          // Address of the access
+    int64_t latency;        // Latency in cycles returned by the target, including duration
+    uint32_t size;          // Size in bytes of the access
+    uint16_t master;        // Identifier of the master, e.g. the core hart ID
+    uint8_t flags;          // See io_trace_flags_e
+    uint8_t status;         // Status returned by the target (vp::io_req_status_e)
+  } io_trace_record_t;
+
+  class Io_trace_writer
+  {
+  public:
+    Io_trace_writer(std::string path, int block_size=4096);
+    ~Io_trace_writer();
+
+    // Return true if the file was successfully opened
+    bool is_open() { return this->file != NULL; }
+
+    inline void dump(io_trace_record_t *record);
+    void flush();
+    void close();
+
+  private:
+    FILE *file = NULL;
+    io_trace_record_t *records;
+    char *compressed;
+    int block_size;
+    int nb_records = 0;
+  };
+
+  class Io_trace_reader
+  {
+  public:
+    Io_trace_reader(std::string path);
+    ~Io_trace_reader();
+
+    // Return true if the file was successfully opened and has a valid header
+    bool is_open() { return this->file != NULL; }
+
+    // Return the next record or NULL if the end of the stream is reached
+    io_trace_record_t *next();
+
+  private:
+    bool read_block();
+
+    FILE *file = NULL;
+    io_trace_record_t *records = NULL;
+    char *compressed = NULL;
+    int buffer_size = 0;
+    int nb_records = 0;
+    int current = 0;
+  };
+
+};
+
+inline void vp::Io_trace_writer::dump(vp::io_trace_record_t *record)
+{
+  this->records[this->nb_records++] = *record;
+  if (this->nb_records == this->block_size)
+  {
+    this->flush();
+  }
+}
+
+#endif
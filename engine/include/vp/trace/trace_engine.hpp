@@ -79,6 +79,10 @@ namespace vp {
     virtual void add_exclude_trace_path(int events, std::string path) {}
     virtual void check_traces() {}
 
+    // Tell if an event trace registered with this full path would be active. This can be used
+    // by components having many event traces to only create the ones which are selected.
+    virtual bool is_event_path_active(std::string path) { return true; }
+
     inline bool get_werror() { return this->werror; }
     inline bool is_warning_active(vp::trace::warning_type_e type) { return this->active_warnings[type]; }
 
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#include "vp/mem_file.hpp"
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+uint8_t *vp::mem_file_map(std::string path, size_t size, uint8_t fill, bool writeback)
+{
+  struct stat file_stat;
+  uint8_t *data;
+  int err;
+
+  int fd = open(path.c_str(), writeback ? O_RDWR | O_CREAT : O_RDONLY, 0600);
+  if (fd < 0)
+    return NULL;
+
+  if (fstat(fd, &file_stat) < 0)
+    goto error;
+
+  if (writeback)
+  {
+    size_t file_size = file_stat.st_size;
+
+    if (file_size < size && ftruncate(fd, size) < 0)
+      goto error;
+
+    data = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+      goto error;
+
+    // Extend the file with the array default value
+    if (file_size < size)
+      memset(data + file_size, fill, size - file_size);
+  }
+  else
+  {
+    size_t file_size = file_stat.st_size < (off_t)size ? file_stat.st_size : size;
+
+    // Reserve the whole array with anonymous memory, which is only committed when it is
+    // touched, and then map the file over its beginning. This way the part of the array
+    // after the end of the file can be accessed without getting a bus error.
+    data = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED)
+      goto error;
+
+    if (file_size && mmap(data, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+      fd, 0) == MAP_FAILED)
+    {
+      err = errno;
+      munmap(data, size);
+      errno = err;
+      goto error;
+    }
+
+    if (file_size < size)
+      memset(data + file_size, fill, size - file_size);
+  }
+
+  // The mapping stays valid after the file is closed
+  close(fd);
+
+  return data;
+
+error:
+  err = errno;
+  close(fd);
+  errno = err;
+  return NULL;
+}
+
+void vp::mem_file_unmap(uint8_t *data, size_t size)
+{
+  munmap(data, size);
+}
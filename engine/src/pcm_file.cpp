@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#include "vp/pcm_file.hpp"
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#define PCM_FILE_WRITER_BUFFER_SIZE (1 << 20)
+
+vp::Pcm_file_reader::Pcm_file_reader(std::string path, bool wrap)
+: wrap(wrap)
+{
+  struct stat file_stat;
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  if (fstat(fd, &file_stat) < 0)
+  {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return;
+  }
+
+  // An empty file can not be mapped, it is just seen as a file without any sample
+  if (file_stat.st_size > 0)
+  {
+    void *data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      int err = errno;
+      close(fd);
+      errno = err;
+      return;
+    }
+
+    // Samples are always read in order
+    madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+
+    this->data = (uint8_t *)data;
+    this->size = file_stat.st_size;
+  }
+
+  // The mapping stays valid after the file is closed
+  close(fd);
+
+  this->opened = true;
+}
+
+vp::Pcm_file_reader::~Pcm_file_reader()
+{
+  if (this->data)
+    munmap(this->data, this->size);
+}
+
+FILE *vp::pcm_file_open_writer(std::string path)
+{
+  FILE *file = fopen(path.c_str(), "w");
+  if (file == NULL)
+    return NULL;
+
+  setvbuf(file, NULL, _IOFBF, PCM_FILE_WRITER_BUFFER_SIZE);
+
+  return file;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#include "vp/trace/io_trace.hpp"
+#include <string.h>
+#include "fst/lz4.h"
+
+vp::Io_trace_writer::Io_trace_writer(std::string path, int block_size)
+: block_size(block_size)
+{
+  this->records = new io_trace_record_t[block_size];
+  this->compressed = new char[LZ4_compressBound(block_size * sizeof(io_trace_record_t))];
+
+  this->file = fopen(path.c_str(), "w");
+  if (this->file == NULL)
+    return;
+
+  if (fwrite(IO_TRACE_MAGIC, strlen(IO_TRACE_MAGIC), 1, this->file) != 1)
+  {
+    fclose(this->file);
+    this->file = NULL;
+  }
+}
+
+
+
+vp::Io_trace_writer::~Io_trace_writer()
+{
+  this->close();
+  delete[] this->records;
+  delete[] this->compressed;
+}
+
+
+
+void vp::Io_trace_writer::flush()
+{
+  if (this->file == NULL || this->nb_records == 0)
+    return;
+
+  uint32_t sizes[2];
+  sizes[0] = this->nb_records * sizeof(io_trace_record_t);
+  sizes[1] = LZ4_compress_default((char *)this->records, this->compressed, sizes[0],
+    LZ4_compressBound(this->block_size * sizeof(io_trace_record_t)));
+
+  this->nb_records = 0;
+
+  if (sizes[1] == 0 || fwrite(sizes, sizeof(sizes), 1, this->file) != 1 ||
+    fwrite(this->compressed, sizes[1], 1, this->file) != 1)
+  {
+    fclose(this->file);
+    this->file = NULL;
+  }
+}
+
+
+
+void vp::Io_trace_writer::close()
+{
+  if (this->file)
+  {
+    this->flush();
+    if (this->file)
+    {
+      fclose(this->file);
+      this->file = NULL;
+    }
+  }
+}
+
+
+
+vp::Io_trace_reader::Io_trace_reader(std::string path)
+{
+  char magic[sizeof(IO_TRACE_MAGIC)] = {0};
+
+  this->file = fopen(path.c_str(), "r");
+  if (this->file == NULL)
+    return;
+
+  if (fread(magic, strlen(IO_TRACE_MAGIC), 1, this->file) != 1 || strcmp(magic, IO_TRACE_MAGIC) != 0)
+  {
+    fclose(this->file);
+    this->file = NULL;
+  }
+}
+
+
+
+vp::Io_trace_reader::~Io_trace_reader()
+{
+  if (this->file)
+    fclose(this->file);
+  delete[] this->records;
+  delete[] this->compressed;
+}
+
+
+
+bool vp::Io_trace_reader::read_block()
+{
+  uint32_t sizes[2];
+
+  if (fread(sizes, sizeof(sizes), 1, this->file) != 1)
+    return false;
+
+  // Blocks are usually all the same size, only reallocate when a bigger one is found
+  if ((int)sizes[0] > this->buffer_size)
+  {
+    delete[] this->records;
+    delete[] this->compressed;
+    this->buffer_size = sizes[0];
+    this->records = new io_trace_record_t[sizes[0] / sizeof(io_trace_record_t)];
+    this->compressed = new char[LZ4_compressBound(sizes[0])];
+  }
+
+  if ((int)sizes[1] > LZ4_compressBound(this->buffer_size) ||
+    fread(this->compressed, sizes[1], 1, this->file) != 1)
+    return false;
+
+  int size = LZ4_decompress_safe(this->compressed, (char *)this->records, sizes[1], sizes[0]);
+  if (size < 0)
+    return false;
+
+  this->nb_records = size / sizeof(io_trace_record_t);
+  this->current = 0;
+
+  return this->nb_records != 0;
+}
+
+
+
+vp::io_trace_record_t *vp::Io_trace_reader::next()
+{
+  if (this->file == NULL)
+    return NULL;
+
+  if (this->current == this->nb_records && !this->read_block())
+    return NULL;
+
+  return &this->records[this->current++];
+}
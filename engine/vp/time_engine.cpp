@@ -288,6 +288,12 @@ void vp::time_engine::start()
     bool sa_mode = this->get_js_config()->get_child_bool("**/gvsoc/sa-mode");
     this->no_exit = item_conf != NULL && item_conf->get_bool();
 
+#ifdef __VP_USE_SYSTEMC
+    js::config *quantum_conf = this->get_js_config()->get("**/gvsoc/systemc_quantum");
+    if (quantum_conf != NULL)
+        this->systemc_quantum = quantum_conf->get_int();
+#endif
+
     if (this->no_exit)
     {
         // In case the vp is connected to an external bridge, prevent the platform
@@ -413,6 +419,11 @@ void vp::time_engine::run_loop()
                     break;
 #else
                 vp_assert(current->next_event_time >= (int64_t)sc_time_stamp().to_double(), NULL, "SystemC time is after vp time\n");
+                // Let the engine run ahead of SystemC time within the quantum, SystemC
+                // will catch up once the quantum is exceeded or a transaction is sent
+                if (this->systemc_can_run_ahead(current->next_event_time))
+                    break;
+
                 wait(current->next_event_time - (int64_t)sc_time_stamp().to_double(), SC_PS, sync_event);
 
                 int64_t current_sc_time = (int64_t)sc_time_stamp().to_double();
@@ -504,6 +515,9 @@ void vp::time_engine::run_loop()
                         }
 #else
                         vp_assert(first_client->next_event_time >= (int64_t)sc_time_stamp().to_double(), NULL, "SystemC time is after vp time\n");
+                        if (this->systemc_can_run_ahead(first_client->next_event_time))
+                            break;
+
                         wait(first_client->next_event_time - (int64_t)sc_time_stamp().to_double(), SC_PS, sync_event);
 
                         int64_t current_sc_time = (int64_t)sc_time_stamp().to_double();
@@ -70,6 +70,8 @@ public:
 
     void check_traces();
 
+    bool is_event_path_active(std::string path);
+
     int get_max_path_len() { return max_path_len; }
 
     int exchange_max_path_len(int max_len)
@@ -267,6 +269,41 @@ void trace_domain::check_traces()
     }
 }
 
+bool trace_domain::is_event_path_active(std::string full_path)
+{
+    bool active = false;
+
+    auto it = this->active_events.find(full_path);
+    if (it != this->active_events.end() && it->second != "")
+    {
+        active = true;
+    }
+    else
+    {
+        for (auto &x : events_path_regex)
+        {
+            if ((x.second->is_path && x.second->path == full_path) || regexec(x.second->regex, full_path.c_str(), 0, NULL, 0) == 0)
+            {
+                active = true;
+                break;
+            }
+        }
+    }
+
+    if (active)
+    {
+        for (auto &x : this->events_exclude_path_regex)
+        {
+            if (regexec(x.second->regex, full_path.c_str(), 0, NULL, 0) == 0)
+            {
+                return false;
+            }
+        }
+    }
+
+    return active;
+}
+
 void trace_domain::reg_trace(vp::trace *trace, int event, string path, string name)
 {
     trace->set_trace_manager(this);
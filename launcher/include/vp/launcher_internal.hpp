@@ -28,6 +28,14 @@
 #define GV_IOREQ_DESC_TYPE_REQUEST  0
 #define GV_IOREQ_DESC_TYPE_RESPONSE 1
 
+// When the shared-memory transport is used, requests and responses are exchanged
+// through 2 rings (see vp/launcher_ring.hpp), each record being a descriptor followed
+// by the write data for requests and by the read data for responses.
+#define GV_IOREQ_RING_TO_SIM  0
+#define GV_IOREQ_RING_TO_HOST 1
+#define GV_IOREQ_NB_RINGS     2
+#define GV_IOREQ_RING_SIZE    (1<<20)
+
 typedef struct {
   int64_t              type;
   uint64_t             addr;
@@ -0,0 +1,523 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __VP_LAUNCHER_RING_HPP_
+#define __VP_LAUNCHER_RING_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// Single-producer single-consumer ring living in memory shared between the launcher
+// and the simulator, used instead of pipes to exchange IO requests.
+// Records are variable-sized, made of a 64 bits length followed by the record data,
+// and are always contiguous in the ring, a padding record being inserted when a record
+// would cross the end of the ring. Messages bigger than a record are sent as several
+// fragments, which the consumer gathers back.
+// Records are only visible to the consumer once the producer calls flush, so that
+// several records can be pushed with a single doorbell. The doorbells are futexes,
+// which are only woken up when the other side is actually sleeping, so that no system
+// call is done as long as both sides are busy.
+
+#define GV_RING_ALIGN       64
+#define GV_RING_SPIN_COUNT  1000
+#define GV_RING_RECORD_PAD  UINT64_MAX
+#define GV_RING_RECORD_MORE (1ULL << 63)
+
+typedef struct {
+  alignas(GV_RING_ALIGN) std::atomic<uint64_t> head;  // Written by the producer
+  std::atomic<uint32_t> consumer_waiting;
+  std::atomic<uint32_t> data_doorbell;
+  alignas(GV_RING_ALIGN) std::atomic<uint64_t> tail;  // Written by the consumer
+  std::atomic<uint32_t> producer_waiting;
+  std::atomic<uint32_t> space_doorbell;
+  alignas(GV_RING_ALIGN) std::atomic<uint32_t> closed;
+  uint64_t size;
+} gv_ring_header_t;
+
+
+class Gv_ring
+{
+public:
+  // Shared memory size needed for nb_rings rings of size bytes each. The size must be
+  // a power of 2.
+  static size_t shm_size(int nb_rings, size_t size) { return nb_rings * (sizeof(gv_ring_header_t) + size); }
+
+  // Initialize the ring at index in the shared memory, must be called once before
+  // the ring is used on any side
+  static void init(void *shm, int index, size_t size)
+  {
+    gv_ring_header_t *header = (gv_ring_header_t *)((uint8_t *)shm + index * (sizeof(gv_ring_header_t) + size));
+    header->head = 0;
+    header->consumer_waiting = 0;
+    header->data_doorbell = 0;
+    header->tail = 0;
+    header->producer_waiting = 0;
+    header->space_doorbell = 0;
+    header->closed = 0;
+    header->size = size;
+  }
+
+  // Get the ring at index in an initialized shared memory. All rings have the same size.
+  Gv_ring(void *shm, int index)
+  {
+    uint64_t size = ((gv_ring_header_t *)shm)->size;
+    this->header = (gv_ring_header_t *)((uint8_t *)shm + index * (sizeof(gv_ring_header_t) + size));
+    this->data = (uint8_t *)(this->header + 1);
+    this->size = size;
+    this->local_head = this->header->head;
+    this->local_tail = this->header->tail;
+    this->cached_head = this->local_head;
+    this->cached_tail = this->local_tail;
+  }
+
+  // Biggest record which can be pushed
+  size_t max_size() { return this->size / 2 - sizeof(uint64_t); }
+
+  // Producer side. Reserve a contiguous record of size bytes and return a pointer to it.
+  // more tells that the record is a fragment which is followed by other ones.
+  // This never waits. NULL is returned if the record is too big, if the ring is closed,
+  // or if there is not enough space, in which case space_target tells what to wait for.
+  inline void *alloc(size_t size, bool more=false);
+
+  // Producer side. Commit the record returned by the last alloc.
+  inline void push();
+
+  // Producer side. Make all pushed records visible to the consumer, and wake it up
+  // if it is sleeping.
+  inline void flush();
+
+  // Producer side. Value of the consumer tail needed for the last failed alloc to succeed.
+  uint64_t space_target() { return this->alloc_target; }
+
+  // Producer side. Wait until the consumer tail reaches target. This only accesses the
+  // shared state and can be called without holding the lock which protects the producer.
+  // Returns false if the ring is closed.
+  inline bool wait_space(uint64_t target);
+
+  // Consumer side. Return the next message, waiting until one is available. Returns NULL
+  // if the ring is closed.
+  inline void *peek(size_t *size);
+
+  // Consumer side. Release the message returned by the last peek.
+  inline void pop();
+
+  // Consumer side. Tell if a record is available without waiting.
+  bool pending() { return this->header->head.load(std::memory_order_acquire) != this->local_tail; }
+
+  // Close the ring, which wakes up and stops both sides
+  inline void close();
+
+private:
+  static uint64_t record_size(size_t size) { return (sizeof(uint64_t) + size + GV_RING_ALIGN - 1) & ~(uint64_t)(GV_RING_ALIGN - 1); }
+
+  static void futex_wait(std::atomic<uint32_t> *futex, uint32_t value)
+  {
+    syscall(SYS_futex, (uint32_t *)futex, FUTEX_WAIT, value, NULL, NULL, 0);
+  }
+
+  static void futex_wake(std::atomic<uint32_t> *futex)
+  {
+    syscall(SYS_futex, (uint32_t *)futex, FUTEX_WAKE, 1, NULL, NULL, 0);
+  }
+
+  inline bool has_space(uint64_t size);
+  inline bool wait_data();
+  inline void pop_record();
+
+  gv_ring_header_t *header;
+  uint8_t *data;
+  uint64_t size;
+
+  uint64_t local_head;
+  uint64_t cached_tail;
+  uint64_t alloc_size = 0;
+  uint64_t alloc_target = 0;
+
+  uint64_t local_tail;
+  uint64_t cached_head;
+  uint64_t peek_size = 0;
+  // Fragmented messages are gathered here
+  std::vector<uint8_t> message;
+  bool gathering = false;
+  bool gathered = false;
+};
+
+
+inline bool Gv_ring::has_space(uint64_t size)
+{
+  if (this->local_head + size - this->cached_tail <= this->size)
+    return true;
+
+  this->cached_tail = this->header->tail.load(std::memory_order_acquire);
+  return this->local_head + size - this->cached_tail <= this->size;
+}
+
+
+inline void *Gv_ring::alloc(size_t size, bool more)
+{
+  if (size > this->max_size() || this->header->closed)
+    return NULL;
+
+  uint64_t rec_size = record_size(size);
+  uint64_t index = this->local_head & (this->size - 1);
+
+  if (index + rec_size > this->size)
+  {
+    // Not enough room before the end of the ring, skip it with a padding record
+    uint64_t pad_size = this->size - index;
+    if (!this->has_space(pad_size))
+    {
+      this->alloc_target = this->local_head + pad_size + rec_size - this->size;
+      return NULL;
+    }
+
+    *(uint64_t *)&this->data[index] = GV_RING_RECORD_PAD;
+    this->local_head += pad_size;
+    index = 0;
+  }
+
+  if (!this->has_space(rec_size))
+  {
+    this->alloc_target = this->local_head + rec_size - this->size;
+    return NULL;
+  }
+
+  *(uint64_t *)&this->data[index] = more ? size | GV_RING_RECORD_MORE : size;
+  this->alloc_size = rec_size;
+
+  return &this->data[index + sizeof(uint64_t)];
+}
+
+
+inline void Gv_ring::push()
+{
+  this->local_head += this->alloc_size;
+  this->alloc_size = 0;
+}
+
+
+inline void Gv_ring::flush()
+{
+  this->header->head = this->local_head;
+  if (this->header->consumer_waiting)
+  {
+    this->header->data_doorbell++;
+    futex_wake(&this->header->data_doorbell);
+  }
+}
+
+
+inline bool Gv_ring::wait_space(uint64_t target)
+{
+  int spin = 0;
+
+  while ((int64_t)(this->header->tail.load(std::memory_order_acquire) - target) < 0)
+  {
+    if (this->header->closed)
+      return false;
+
+    if (spin++ < GV_RING_SPIN_COUNT)
+      continue;
+
+    uint32_t doorbell = this->header->space_doorbell;
+    this->header->producer_waiting = 1;
+    if ((int64_t)(this->header->tail - target) < 0 && !this->header->closed)
+    {
+      futex_wait(&this->header->space_doorbell, doorbell);
+    }
+    this->header->producer_waiting = 0;
+  }
+
+  return true;
+}
+
+
+inline bool Gv_ring::wait_data()
+{
+  int spin = 0;
+
+  while (this->cached_head == this->local_tail)
+  {
+    this->cached_head = this->header->head.load(std::memory_order_acquire);
+    if (this->cached_head != this->local_tail)
+      break;
+
+    if (this->header->closed)
+      return false;
+
+    if (spin++ < GV_RING_SPIN_COUNT)
+      continue;
+
+    uint32_t doorbell = this->header->data_doorbell;
+    this->header->consumer_waiting = 1;
+    if (this->header->head == this->local_tail && !this->header->closed)
+    {
+      futex_wait(&this->header->data_doorbell, doorbell);
+    }
+    this->header->consumer_waiting = 0;
+  }
+
+  return true;
+}
+
+
+inline void *Gv_ring::peek(size_t *size)
+{
+  while (1)
+  {
+    if (!this->wait_data())
+      return NULL;
+
+    uint64_t index = this->local_tail & (this->size - 1);
+    uint64_t rec_size = *(uint64_t *)&this->data[index];
+
+    if (rec_size == GV_RING_RECORD_PAD)
+    {
+      this->local_tail += this->size - index;
+      continue;
+    }
+
+    bool more = rec_size & GV_RING_RECORD_MORE;
+    rec_size &= ~GV_RING_RECORD_MORE;
+    uint8_t *record = &this->data[index + sizeof(uint64_t)];
+    this->peek_size = record_size(rec_size);
+
+    // Usual case, the message is in a single record and is used directly from the ring
+    if (!more && !this->gathering)
+    {
+      *size = rec_size;
+      return record;
+    }
+
+    // Otherwise the fragments are copied out, so that the space is released for the
+    // next ones
+    if (!this->gathering)
+    {
+      this->message.clear();
+      this->gathering = true;
+    }
+
+    this->message.insert(this->message.end(), record, record + rec_size);
+    this->pop_record();
+
+    if (!more)
+    {
+      this->gathering = false;
+      this->gathered = true;
+      *size = this->message.size();
+      return this->message.data();
+    }
+  }
+}
+
+
+inline void Gv_ring::pop_record()
+{
+  this->local_tail += this->peek_size;
+  this->peek_size = 0;
+
+  this->header->tail = this->local_tail;
+  if (this->header->producer_waiting)
+  {
+    this->header->space_doorbell++;
+    futex_wake(&this->header->space_doorbell);
+  }
+}
+
+
+inline void Gv_ring::pop()
+{
+  if (this->gathered)
+    this->gathered = false;
+  else
+    this->pop_record();
+}
+
+
+inline void Gv_ring::close()
+{
+  this->header->closed = 1;
+  this->header->data_doorbell++;
+  this->header->space_doorbell++;
+  futex_wake(&this->header->data_doorbell);
+  futex_wake(&this->header->space_doorbell);
+}
+
+
+
+// Sends messages, made of a header followed by data, either on a ring or on a pipe,
+// from any thread.
+// Senders never wait for the transport, since they may hold locks needed by the other
+// side to make progress. A message is written directly to the ring when it fits, and
+// is otherwise queued and written by a thread owned by the sender, which is the only
+// one waiting for space. This thread also writes all messages sent on a pipe.
+// Senders are never deleted since their thread may be waiting on them.
+class Gv_ring_sender
+{
+public:
+  // ring is NULL when the pipe file is used
+  Gv_ring_sender(Gv_ring *ring, FILE *file) : ring(ring), file(file)
+  {
+    std::thread(&Gv_ring_sender::routine, this).detach();
+  }
+
+  // When flush is false, the message may stay invisible to the other side until
+  // the next flush, so that several messages are sent with a single doorbell
+  inline void send(const void *header, size_t header_size, const void *data, size_t data_size, bool flush=true);
+
+  inline void flush();
+
+private:
+  inline bool write_ring();
+  inline void routine();
+
+  Gv_ring *ring;
+  FILE *file;
+  std::mutex lock;
+  std::condition_variable cond;
+  std::deque<std::vector<uint8_t>> queue;
+  // Part of the first queued message already sent as fragments
+  size_t sent = 0;
+};
+
+
+inline void Gv_ring_sender::send(const void *header, size_t header_size, const void *data, size_t data_size, bool flush)
+{
+  std::lock_guard<std::mutex> guard(this->lock);
+
+  // Messages must stay ordered, so they can only bypass the queue if it is empty
+  if (this->ring && this->queue.empty())
+  {
+    uint8_t *record = (uint8_t *)this->ring->alloc(header_size + data_size);
+    if (record)
+    {
+      memcpy(record, header, header_size);
+      if (data_size)
+        memcpy(record + header_size, data, data_size);
+      this->ring->push();
+      if (flush)
+        this->ring->flush();
+      return;
+    }
+  }
+
+  std::vector<uint8_t> message(header_size + data_size);
+  memcpy(message.data(), header, header_size);
+  if (data_size)
+    memcpy(message.data() + header_size, data, data_size);
+  this->queue.push_back(std::move(message));
+  this->cond.notify_one();
+}
+
+
+inline void Gv_ring_sender::flush()
+{
+  std::lock_guard<std::mutex> guard(this->lock);
+  if (this->ring)
+    this->ring->flush();
+}
+
+
+// Write as many queued messages as possible to the ring, returns false if it is full.
+// Must be called with the lock held.
+inline bool Gv_ring_sender::write_ring()
+{
+  while (!this->queue.empty())
+  {
+    std::vector<uint8_t> &message = this->queue.front();
+    size_t size = message.size() - this->sent;
+    bool more = size > this->ring->max_size();
+    if (more)
+      size = this->ring->max_size();
+
+    uint8_t *record = (uint8_t *)this->ring->alloc(size, more);
+    if (record == NULL)
+    {
+      // The consumer can only free space if it sees what was already pushed
+      this->ring->flush();
+      return false;
+    }
+
+    memcpy(record, message.data() + this->sent, size);
+    this->ring->push();
+
+    if (more)
+    {
+      this->sent += size;
+    }
+    else
+    {
+      this->sent = 0;
+      this->queue.pop_front();
+    }
+  }
+
+  this->ring->flush();
+  return true;
+}
+
+
+inline void Gv_ring_sender::routine()
+{
+  std::unique_lock<std::mutex> guard(this->lock);
+
+  while(1)
+  {
+    while (this->queue.empty())
+      this->cond.wait(guard);
+
+    if (this->ring)
+    {
+      if (!this->write_ring())
+      {
+        uint64_t target = this->ring->space_target();
+        guard.unlock();
+        bool closed = !this->ring->wait_space(target);
+        guard.lock();
+        if (closed)
+          return;
+      }
+    }
+    else
+    {
+      std::vector<uint8_t> message = std::move(this->queue.front());
+      this->queue.pop_front();
+      guard.unlock();
+      bool failed = fwrite(message.data(), message.size(), 1, this->file) != 1 || fflush(this->file) != 0;
+      guard.lock();
+      if (failed)
+        return;
+    }
+  }
+}
+
+#endif
@@ -21,6 +21,7 @@
 
 #include "vp/launcher.h"
 #include "vp/launcher_internal.hpp"
+#include "vp/launcher_ring.hpp"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -32,6 +33,7 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <sys/prctl.h>
+#include <sys/mman.h>
 #include <signal.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -43,6 +45,14 @@ typedef struct {
   char *config_file;
 } gv_launcher_t;
 
+// Descriptor of a request received from the simulator, kept until the host answers.
+// They are recycled together with their data buffer to avoid allocating for each request.
+typedef struct gv_ioreq_host_desc_s {
+  gv_ioreq_desc_t desc;
+  size_t capacity;
+  struct gv_ioreq_host_desc_s *next;
+} gv_ioreq_host_desc_t;
+
 typedef struct {
   int rcv_pipe[2];
   int snd_pipe[2];
@@ -51,6 +61,15 @@ typedef struct {
   FILE *snd_file;
   gv_ioreq_request_t callback;
   void *context;
+  // Protects the free descriptors
+  pthread_mutex_t desc_lock;
+  gv_ioreq_host_desc_t *free_descs;
+  // Shared-memory transport, NULL if pipes are used
+  Gv_ring *to_sim;
+  Gv_ring *to_host;
+  // Requests and responses to the simulator can come from different threads, and are
+  // sent through this sender so that they never wait for the transport
+  Gv_ring_sender *sender;
 } gv_ioreq_binding_t;
 
 static pid_t child_id = -1;
@@ -128,6 +147,44 @@ void gv_destroy(void *handle)
   }
 }
 
+// Get a free descriptor with a data buffer of at least size bytes
+static gv_ioreq_desc_t *ioreq_desc_get(gv_ioreq_binding_t *binding, size_t size)
+{
+  pthread_mutex_lock(&binding->desc_lock);
+  gv_ioreq_host_desc_t *host_desc = binding->free_descs;
+  if (host_desc != NULL) binding->free_descs = host_desc->next;
+  pthread_mutex_unlock(&binding->desc_lock);
+
+  if (host_desc == NULL) {
+    host_desc = (gv_ioreq_host_desc_t *)malloc(sizeof(gv_ioreq_host_desc_t));
+    if (host_desc == NULL) return NULL;
+    host_desc->desc.data = NULL;
+    host_desc->capacity = 0;
+  }
+
+  if (host_desc->capacity < size) {
+    void *data = realloc(host_desc->desc.data, size);
+    if (data == NULL) {
+      free(host_desc->desc.data);
+      free(host_desc);
+      return NULL;
+    }
+    host_desc->desc.data = data;
+    host_desc->capacity = size;
+  }
+
+  return &host_desc->desc;
+}
+
+static void ioreq_desc_put(gv_ioreq_binding_t *binding, gv_ioreq_desc_t *desc)
+{
+  gv_ioreq_host_desc_t *host_desc = (gv_ioreq_host_desc_t *)desc;
+  pthread_mutex_lock(&binding->desc_lock);
+  host_desc->next = binding->free_descs;
+  binding->free_descs = host_desc;
+  pthread_mutex_unlock(&binding->desc_lock);
+}
+
 static void ioreq_response(void *context, gv_ioreq_t *req)
 {
   gv_ioreq_desc_t *desc = (gv_ioreq_desc_t *)context;
@@ -135,31 +192,78 @@ static void ioreq_response(void *context, gv_ioreq_t *req)
   desc->type = GV_IOREQ_DESC_TYPE_RESPONSE;
   desc->latency = req->latency;
   desc->timestamp += req->latency;
-  if (fwrite((void *)desc, sizeof(*desc), 1, binding->snd_file) != 1) return;
-  if (!desc->is_write && fwrite(desc->data, desc->size, 1, binding->snd_file) != 1) return;
-  fflush(binding->snd_file);
-  free(desc->data);
-  free((void *)desc);
+
+  size_t data_size = desc->is_write ? 0 : desc->size;
+
+  // The sender copies the response, so the descriptor can be recycled right away
+  binding->sender->send(desc, sizeof(*desc), desc->data, data_size);
+
+  ioreq_desc_put(binding, desc);
+}
+
+static void *ioreq_ring_routine(gv_ioreq_binding_t *binding)
+{
+  while(1) {
+    size_t size;
+    uint8_t *record = (uint8_t *)binding->to_host->peek(&size);
+    if (record == NULL) return NULL;
+
+    gv_ioreq_desc_t *desc = (gv_ioreq_desc_t *)record;
+
+    if (desc->type == GV_IOREQ_DESC_TYPE_RESPONSE)
+    {
+      // Fabric side sent us a response for a host->fabric request, the descriptor
+      // points to the host buffer
+      if (!desc->is_write) memcpy(desc->data, record + sizeof(*desc), desc->size);
+      gv_ioreq_response_t response_cb = desc->response_cb;
+      void *response_context = desc->response_context;
+      gv_ioreq_t user_req = desc->user_req;
+      binding->to_host->pop();
+      if (response_cb != NULL) {
+        response_cb(response_context, &user_req);
+      }
+    }
+    else
+    {
+      // The callback can answer asynchronously, so the request must be copied out of
+      // the ring
+      gv_ioreq_desc_t *req = ioreq_desc_get(binding, desc->size);
+      if (req == NULL) return NULL;
+
+      void *data = req->data;
+      *req = *desc;
+      req->data = data;
+      if (req->is_write) memcpy(req->data, record + sizeof(*desc), req->size);
+      binding->to_host->pop();
+
+      if (binding->callback != NULL) {
+        binding->callback(binding->context, (void *)req->data, (void *)req->addr, req->size, req->is_write,
+          ioreq_response, (void *)req);
+      } else {
+        ioreq_desc_put(binding, req);
+      }
+    }
+  }
 }
 
 static void *ioreq_routine(void *arg)
 {
   gv_ioreq_binding_t *binding = (gv_ioreq_binding_t *)arg;
 
+  if (binding->to_host) return ioreq_ring_routine(binding);
+
   FILE *f = fdopen(binding->rcv_pipe[0], "r");
   if (f == NULL) return NULL;
 
-  gv_ioreq_desc_t *req = NULL;
-
   while(1) {
-    if (req == NULL) req = (gv_ioreq_desc_t *)malloc(sizeof(gv_ioreq_desc_t));
-    if (req == NULL) return NULL;
+    gv_ioreq_desc_t desc;
 
-    if (fread((void *)req, sizeof(*req), 1, f) != 1) return NULL;
+    if (fread((void *)&desc, sizeof(desc), 1, f) != 1) return NULL;
+    gv_ioreq_desc_t *req = &desc;
 
     if (req->type == GV_IOREQ_DESC_TYPE_RESPONSE)
     {
-      // Fabric side sent us a response fro a host->fabric request
+      // Fabric side sent us a response for a host->fabric request
       if (!req->is_write && fread(req->data, req->size, 1, f) != 1) return NULL;
       if (req->response_cb != NULL) {
         req->response_cb(req->response_context, &req->user_req);
@@ -167,15 +271,19 @@ static void *ioreq_routine(void *arg)
     }
     else
     {
-      req->data = malloc(req->size);
-      if (req->data == NULL) return NULL;
+      req = ioreq_desc_get(binding, desc.size);
+      if (req == NULL) return NULL;
+
+      void *data = req->data;
+      *req = desc;
+      req->data = data;
 
       if (req->is_write && fread(req->data, req->size, 1, f) != 1) return NULL;
-      gv_ioreq_binding_t *binding = (gv_ioreq_binding_t *)req->binding;
       if (binding->callback != NULL) {
         binding->callback(binding->context, (void *)req->data, (void *)req->addr, req->size, req->is_write,
           ioreq_response, (void *)req);
-        req = NULL;
+      } else {
+        ioreq_desc_put(binding, req);
       }
     }
   }
@@ -191,15 +299,54 @@ void *gv_ioreq_binding(void *handle, char *path, void *base, size_t size, gv_ior
 
   binding->callback = callback;
   binding->context = context;
+  binding->free_descs = NULL;
+  binding->to_sim = NULL;
+  binding->to_host = NULL;
+  binding->snd_file = NULL;
+  pthread_mutex_init(&binding->desc_lock, NULL);
+
+  // Use the shared-memory rings unless pipes are forced or the memory can't be shared.
+  // The memory file is inherited by the simulator, which maps it from its descriptor.
+  std::string str;
+  int ring_fd = -1;
+  const char *transport = getenv("GV_IOREQ_TRANSPORT");
+  if (transport == NULL || strcmp(transport, "pipe") != 0) {
+    size_t shm_size = Gv_ring::shm_size(GV_IOREQ_NB_RINGS, GV_IOREQ_RING_SIZE);
+    ring_fd = memfd_create("gv_ioreq", 0);
+    if (ring_fd != -1 && ftruncate(ring_fd, shm_size) == 0) {
+      void *shm = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+      if (shm != MAP_FAILED) {
+        Gv_ring::init(shm, GV_IOREQ_RING_TO_SIM, GV_IOREQ_RING_SIZE);
+        Gv_ring::init(shm, GV_IOREQ_RING_TO_HOST, GV_IOREQ_RING_SIZE);
+        binding->to_sim = new Gv_ring(shm, GV_IOREQ_RING_TO_SIM);
+        binding->to_host = new Gv_ring(shm, GV_IOREQ_RING_TO_HOST);
+      }
+    }
+    if (binding->to_sim == NULL && ring_fd != -1) {
+      close(ring_fd);
+      ring_fd = -1;
+    }
+  }
 
-  if(pipe(binding->snd_pipe) == -1) return NULL;
-  if(pipe(binding->rcv_pipe) == -1) return NULL;
+  if (binding->to_sim) {
+    str = "--config-opt=**/" + std::string(path) + "/ring_fd=" + std::to_string(ring_fd);
+    add_option(gv, strdup((char *)str.c_str()));
 
-  std::string str = "--config-opt=**/" + std::string(path) + "/rcv_fd=" + std::to_string(binding->snd_pipe[0]);
-  add_option(gv, strdup((char *)str.c_str()));
+    str = "--config-opt=**/" + std::string(path) + "/rcv_fd=-1";
+    add_option(gv, strdup((char *)str.c_str()));
 
-  str = "--config-opt=**/" + std::string(path) + "/snd_fd=" + std::to_string(binding->rcv_pipe[1]);
-  add_option(gv, strdup((char *)str.c_str()));
+    str = "--config-opt=**/" + std::string(path) + "/snd_fd=-1";
+    add_option(gv, strdup((char *)str.c_str()));
+  } else {
+    if(pipe(binding->snd_pipe) == -1) return NULL;
+    if(pipe(binding->rcv_pipe) == -1) return NULL;
+
+    str = "--config-opt=**/" + std::string(path) + "/rcv_fd=" + std::to_string(binding->snd_pipe[0]);
+    add_option(gv, strdup((char *)str.c_str()));
+
+    str = "--config-opt=**/" + std::string(path) + "/snd_fd=" + std::to_string(binding->rcv_pipe[1]);
+    add_option(gv, strdup((char *)str.c_str()));
+  }
 
   str = "--config-opt=**/" + std::string(path) + "/external_binding/base=" + std::to_string((int64_t)base);
   add_option(gv, strdup((char *)str.c_str()));
@@ -211,8 +358,12 @@ void *gv_ioreq_binding(void *handle, char *path, void *base, size_t size, gv_ior
   add_option(gv, strdup((char *)str.c_str()));
 
   binding->gv = (gv_launcher_t *)handle;
-  binding->snd_file = fdopen(binding->snd_pipe[1], "w");
-  if (binding->snd_file == NULL) return NULL;
+  if (binding->to_sim == NULL) {
+    binding->snd_file = fdopen(binding->snd_pipe[1], "w");
+    if (binding->snd_file == NULL) return NULL;
+  }
+
+  binding->sender = new Gv_ring_sender(binding->to_sim, binding->snd_file);
 
   pthread_create(&binding->thread, NULL, ioreq_routine, (void *)binding);
   
@@ -227,10 +378,8 @@ int gv_ioreq(void *_binding, int64_t timestamp, void *data, void *addr, size_t s
     .response_cb=callback, .response_context=context
   };
   desc.data = data;
-  if (fwrite((void *)&desc, sizeof(desc), 1, binding->snd_file) != 1) return -1;
-  if (is_write && fwrite(data, size, 1, binding->snd_file) != 1) return -1;
 
-  fflush(binding->snd_file);
+  binding->sender->send(&desc, sizeof(desc), data, is_write ? size : 0);
 
   return 0;
 }
@@ -24,10 +24,25 @@ class Cache(st.Component):
     ----------
     size : int
         The size of the memory
+    nb_mshrs : int
+        Number of line refills which can be outstanding at the same time. Misses to a line which
+        is already being refilled are merged with the on-going refill and do not need a new one.
+    write_back : bool
+        True if written lines should be marked dirty and written back when they are evicted or
+        flushed, False if writes only update the cache.
+    prefetcher : str
+        Prefetcher trained on the demand accesses, can be 'next_line', 'stride' or 'stream'.
+        No prefetch is done if it is None. Prefetches use the MSHRs with a lower priority than
+        demand misses and are dropped when no MSHR is available.
+    prefetch_degree : int
+        Number of lines prefetched ahead of the demand accesses.
+    prefetch_table_size : int
+        Number of streams tracked by the 'stride' and 'stream' prefetchers.
     
     """
 
-    def __init__(self, parent, name, nb_sets_bits, nb_ways_bits, line_size_bits, refill_latency=0, refill_shift=0, nb_ports=1, add_offset=0):
+    def __init__(self, parent, name, nb_sets_bits, nb_ways_bits, line_size_bits, refill_latency=0, refill_shift=0, nb_ports=1, add_offset=0,
+            nb_mshrs=1, write_back=False, prefetcher=None, prefetch_degree=1, prefetch_table_size=16):
 
         super(Cache, self).__init__(parent, name)
 
@@ -40,9 +55,16 @@ class Cache(st.Component):
             'nb_ports': nb_ports,
             'refill_latency': refill_latency,
             'add_offset': add_offset,
-            'refill_shift': refill_shift
+            'refill_shift': refill_shift,
+            'nb_mshrs': nb_mshrs,
+            'write_back': write_back,
+            'prefetch_degree': prefetch_degree,
+            'prefetch_table_size': prefetch_table_size
         })
 
+        if prefetcher is not None:
+            self.add_property('prefetcher', prefetcher)
+
 
     def gen_gtkw2(self, tree, comp_traces):
 
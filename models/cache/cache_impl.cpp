@@ -25,17 +25,31 @@
 #include <vp/signal.hpp>
 #include <vector>
 #include <sstream>
+#include "prefetcher.hpp"
 
 
 
+// Line state flags
+#define CACHE_LINE_DIRTY      (1<<0)    // The line has been written and must be written back
+#define CACHE_LINE_REFILLING  (1<<1)    // The line is waiting for an asynchronous refill
+#define CACHE_LINE_PREFETCHED (1<<2)    // The line was brought by a prefetch and not accessed yet
+
+
+
+// Miss status holding register, tracking an outstanding line refill and the requests
+// which are waiting for it
 typedef struct
 {
+  bool pending;             // True while waiting for the refill response
+  bool prefetch;            // True if the refill is a prefetch which no demand access is waiting for
+  int64_t start_cycles;     // Cycle where the refill was sent
+  int64_t end_cycles;       // Cycle where the refill is done, for synchronous refills
   uint32_t tag;
-  bool dirty;
-  uint8_t *data;
-  vp::trace tag_event;
-  int64_t timestamp;
-} cache_line_t;
+  int line;
+  vp::io_req req;
+  vp::io_req *waiting_first;
+  vp::io_req *waiting_last;
+} cache_mshr_t;
 
 
 
@@ -61,6 +75,7 @@ public:
 
   int build();
   void start();
+  void stop();
 
 private:
 
@@ -74,12 +89,13 @@ private:
   vp::wire_slave<bool>      flush_line_itf;
   vp::wire_slave<uint32_t>  flush_line_addr_itf;
 
-  vp::io_req refill_req;
-
   int refill_latency;
   int refill_shift;
   uint32_t add_offset;
-  int64_t refill_timestamp;
+
+  // Write-back mode, where written lines are marked dirty and written back when they
+  // are evicted or flushed
+  bool write_back;
 
   int64_t nextPacketStart;
   unsigned int R1;
@@ -96,21 +112,50 @@ private:
 
   vp::queue refill_pending_reqs;
 
-  cache_line_t *lines;
+  // Line state, stored as one array per field and indexed by set * nb_ways + way so that
+  // the tags of a set are contiguous
+  int nb_lines;
+  uint32_t *line_tags;
+  uint8_t *line_flags;
+  int64_t *line_timestamps;
+  uint8_t *line_data;
+  // Line event traces, only allocated for the lines selected by the trace configuration
+  vp::trace **line_events;
 
-  cache_line_t *refill_line;
-  uint32_t refill_tag;
-  vp::signal pending_refill;
+  int nb_mshrs;
+  cache_mshr_t *mshrs;
+  int nb_pending_mshrs;
 
   vp::clock_event *fsm_event;
 
+  // Optional prefetcher, trained on demand accesses. Prefetches use the same MSHRs as the
+  // demand misses, but are dropped instead of stalled when resources are missing.
+  Cache_prefetcher *prefetcher;
+  std::vector<uint32_t> prefetch_lines;
+
+  // Statistics
+  int64_t nb_hits;
+  int64_t nb_misses;
+  int64_t nb_merged_misses;
+  int64_t nb_mshr_stalls;
+  int64_t nb_writebacks;
+  int64_t mshr_busy_cycles;       // Sum of the cycles spent by each MSHR on a refill
+  int max_pending_mshrs;
+  int64_t nb_prefetches;
+  int64_t nb_prefetch_drops;
+  int64_t nb_prefetch_useful;     // Prefetched lines accessed by a demand access
+  int64_t nb_prefetch_late;       // Useful prefetches which were not completed when accessed
+  int64_t nb_prefetch_merged;     // Demand misses merged with an on-going prefetch
+
   static void enable_sync(void *_this, bool active);
   static void flush_sync(void *_this, bool active);
   static void flush_line_sync(void *_this, bool active);
   static void flush_line_addr_sync(void *_this, uint32_t addr);
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req, int port);
-  vp::io_req_status_e handle_req(vp::io_req *req);
+  vp::io_req_status_e handle_req(vp::io_req *req, bool replay=false);
+  void line_access(int line, vp::io_req *req);
+  inline uint8_t *get_line_data(int line) { return &this->line_data[line << this->line_size_bits]; }
   void check_state();
   static void fsm_handler(void *__this, vp::clock_event *event);
 
@@ -121,9 +166,19 @@ private:
   inline unsigned int get_line_offset(unsigned int addr) {return addr & ((1 << line_size_bits) - 1);}
   inline unsigned int getAddr(unsigned int index, unsigned int tag) {return (tag << (line_size_bits + nb_sets_bits)) | (index << line_size_bits);}
 
-  cache_line_t *refill(int line_index, unsigned int addr, unsigned int tag, vp::io_req *req, bool *pending);
+  inline uint32_t get_refill_addr(uint32_t tag) { return this->get_line_base((tag << this->line_size_bits) << this->refill_shift) + this->add_offset; }
+
+  int refill(int line_index, unsigned int addr, unsigned int tag, vp::io_req *req, bool *pending, bool *stalled, bool replay);
+  vp::io_req_status_e send_refill(cache_mshr_t *mshr, int line, uint32_t tag, vp::io_req *req, int64_t *latency);
+  void prefetch(uint32_t tag);
+  void prefetch_train(uint32_t tag, bool miss, bool prefetch_hit);
+  cache_mshr_t *mshr_get(uint32_t tag);
+  cache_mshr_t *mshr_alloc();
+  int get_victim(int line_index);
+  void write_back_line(int line);
+  void stall_req(vp::io_req *req, bool replay);
   static void refill_response(void *_this, vp::io_req *req);
-  cache_line_t *get_line(vp::io_req *req, unsigned int *line_index, unsigned int *tag);
+  int get_line(vp::io_req *req, unsigned int *line_index, unsigned int *tag);
 
   unsigned int stepLru();
   bool ioReq(vp::io_req *req, int i);
@@ -136,36 +191,55 @@ private:
 void Cache::refill_response(void *__this, vp::io_req *req)
 {
     Cache *_this = (Cache *)__this;
+    cache_mshr_t *mshr = (cache_mshr_t *)req->arg_pop();
 
-    vp::io_req *pending_req = (vp::io_req *)_this->refill_pending_reqs.pop();
+    // Write-back of an evicted line, just release it
+    if (mshr == NULL)
+    {
+        _this->trace.msg(vp::trace::LEVEL_TRACE, "Received write-back response (req: %p)\n", req);
+        delete[] req->get_data();
+        _this->refill_itf.req_del(req);
+        return;
+    }
 
-    pending_req->restore();
-    uint8_t *data = pending_req->get_data();
-    bool is_write = req->get_is_write();
-    uint64_t size = pending_req->get_size();
+    int line = mshr->line;
+    int64_t cycles = _this->get_cycles();
 
-    _this->trace.msg(vp::trace::LEVEL_TRACE, "Received refill response (req: %p, is_write: %d, data: %p, size: 0x%x)\n",
-        pending_req, is_write, data, size);
+    _this->trace.msg(vp::trace::LEVEL_TRACE, "Received refill response (addr: 0x%x)\n", req->get_addr());
 
-    _this->pending_refill.set(0);
+    _this->line_tags[line] = mshr->tag;
+    _this->line_flags[line] &= ~CACHE_LINE_REFILLING;
+    _this->line_timestamps[line] = cycles;
 
-    if (data)
+    // Prefetched lines are only marked if no demand access merged with the prefetch,
+    // otherwise it has already been accounted as useful
+    if (mshr->prefetch)
     {
-        unsigned int line_index;
-        unsigned int tag;
-        cache_line_t *line = _this->refill_line;
+        _this->line_flags[line] |= CACHE_LINE_PREFETCHED;
+        mshr->prefetch = false;
+    }
 
-        line->tag = _this->refill_tag;
+    mshr->pending = false;
+    mshr->end_cycles = cycles;
+    _this->nb_pending_mshrs--;
+    _this->mshr_busy_cycles += cycles - mshr->start_cycles;
 
-        if (!is_write) {
-            memcpy(data, (void *)line->data, size);
-        } else {
-            //hitLine->setDirty();
-            memcpy((void *)line->data, data, size);
-        }
-    }
+    // Now serve all the requests which were waiting for this line
+    vp::io_req *pending_req = mshr->waiting_first;
+    mshr->waiting_first = NULL;
+
+    while (pending_req)
+    {
+        vp::io_req *next = pending_req->get_next();
+
+        _this->trace.msg(vp::trace::LEVEL_TRACE, "Replying to pending request (req: %p, is_write: %d, offset: 0x%x, size: 0x%x)\n",
+            pending_req, pending_req->get_is_write(), pending_req->get_addr(), pending_req->get_size());
 
-    pending_req->get_resp_port()->resp(pending_req);
+        _this->line_access(line, pending_req);
+        pending_req->get_resp_port()->resp(pending_req);
+
+        pending_req = next;
+    }
 
     _this->check_state();
 }
@@ -174,25 +248,33 @@ void Cache::refill_response(void *__this, vp::io_req *req)
 void Cache::fsm_handler(void *__this, vp::clock_event *event)
 {
     Cache *_this = (Cache *)__this;
-    if (!_this->pending_refill.get() && !_this->refill_pending_reqs.empty())
+
+    // Replay the stalled requests in order until one stalls again
+    while (!_this->refill_pending_reqs.empty())
     {
         vp::io_req *req = (vp::io_req *)_this->refill_pending_reqs.pop();
         req->restore();
         _this->trace.msg(vp::trace::LEVEL_TRACE, "Resuming req (req: %p, is_write: %d, offset: 0x%x, size: 0x%x)\n",
             req, req->get_is_write(), req->get_addr(), req->get_size());
-        if (_this->handle_req(req) == vp::IO_REQ_OK)
+
+        vp::io_req_status_e err = _this->handle_req(req, true);
+        if (err == vp::IO_REQ_OK || err == vp::IO_REQ_INVALID)
         {
-          req->get_resp_port()->resp(req);
+            req->status = err;
+            req->get_resp_port()->resp(req);
+        }
+        else if (_this->refill_pending_reqs.head() == req)
+        {
+            break;
         }
     }
-    
-    _this->check_state();
 }
 
 
 void Cache::check_state()
 {
-    if (!this->pending_refill.get() && !this->refill_pending_reqs.empty())
+    // Stalled requests can only make progress once an MSHR has been released
+    if (!this->refill_pending_reqs.empty() && this->nb_pending_mshrs < this->nb_mshrs)
     {
         if (!this->fsm_event->is_enqueued())
         {
@@ -215,6 +297,12 @@ int Cache::build()
   this->refill_latency = this->get_js_config()->get_child_int("refill_latency");
   this->refill_shift = this->get_js_config()->get_child_int("refill_shift");
   this->add_offset = this->get_js_config()->get_child_int("add_offset");
+  this->write_back = this->get_js_config()->get_child_bool("write_back");
+  this->nb_mshrs = this->get_js_config()->get_child_int("nb_mshrs");
+  if (this->nb_mshrs <= 0)
+  {
+    this->nb_mshrs = 1;
+  }
 
   this->input_itf.resize(this->nb_ports);
 
@@ -259,20 +347,73 @@ int Cache::build()
 
   traces.new_trace_event("refill", &this->refill_event, 32);
 
-  lines = new cache_line_t[(1<<this->nb_sets_bits)*this->nb_ways];
+  this->nb_lines = this->nb_sets * this->nb_ways;
+  this->line_tags = new uint32_t[this->nb_lines];
+  this->line_flags = new uint8_t[this->nb_lines];
+  this->line_timestamps = new int64_t[this->nb_lines];
+  this->line_data = new uint8_t[this->nb_lines << this->line_size_bits];
+  this->line_events = new vp::trace *[this->nb_lines];
+
+  vp::trace_engine *trace_engine = this->traces.get_trace_manager();
+
   for (int i=0; i<1<<this->nb_sets_bits; i++)
   {
     for (int j=0; j<this->nb_ways; j++)
     {
-      cache_line_t *line = &lines[i*this->nb_ways+j];
-      line->timestamp = -1;
-      line->tag = -1;
-      line->data = new uint8_t[1<<this->line_size_bits];
-      traces.new_trace_event("set_" + std::to_string(j) + "/line_" + std::to_string(i), &line->tag_event, 32);
+      int line = i*this->nb_ways+j;
+      this->line_timestamps[line] = -1;
+      this->line_tags[line] = -1;
+      this->line_flags[line] = 0;
+      this->line_events[line] = NULL;
+
+      std::string name = "set_" + std::to_string(j) + "/line_" + std::to_string(i);
+      if (trace_engine->is_event_path_active(this->get_path() + "/" + name))
+      {
+        this->line_events[line] = new vp::trace();
+        traces.new_trace_event(name, this->line_events[line], 32);
+      }
+    }
+  }
+
+  this->mshrs = new cache_mshr_t[this->nb_mshrs];
+  for (int i=0; i<this->nb_mshrs; i++)
+  {
+    cache_mshr_t *mshr = &this->mshrs[i];
+    mshr->pending = false;
+    mshr->prefetch = false;
+    mshr->end_cycles = -1;
+    mshr->waiting_first = NULL;
+  }
+  this->nb_pending_mshrs = 0;
+
+  this->nb_hits = 0;
+  this->nb_misses = 0;
+  this->nb_merged_misses = 0;
+  this->nb_mshr_stalls = 0;
+  this->nb_writebacks = 0;
+  this->mshr_busy_cycles = 0;
+  this->max_pending_mshrs = 0;
+  this->nb_prefetches = 0;
+  this->nb_prefetch_drops = 0;
+  this->nb_prefetch_useful = 0;
+  this->nb_prefetch_late = 0;
+  this->nb_prefetch_merged = 0;
+
+  this->prefetcher = NULL;
+  std::string prefetcher = this->get_js_config()->get_child_str("prefetcher");
+  if (prefetcher != "" && prefetcher != "none")
+  {
+    this->prefetcher = Cache_prefetcher::create(prefetcher,
+      this->get_js_config()->get_child_int("prefetch_degree"),
+      this->get_js_config()->get_child_int("prefetch_table_size"));
+
+    if (this->prefetcher == NULL)
+    {
+      this->trace.fatal("Unknown prefetcher (name: %s)\n", prefetcher.c_str());
+      return -1;
     }
   }
 
-  this->refill_timestamp = -1;
   this->line_index_mask = (1 << this->nb_sets_bits) - 1;
   this->line_offset_mask = (1 << this->line_size_bits) - 1;
 
@@ -285,23 +426,77 @@ int Cache::build()
 
 void Cache::start()
 {
-  this->trace.msg(vp::trace::LEVEL_INFO, "Instantiating cache (nb_sets: %d, nb_ways: %d, line_size: %d)\n", 1<<this->nb_sets_bits, this->nb_ways, 1<<this->line_size_bits);
+  this->trace.msg(vp::trace::LEVEL_INFO, "Instantiating cache (nb_sets: %d, nb_ways: %d, line_size: %d, nb_mshrs: %d, write_back: %d, prefetcher: %d)\n", 1<<this->nb_sets_bits, this->nb_ways, 1<<this->line_size_bits, this->nb_mshrs, this->write_back, this->prefetcher != NULL);
 }
 
 
 
-cache_line_t *Cache::refill(int line_index, unsigned int addr, unsigned int tag, vp::io_req *req, bool *pending)
+void Cache::stop()
 {
-  // The cache supports only 1 refill at the same time.
-  // If a refill occurs while another one is already pending, just enqueue the request and return.
-  if (this->pending_refill.get())
+  int64_t cycles = this->get_cycles();
+
+  this->trace.msg(vp::trace::LEVEL_INFO, "Cache statistics (hits: %ld, misses: %ld, merged misses: %ld, MSHR stalls: %ld, write-backs: %ld)\n",
+    this->nb_hits, this->nb_misses, this->nb_merged_misses, this->nb_mshr_stalls, this->nb_writebacks);
+
+  if (cycles > 0)
   {
-    req->save();
-    this->refill_pending_reqs.push_back(req);
-    *pending = true;
-    return NULL;
+    this->trace.msg(vp::trace::LEVEL_INFO, "MSHR statistics (average occupancy: %f, max pending: %d)\n",
+      (float)this->mshr_busy_cycles / cycles, this->max_pending_mshrs);
   }
 
+  if (this->prefetcher && this->nb_prefetches > 0)
+  {
+    // Accuracy is the ratio of prefetches used by a demand access, coverage is the ratio
+    // of the demand misses which were removed or shortened by a prefetch, and timeliness
+    // is the ratio of useful prefetches which were completed before being accessed.
+    int64_t uncovered_misses = this->nb_misses - this->nb_prefetch_merged;
+    int64_t useful = this->nb_prefetch_useful;
+
+    this->trace.msg(vp::trace::LEVEL_INFO, "Prefetch statistics (issued: %ld, dropped: %ld, useful: %ld, late: %ld, accuracy: %f, coverage: %f, timeliness: %f)\n",
+      this->nb_prefetches, this->nb_prefetch_drops, useful, this->nb_prefetch_late,
+      (float)useful / this->nb_prefetches,
+      useful + uncovered_misses > 0 ? (float)useful / (useful + uncovered_misses) : 0.0,
+      useful > 0 ? (float)(useful - this->nb_prefetch_late) / useful : 0.0);
+  }
+}
+
+
+
+cache_mshr_t *Cache::mshr_get(uint32_t tag)
+{
+  for (int i=0; i<this->nb_mshrs; i++)
+  {
+    cache_mshr_t *mshr = &this->mshrs[i];
+    if (mshr->pending && mshr->tag == tag)
+    {
+      return mshr;
+    }
+  }
+  return NULL;
+}
+
+
+
+cache_mshr_t *Cache::mshr_alloc()
+{
+  // Take the MSHR which is available first. MSHRs used by synchronous refills can be
+  // reused right away, the caller must just account for the remaining refill time.
+  cache_mshr_t *elected = NULL;
+  for (int i=0; i<this->nb_mshrs; i++)
+  {
+    cache_mshr_t *mshr = &this->mshrs[i];
+    if (!mshr->pending && (elected == NULL || mshr->end_cycles < elected->end_cycles))
+    {
+      elected = mshr;
+    }
+  }
+  return elected;
+}
+
+
+
+int Cache::get_victim(int line_index)
+{
   unsigned int refillWay;
 
 #if 1
@@ -323,66 +518,302 @@ cache_line_t *Cache::refill(int line_index, unsigned int addr, unsigned int tag,
   refillWay = elected;
 #endif
 
-  cache_line_t *line = &this->lines[line_index*this->nb_ways + refillWay];
+  // Lines being refilled can not be evicted, take the next one in this case
+  for (int i=0; i<this->nb_ways; i++)
+  {
+    int line = line_index*this->nb_ways + (refillWay + i) % this->nb_ways;
+    if (!(this->line_flags[line] & CACHE_LINE_REFILLING))
+    {
+      return line;
+    }
+  }
+
+  return -1;
+}
+
+
+
+void Cache::write_back_line(int line)
+{
+  if (!(this->line_flags[line] & CACHE_LINE_DIRTY))
+    return;
+
+  this->line_flags[line] &= ~CACHE_LINE_DIRTY;
+
+  if (this->line_tags[line] == (uint32_t)-1)
+    return;
+
+  uint32_t full_addr = this->get_refill_addr(this->line_tags[line]);
+
+  this->trace.msg(vp::trace::LEVEL_DEBUG, "Writing back line (addr: 0x%x)\n", full_addr);
+
+  this->nb_writebacks++;
+
+  // The line data is copied so that the line can be refilled while the write-back
+  // is still on-going. The write-back goes through a write buffer and does not impact
+  // the latency of the access which evicted the line.
+  uint8_t *data = new uint8_t[this->line_size];
+  memcpy(data, this->get_line_data(line), this->line_size);
+
+  vp::io_req *req = this->refill_itf.req_new(full_addr, data, this->line_size, true);
+  req->arg_push(NULL);
+
+  vp::io_req_status_e err = this->refill_itf.req(req);
+  if (err != vp::IO_REQ_PENDING)
+  {
+    if (err != vp::IO_REQ_OK)
+    {
+      this->trace.force_warning("Failed to write back line (addr: 0x%x)\n", full_addr);
+    }
+    delete[] data;
+    this->refill_itf.req_del(req);
+  }
+}
+
+
+
+void Cache::stall_req(vp::io_req *req, bool replay)
+{
+  this->trace.msg(vp::trace::LEVEL_TRACE, "Stalling request, no MSHR available (req: %p)\n", req);
+
+  if (!replay)
+  {
+    this->nb_mshr_stalls++;
+  }
+
+  // Replayed requests go back to the head to keep the requests ordered
+  req->save();
+  if (replay)
+    this->refill_pending_reqs.push_front(req);
+  else
+    this->refill_pending_reqs.push_back(req);
+}
+
+
+
+int Cache::refill(int line_index, unsigned int addr, unsigned int tag, vp::io_req *req, bool *pending, bool *stalled, bool replay)
+{
+  // Miss-under-miss on a line which is already being refilled, just wait for the same refill
+  cache_mshr_t *mshr = this->mshr_get(tag);
+  if (mshr)
+  {
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Merging miss with on-going refill (req: %p)\n", req);
+    this->nb_merged_misses++;
+    req->set_next(NULL);
+
+    if (mshr->waiting_first == NULL)
+    {
+      // First demand access to a line being prefetched
+      if (mshr->prefetch && !req->is_debug())
+      {
+        this->nb_prefetch_useful++;
+        this->nb_prefetch_late++;
+        this->nb_prefetch_merged++;
+        mshr->prefetch = false;
+      }
+      mshr->waiting_first = req;
+    }
+    else
+    {
+      mshr->waiting_last->set_next(req);
+    }
+    mshr->waiting_last = req;
+    *pending = true;
+    return -1;
+  }
+
+  // Misses must be handled in order, stall if older misses are stalled or if no resource
+  // is available for the refill
+  int line = -1;
+  if (replay || this->refill_pending_reqs.empty())
+  {
+    mshr = this->mshr_alloc();
+    if (mshr)
+    {
+      line = this->get_victim(line_index);
+    }
+  }
+
+  if (line == -1)
+  {
+    this->stall_req(req, replay);
+    *pending = true;
+    *stalled = true;
+    return -1;
+  }
+
+  int64_t latency;
+  vp::io_req_status_e err = this->send_refill(mshr, line, tag, req, &latency);
+  if (err != vp::IO_REQ_OK)
+  {
+    *pending = err == vp::IO_REQ_PENDING;
+    return -1;
+  }
+
+  if (!req->is_debug())
+  {
+    req->inc_latency(latency);
+  }
+
+  return line;
+}
+
 
-  uint32_t full_addr = (this->get_line_base(addr << this->refill_shift) + this->add_offset);
 
-  this->trace.msg(vp::trace::LEVEL_DEBUG, "Refilling line (addr: 0x%x, index: %d)\n", full_addr, line_index);
+vp::io_req_status_e Cache::send_refill(cache_mshr_t *mshr, int line, uint32_t tag, vp::io_req *req, int64_t *latency)
+{
+  // req is the demand access which triggered the refill, or NULL for a prefetch
+  bool is_debug = req && req->is_debug();
+  uint32_t full_addr = this->get_refill_addr(tag);
+
+  this->trace.msg(vp::trace::LEVEL_DEBUG, "%s line (addr: 0x%x, index: %d)\n",
+    req ? "Refilling" : "Prefetching", full_addr, line / this->nb_ways);
+
   // Flush the line in case it is dirty to copy it back outside
-  //flush();
+  this->write_back_line(line);
 
-  line->tag_event.event((uint8_t *)&full_addr);
+  if (this->line_events[line])
+  {
+    this->line_events[line]->event((uint8_t *)&full_addr);
+  }
 
   // And get the data from outside
-  vp::io_req *refill_req = &this->refill_req;
+  vp::io_req *refill_req = &mshr->req;
   refill_req->init();
   refill_req->set_addr(full_addr);
   refill_req->set_is_write(false);
   refill_req->set_size(1<<this->line_size_bits);
-  refill_req->set_data(line->data);
+  refill_req->set_data(this->get_line_data(line));
+  refill_req->arg_push(mshr);
+
+  // The line content is going to be replaced
+  this->line_tags[line] = -1;
+  this->line_flags[line] &= ~CACHE_LINE_PREFETCHED;
 
   vp::io_req_status_e err = this->refill_itf.req(refill_req);
   if (err != vp::IO_REQ_OK)
   {
     if (err == vp::IO_REQ_PENDING)
     {
-      req->save();
-      this->refill_pending_reqs.push_front(req);
-      this->refill_line = line;
-      this->refill_tag = tag;
-      this->pending_refill.set(1);
-      *pending = true;
-      return NULL;
+      mshr->pending = true;
+      mshr->prefetch = req == NULL;
+      mshr->start_cycles = this->get_cycles();
+      mshr->tag = tag;
+      mshr->line = line;
+      mshr->waiting_first = req;
+      mshr->waiting_last = req;
+      if (req)
+        req->set_next(NULL);
+      this->line_flags[line] |= CACHE_LINE_REFILLING;
+
+      this->nb_pending_mshrs++;
+      if (this->nb_pending_mshrs > this->max_pending_mshrs)
+      {
+        this->max_pending_mshrs = this->nb_pending_mshrs;
+      }
     }
-    else
+    return err;
+  }
+
+  refill_req->arg_pop();
+
+  this->line_tags[line] = tag;
+
+  if (req == NULL)
+  {
+    this->line_flags[line] |= CACHE_LINE_PREFETCHED;
+  }
+
+  *latency = 0;
+
+  if (!is_debug)
+  {
+    // Since we allow synchronous request responses, make sure we report the delay in
+    // the latency in case the MSHR is still supposed to be refilling a line.
+    if (this->get_cycles() < mshr->end_cycles)
     {
-      return NULL;
+        *latency += mshr->end_cycles - this->get_cycles();
     }
+
+    *latency += refill_req->get_full_latency() + this->refill_latency;
+
+    mshr->end_cycles = this->get_cycles() + *latency;
+    this->mshr_busy_cycles += refill_req->get_full_latency() + this->refill_latency;
+
+    this->line_timestamps[line] = this->get_cycles() + *latency;
   }
 
-  line->tag = tag;
+  return vp::IO_REQ_OK;
+}
 
-  if (!req->is_debug())
+
+
+void Cache::prefetch(uint32_t tag)
+{
+  unsigned int line_index = tag & (this->nb_sets - 1);
+  uint32_t *tags = &this->line_tags[line_index*this->nb_ways];
+
+  // Nothing to do if the line is already there or on its way
+  for (int i=0; i<this->nb_ways; i++)
+  {
+    if (tags[i] == tag)
+      return;
+  }
+
+  if (this->mshr_get(tag))
+    return;
+
+  // Prefetches have a lower priority than demand misses. They are dropped if demand
+  // accesses are stalled, and they always leave one MSHR free for demand misses.
+  // MSHRs still busy with a synchronous refill are also counted so that a prefetch
+  // does not delay the next demand miss.
+  int64_t cycles = this->get_cycles();
+  int nb_busy = 0;
+  for (int i=0; i<this->nb_mshrs; i++)
   {
-    // This cache supports only one refill at the same time. Since we allow
-    // synchronous request responses, make sure we report the delay in the latency
-    // in case the cache is still supposed to be reilling a line.
-    int64_t latency = 0;
-    if (this->get_cycles() < this->refill_timestamp)
+    if (this->mshrs[i].pending || this->mshrs[i].end_cycles > cycles)
+      nb_busy++;
+  }
+
+  int line = -1;
+  cache_mshr_t *mshr = NULL;
+  if (this->refill_pending_reqs.empty() && nb_busy < this->nb_mshrs - (this->nb_mshrs > 1))
+  {
+    mshr = this->mshr_alloc();
+    if (mshr)
     {
-        latency += this->refill_timestamp - this->get_cycles();
+      line = this->get_victim(line_index);
     }
+  }
 
-    latency += refill_req->get_full_latency() + this->refill_latency;
-
-    this->refill_timestamp = this->get_cycles() + latency;
+  if (line == -1)
+  {
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Dropping prefetch, no resource available (line: 0x%x)\n", tag);
+    this->nb_prefetch_drops++;
+    return;
+  }
 
-    req->inc_latency(latency);
+  this->nb_prefetches++;
 
-    line->timestamp = this->get_cycles() + latency;
+  int64_t latency;
+  vp::io_req_status_e err = this->send_refill(mshr, line, tag, NULL, &latency);
+  if (err != vp::IO_REQ_OK && err != vp::IO_REQ_PENDING)
+  {
+    this->trace.msg(vp::trace::LEVEL_DEBUG, "Prefetch failed (line: 0x%x)\n", tag);
   }
+}
 
-  return line;
+
+
+void Cache::prefetch_train(uint32_t tag, bool miss, bool prefetch_hit)
+{
+  this->prefetch_lines.clear();
+  this->prefetcher->access(tag, miss, prefetch_hit, this->prefetch_lines);
+
+  for (uint32_t line: this->prefetch_lines)
+  {
+    this->prefetch(line);
+  }
 }
 
 
@@ -394,9 +825,13 @@ void Cache::flush_line(unsigned int addr)
   unsigned int line_index = this->get_line_index(addr);
   for (int i=0; i<this->nb_ways; i++)
   {
-    cache_line_t *line = &this->lines[line_index*this->nb_ways + i];
-    if (line->tag == tag)
-      line->tag= -1;
+    int line = line_index*this->nb_ways + i;
+    if (this->line_tags[line] == tag)
+    {
+      this->write_back_line(line);
+      this->line_tags[line] = -1;
+      this->line_flags[line] &= ~CACHE_LINE_PREFETCHED;
+    }
   }
 }
 
@@ -405,12 +840,11 @@ void Cache::flush_line(unsigned int addr)
 void Cache::flush()
 {
   this->trace.msg(vp::trace::LEVEL_INFO, "Flushing whole cache\n");
-  for (int i=0; i<this->nb_sets; i++)
+  for (int line=0; line<this->nb_lines; line++)
   {
-    for (int j=0; j<this->nb_ways; j++)
-    {
-      this->lines[i*this->nb_ways+j].tag = -1;;
-    }
+    this->write_back_line(line);
+    this->line_tags[line] = -1;
+    this->line_flags[line] &= ~CACHE_LINE_PREFETCHED;
   }
 
   if (this->flush_ack_itf.is_bound())
@@ -429,10 +863,9 @@ void Cache::enable(bool enable) {
     this->trace.msg(vp::trace::LEVEL_INFO, "Disabling cache\n");
 }
 
-cache_line_t *Cache::get_line(vp::io_req *req, unsigned int *line_index, unsigned int *tag)
+int Cache::get_line(vp::io_req *req, unsigned int *line_index, unsigned int *tag)
 {
     uint64_t offset = req->get_addr();
-    uint8_t *data = req->get_data();
     uint64_t size = req->get_size();
     bool is_write = req->get_is_write();
 
@@ -444,46 +877,87 @@ cache_line_t *Cache::get_line(vp::io_req *req, unsigned int *line_index, unsigne
     *line_index = *tag & (nb_sets - 1);
     unsigned int line_offset = offset & (line_size - 1);
 
-    cache_line_t *hit_line = NULL;
-
     this->trace.msg(vp::trace::LEVEL_TRACE, "Cache access (is_write: %d, offset: 0x%x, size: 0x%x, tag: 0x%x, line_index: %d, line_offset: 0x%x)\n", is_write, offset, size, offset, *line_index, line_offset);
 
-    cache_line_t *line = &this->lines[*line_index*nb_ways];
+    int first_line = *line_index*nb_ways;
+    uint32_t *tags = &this->line_tags[first_line];
 
     for (int i=0; i<nb_ways; i++)
     {
-        if (line->tag == *tag)
+        if (tags[i] == *tag)
         {
             this->trace.msg(vp::trace::LEVEL_TRACE, "Cache hit (way: %d)\n", i);
-            hit_line = line;
-            break;
+            return first_line + i;
         }
-        line++;
     }
 
-    return hit_line;
+    return -1;
+}
+
+
+
+void Cache::line_access(int line, vp::io_req *req)
+{
+  uint8_t *data = req->get_data();
+
+  if (req->get_is_write() && this->write_back)
+  {
+    this->line_flags[line] |= CACHE_LINE_DIRTY;
+  }
+
+  if (data)
+  {
+    uint8_t *line_data = this->get_line_data(line) + (req->get_addr() & this->line_offset_mask);
+
+    if (!req->get_is_write()) {
+      memcpy(data, (void *)line_data, req->get_size());
+    } else {
+      memcpy((void *)line_data, data, req->get_size());
+    }
+  }
 }
 
 
 
-vp::io_req_status_e Cache::handle_req(vp::io_req *req)
+vp::io_req_status_e Cache::handle_req(vp::io_req *req, bool replay)
 {
   unsigned int line_index;
   unsigned int tag;
   uint64_t offset = req->get_addr();
-  uint8_t *data = req->get_data();
-  uint64_t size = req->get_size();
-  bool is_write = req->get_is_write();
-  cache_line_t *hit_line = this->get_line(req, &line_index, &tag);
+  int hit_line = this->get_line(req, &line_index, &tag);
+  bool miss = hit_line == -1;
+  bool prefetch_hit = false;
+  bool train = false;
 
-  if (hit_line == NULL)
+  if (miss)
   {
     this->trace.msg(vp::trace::LEVEL_DEBUG, "Cache miss\n");
     this->refill_event.event((uint8_t *)&offset);
     bool pending = false;
-    hit_line = this->refill(line_index, offset, tag, req, &pending);
-    if (hit_line == NULL)
+    bool stalled = false;
+
+    // A miss on a line being prefetched is still a hit for the prefetcher
+    cache_mshr_t *mshr = this->prefetcher ? this->mshr_get(tag) : NULL;
+    prefetch_hit = mshr && mshr->prefetch;
+
+    hit_line = this->refill(line_index, offset, tag, req, &pending, &stalled, replay);
+
+    // Stalled requests are accounted when they are replayed
+    if (!stalled)
+    {
+      this->nb_misses++;
+      train = this->prefetcher && !req->is_debug();
+    }
+
+    if (hit_line == -1)
     {
+      // The line is either not allocated or protected by its refilling flag, so the
+      // prefetches can not evict it
+      if (train)
+      {
+        this->prefetch_train(tag, true, prefetch_hit);
+      }
+
       if (pending)
         return vp::IO_REQ_PENDING;
       else
@@ -492,25 +966,39 @@ vp::io_req_status_e Cache::handle_req(vp::io_req *req)
   }
   else
   {
+    this->nb_hits++;
+
     // In case we hit the line, the line might have been refilled synchronously.
     // If so we need to apply the time taken by the refill.
     if (!req->is_debug())
     {
-      if (this->get_cycles() < hit_line->timestamp)
+      if (this->get_cycles() < this->line_timestamps[hit_line])
+      {
+        req->inc_latency(this->line_timestamps[hit_line] - this->get_cycles());
+      }
+
+      prefetch_hit = this->line_flags[hit_line] & CACHE_LINE_PREFETCHED;
+      if (prefetch_hit)
       {
-        req->inc_latency(hit_line->timestamp - this->get_cycles());
+        this->line_flags[hit_line] &= ~CACHE_LINE_PREFETCHED;
+        this->nb_prefetch_useful++;
+        if (this->get_cycles() < this->line_timestamps[hit_line])
+        {
+          this->nb_prefetch_late++;
+        }
       }
+
+      train = this->prefetcher != NULL;
     }
   }
 
-  if (data)
+  this->line_access(hit_line, req);
+
+  // The prefetcher is only trained once the access is done, as the prefetches it
+  // triggers may evict the accessed line and refill it with another one
+  if (train)
   {
-    if (!is_write) {
-      memcpy(data, (void *)hit_line->data, size);
-    } else {
-      //hitLine->setDirty();
-      memcpy((void *)hit_line->data, data, size);
-    }
+    this->prefetch_train(tag, miss, prefetch_hit);
   }
 
   return vp::IO_REQ_OK;
@@ -603,7 +1091,7 @@ void Cache::flush_line_addr_sync(void *__this, uint32_t addr)
 
 
 Cache::Cache(js::config *config)
-: vp::component(config), refill_pending_reqs(this), pending_refill(this, 0)
+: vp::component(config), refill_pending_reqs(this)
 {
 
 }
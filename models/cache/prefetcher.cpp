@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#include "prefetcher.hpp"
+
+
+
+// Fetch the next lines after each miss, and after each first access to a prefetched
+// line so that a sequential stream stays ahead of the demand accesses.
+class Next_line_prefetcher : public Cache_prefetcher
+{
+public:
+  Next_line_prefetcher(int degree) : degree(degree) {}
+
+  void access(uint32_t line, bool miss, bool prefetch_hit, std::vector<uint32_t> &lines)
+  {
+    if (miss || prefetch_hit)
+    {
+      for (int i=1; i<=this->degree; i++)
+      {
+        lines.push_back(line + i);
+      }
+    }
+  }
+
+private:
+  int degree;
+};
+
+
+
+// Track up to table_size access streams, each one with the last accessed line and the
+// last observed stride. A stream is matched by an access which is at most max_distance
+// lines away from its last line. Once the same stride has been seen twice in a row,
+// the next lines of the stream are prefetched.
+class Stride_prefetcher : public Cache_prefetcher
+{
+public:
+  Stride_prefetcher(int degree, int table_size) : degree(degree), entries(table_size) {}
+
+  void access(uint32_t line, bool miss, bool prefetch_hit, std::vector<uint32_t> &lines)
+  {
+    stride_entry_t *matched = NULL;
+    stride_entry_t *victim = NULL;
+
+    this->timestamp++;
+
+    for (stride_entry_t &entry: this->entries)
+    {
+      if (entry.valid)
+      {
+        int32_t stride = line - entry.last_line;
+
+        // Other accesses to the same line do not bring any information
+        if (stride == 0)
+        {
+          entry.lru = this->timestamp;
+          return;
+        }
+
+        if (stride >= -max_distance && stride <= max_distance)
+        {
+          // Prefer a stream which is confirmed by this access
+          if (matched == NULL || stride == entry.stride)
+          {
+            matched = &entry;
+          }
+        }
+      }
+
+      if (victim == NULL || !entry.valid || (victim->valid && entry.lru < victim->lru))
+      {
+        victim = &entry;
+      }
+    }
+
+    if (matched == NULL)
+    {
+      if (victim)
+      {
+        victim->valid = true;
+        victim->last_line = line;
+        victim->stride = 0;
+        victim->confidence = 0;
+        victim->lru = this->timestamp;
+      }
+      return;
+    }
+
+    int32_t stride = line - matched->last_line;
+    if (stride == matched->stride)
+    {
+      if (matched->confidence < 3)
+        matched->confidence++;
+    }
+    else
+    {
+      matched->stride = stride;
+      matched->confidence = 0;
+    }
+
+    matched->last_line = line;
+    matched->lru = this->timestamp;
+
+    if (matched->confidence >= 1)
+    {
+      for (int i=1; i<=this->degree; i++)
+      {
+        lines.push_back(line + i*stride);
+      }
+    }
+  }
+
+private:
+  static const int32_t max_distance = 64;
+
+  typedef struct
+  {
+    bool valid = false;
+    uint32_t last_line;
+    int32_t stride;
+    int confidence;
+    int64_t lru;
+  } stride_entry_t;
+
+  int degree;
+  std::vector<stride_entry_t> entries;
+  int64_t timestamp = 0;
+};
+
+
+
+// Stream buffers, as described by Jouppi. A miss which does not belong to any stream
+// allocates one, in LRU order. Once a second miss or a prefetched line hit confirms the
+// stream, the stream is kept degree lines ahead of the demand accesses.
+// Only ascending streams are detected.
+class Stream_prefetcher : public Cache_prefetcher
+{
+public:
+  Stream_prefetcher(int degree, int table_size) : degree(degree), streams(table_size) {}
+
+  void access(uint32_t line, bool miss, bool prefetch_hit, std::vector<uint32_t> &lines)
+  {
+    if (!miss && !prefetch_hit)
+      return;
+
+    stream_t *victim = NULL;
+
+    this->timestamp++;
+
+    for (stream_t &stream: this->streams)
+    {
+      if (stream.valid && line > stream.last_line && line <= stream.prefetched_until + 1)
+      {
+        uint32_t first = stream.prefetched_until + 1;
+        if (first <= line)
+          first = line + 1;
+
+        stream.last_line = line;
+        stream.prefetched_until = line + this->degree;
+        stream.lru = this->timestamp;
+
+        for (uint32_t prefetch_line=first; prefetch_line<=stream.prefetched_until; prefetch_line++)
+        {
+          lines.push_back(prefetch_line);
+        }
+        return;
+      }
+
+      if (victim == NULL || !stream.valid || (victim->valid && stream.lru < victim->lru))
+      {
+        victim = &stream;
+      }
+    }
+
+    if (miss && victim)
+    {
+      victim->valid = true;
+      victim->last_line = line;
+      victim->prefetched_until = line;
+      victim->lru = this->timestamp;
+    }
+  }
+
+private:
+  typedef struct
+  {
+    bool valid = false;
+    uint32_t last_line;
+    uint32_t prefetched_until;
+    int64_t lru;
+  } stream_t;
+
+  int degree;
+  std::vector<stream_t> streams;
+  int64_t timestamp = 0;
+};
+
+
+
+Cache_prefetcher *Cache_prefetcher::create(std::string name, int degree, int table_size)
+{
+  if (degree <= 0)
+    degree = 1;
+  if (table_size <= 0)
+    table_size = 1;
+
+  if (name == "next_line")
+    return new Next_line_prefetcher(degree);
+  else if (name == "stride")
+    return new Stride_prefetcher(degree, table_size);
+  else if (name == "stream")
+    return new Stream_prefetcher(degree, table_size);
+
+  return NULL;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __CACHE_PREFETCHER_HPP__
+#define __CACHE_PREFETCHER_HPP__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Prefetcher which can be attached to the cache.
+// The cache reports every demand access with the address of the accessed line (address
+// divided by the line size), and the prefetcher returns the lines which should be fetched.
+// The cache is then free to drop them, for example if no refill resource is available.
+class Cache_prefetcher
+{
+public:
+  virtual ~Cache_prefetcher() {}
+
+  // Called for every demand access. miss is true if the line was not in the cache,
+  // prefetch_hit is true if the access is the first one to a line brought by a prefetch.
+  // The lines to be prefetched are appended to lines.
+  virtual void access(uint32_t line, bool miss, bool prefetch_hit, std::vector<uint32_t> &lines) = 0;
+
+  // Instantiate the prefetcher from its name ("next_line", "stride" or "stream"),
+  // returns NULL if the name is unknown
+  static Cache_prefetcher *create(std::string name, int degree, int table_size);
+};
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __CPU_ISS_ISS_COVERAGE_HPP
+#define __CPU_ISS_ISS_COVERAGE_HPP
+
+// Instruction and branch coverage.
+// Instructions which are not yet fully covered get their handlers replaced by
+// stubs recording the coverage flags. Once an instruction is fully covered (executed,
+// and for branches, both taken and not taken), its original handlers are restored
+// so that coverage has no cost anymore on it.
+
+void iss_coverage_init(iss_t *iss, bool active);
+void iss_coverage_insn_init(iss_t *iss, iss_insn_t *insn);
+int iss_coverage_dump(iss_t *iss, const char *path);
+
+#endif
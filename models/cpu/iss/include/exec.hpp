@@ -27,6 +27,7 @@ void update_external_pccr(iss_t *iss, int id, unsigned int pcer, unsigned int pc
 #endif
 
 static inline int iss_exec_account_cycles(iss_t *iss, int cycles);
+static inline int hwloop_exec_fast(iss_t *iss, int index, int max_cycles);
 
 iss_insn_t *iss_exec_insn_with_trace(iss_t *iss, iss_insn_t *insn);
 void iss_trace_dump(iss_t *iss, iss_insn_t *insn);
@@ -103,6 +104,36 @@ static inline int iss_exec_step_nofetch(iss_t *iss)
   return iss->cpu.state.insn_cycles;
 }
 
+// Same as iss_exec_step_nofetch but, when the instruction has just jumped back
+// to the beginning of a HW loop, directly executes the following iterations
+// from the pre-resolved loop body, within the configured cycle budget.
+static inline int iss_exec_step_nofetch_hwloop(iss_t *iss)
+{
+  int cycles = iss_exec_step_nofetch(iss);
+
+  if (iss->stalled.get() || !iss_hwloop_fast_active(iss))
+    return cycles;
+
+  for (int i=0; i<2; i++)
+  {
+    if (iss->cpu.prev_insn == iss->cpu.state.hwloop_end_insn[i] &&
+      iss->cpu.current_insn == iss->cpu.state.hwloop_start_insn[i])
+    {
+      cycles += hwloop_exec_fast(iss, i, iss->cpu.state.hwloop_fast_cycles);
+
+      // The cycles are not enqueued when the core stalls in the middle of the batch,
+      // they are instead applied when it is woken up, as the instructions of the batch
+      // are all executed at the time of its start
+      if (iss->stalled.get())
+        iss_exec_add_wakeup_latency(iss, cycles);
+
+      return cycles;
+    }
+  }
+
+  return cycles;
+}
+
 static inline int iss_exec_step(iss_t *iss)
 {
   return iss_exec_step_nofetch(iss);
@@ -68,6 +68,7 @@ static inline iss_isa_set_t *iss_get_isa_set()
 #include "lsu.hpp"
 #include "prefetcher.hpp"
 #include "insn_cache.hpp"
+#include "coverage.hpp"
 #include "irq.hpp"
 #include "exceptions.hpp"
 #include "exec.hpp"
@@ -592,8 +592,14 @@ static inline iss_insn_t *hwloop_check_exec(iss_t *iss, iss_insn_t *insn)
   return insn_next;
 }
 
+static inline void hwloop_body_invalidate(iss_t *iss, int index)
+{
+  iss->cpu.state.hwloop_body[index].size = 0;
+}
+
 static inline void hwloop_set_start(iss_t *iss, iss_insn_t *insn, int index, iss_reg_t start)
 {
+  hwloop_body_invalidate(iss, index);
   iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPSTART(index)] = start;
   iss->cpu.state.hwloop_start_insn[index] = insn_cache_get(iss, start);
 }
@@ -620,6 +626,7 @@ static inline void hwloop_set_end(iss_t *iss, iss_insn_t *insn, int index, iss_r
 {
   iss_insn_t *end_insn = insn_cache_get(iss, end);
 
+  hwloop_body_invalidate(iss, index);
   iss->cpu.state.hwloop_end_insn[index] = end_insn;
 
   hwloop_set_insn_end(iss, end_insn);
@@ -639,6 +646,142 @@ static inline void hwloop_set_all(iss_t *iss, iss_insn_t *insn, int index, iss_r
   hwloop_set_count(iss, insn, index, count);
 }
 
+// Tell if the instruction accesses memory through its operands.
+// All the instructions of a batch are executed at the time of the batch start,
+// so their accesses would reach the memory too early, and a pending access would
+// stop the batch in the middle.
+static inline bool hwloop_insn_is_mem(iss_insn_t *insn)
+{
+  iss_decoder_item_t *item = insn->decoder_item;
+
+  for (int i=0; i<item->u.insn.nb_args; i++)
+  {
+    iss_decoder_arg_type_e type = item->u.insn.args[i].type;
+    if (type == ISS_DECODER_ARG_TYPE_INDIRECT_IMM || type == ISS_DECODER_ARG_TYPE_INDIRECT_REG)
+      return true;
+  }
+
+  return false;
+}
+
+// Resolve the body of the specified HW loop into a dispatch array.
+// This is done once the loop has been executed at least once, so that all
+// the instructions of the body are already decoded. The body is refused if
+// it is not a straight sequence of decoded instructions ending with the
+// loop end instruction, or if it contains memory accesses, in which case the
+// loop is always executed normally.
+static inline int hwloop_body_resolve(iss_t *iss, int index)
+{
+  iss_hwloop_body_t *body = &iss->cpu.state.hwloop_body[index];
+  iss_insn_t *insn = iss->cpu.state.hwloop_start_insn[index];
+  iss_insn_t *end_insn = iss->cpu.state.hwloop_end_insn[index];
+
+  body->size = -1;
+
+  // The end instruction must be decoded, in which case its real handler has been moved
+  // to hwloop_handler. Its handler is not compared to hwloop_check_exec as it is inlined
+  // and thus has a different address in the decoder.
+  if (insn == NULL || end_insn == NULL || end_insn->hwloop_handler == NULL ||
+    end_insn->fast_handler == iss_decode_pc || end_insn->fast_handler == iss_exec_insn_with_trace)
+    return -1;
+
+  for (int i=0; i<ISS_HWLOOP_BODY_MAX_SIZE; i++)
+  {
+    if (insn == end_insn)
+    {
+      if (hwloop_insn_is_mem(insn))
+        return -1;
+
+      body->insns[i] = insn;
+      body->handlers[i] = insn->hwloop_handler;
+      body->size = i + 1;
+      iss_decoder_msg(iss, "Resolved HW loop body (index: %d, size: %d)\n", index, body->size);
+      return 0;
+    }
+
+    // Stop on anything which is not a plain decoded instruction, like not-yet
+    // decoded or traced instructions or nested loop ends.
+    if (insn->fast_handler == iss_decode_pc || insn->fast_handler == iss_exec_insn_with_trace ||
+      insn->hwloop_handler != NULL || insn->next == NULL || hwloop_insn_is_mem(insn))
+      return -1;
+
+    body->insns[i] = insn;
+    body->handlers[i] = insn->fast_handler;
+    insn = insn->next;
+  }
+
+  return -1;
+}
+
+// Execute full iterations of the HW loop whose start instruction is the
+// current one, using the pre-resolved dispatch array. The last iteration is
+// always left to the normal path so that loop exit and loop priorities are
+// handled by hwloop_check_exec. Execution stops as soon as the core stalls,
+// goes inactive, switches to the slow path (interrupt, debug request), leaves
+// the body through a branch or exceeds the cycle budget.
+// Returns the number of cycles spent. As for an instruction executed normally,
+// the cycles of the instruction which stalled are not included, since they are
+// replaced by the stall.
+static inline int hwloop_exec_fast(iss_t *iss, int index, int max_cycles)
+{
+  iss_hwloop_body_t *body = &iss->cpu.state.hwloop_body[index];
+  iss_reg_t *count = &iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPCOUNT(index)];
+  vp::clock_event *event = iss->current_event;
+  int cycles = 0;
+
+  if (body->size == 0)
+    hwloop_body_resolve(iss, index);
+
+  if (body->size < 0)
+    return 0;
+
+  // Loop 0 has priority when both loops end on the same instruction
+  if (index == 1 && iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPCOUNT0] &&
+    iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND0] == iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND1])
+    return 0;
+
+  while (*count > 1 && cycles < max_cycles)
+  {
+    for (int i=0; i<body->size; i++)
+    {
+      iss_insn_t *insn = body->insns[i];
+
+      if (iss->cpu.current_insn != insn)
+        return cycles;
+
+      iss->cpu.state.insn_cycles = 1;
+      if (iss->cpu.state.fetch_cycles)
+      {
+        iss->cpu.state.insn_cycles += iss->cpu.state.fetch_cycles;
+        iss->cpu.state.fetch_cycles = 0;
+      }
+
+      iss_insn_t *next = body->handlers[i](iss, insn);
+
+      if (i == body->size - 1)
+      {
+        (*count)--;
+        next = iss->cpu.state.hwloop_start_insn[index];
+        iss->cpu.state.hwloop_next_insn = next;
+      }
+
+      iss->cpu.current_insn = next;
+      iss->cpu.prev_insn = insn;
+      prefetcher_fetch(iss, next);
+
+      if (iss->stalled.get())
+        return cycles;
+
+      cycles += iss->cpu.state.insn_cycles;
+
+      if (!iss->is_active_reg.get() || iss->current_event != event)
+        return cycles;
+    }
+  }
+
+  return cycles;
+}
+
 static inline iss_insn_t *lp_starti_exec(iss_t *iss, iss_insn_t *insn)
 {
   hwloop_set_start(iss, insn, UIM_GET(0), insn->addr + (UIM_GET(1) << 1));
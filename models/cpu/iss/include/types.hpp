@@ -27,6 +27,7 @@
 #define __STDC_FORMAT_MACROS    // This is needed for some old gcc versions
 #include <inttypes.h>
 #include <vector>
+#include <map>
 #include <string>
 
 #if defined(RISCY)
@@ -99,6 +100,8 @@ class iss;
 #define ISS_MAX_NB_OUT_REGS 3
 #define ISS_MAX_NB_IN_REGS 3
 
+#define ISS_HWLOOP_BODY_MAX_SIZE 16
+
 #define ISS_INSN_BLOCK_SIZE_LOG2 8
 #define ISS_INSN_BLOCK_SIZE (1<<ISS_INSN_BLOCK_SIZE_LOG2)
 #define ISS_INSN_PC_BITS 1
@@ -355,6 +358,10 @@ typedef struct iss_insn_s {
   iss_insn_t *(*saved_handler)(iss_t *, iss_insn_t*);
   iss_insn_t *branch;
 
+  uint8_t coverage;     // Coverage flags already recorded for this instruction
+  iss_insn_t *(*coverage_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*coverage_fast_handler)(iss_t *, iss_insn_t*);
+
   int in_spregs[6];
 
   int latency;
@@ -396,9 +403,19 @@ typedef struct
   };
 } iss_fcsr_t;
 
+// Pre-resolved body of a HW loop, used to execute several iterations
+// without going through the event scheduler for each instruction.
+typedef struct iss_hwloop_body_s {
+  int size;      // Number of instructions, 0 if not resolved yet, -1 if the body can't be cached
+  iss_insn_t *insns[ISS_HWLOOP_BODY_MAX_SIZE];
+  iss_insn_t *(*handlers[ISS_HWLOOP_BODY_MAX_SIZE])(iss_t *, iss_insn_t*);
+} iss_hwloop_body_t;
+
 typedef struct iss_cpu_state_s {
   iss_insn_t *hwloop_start_insn[2];
   iss_insn_t *hwloop_end_insn[2];
+  iss_hwloop_body_t hwloop_body[2];
+  int hwloop_fast_cycles;   // Maximum number of cycles executed at once on HW loop bodies, 0 to disable
 
   iss_addr_t bootaddr;
 
@@ -497,6 +514,21 @@ typedef struct iss_rnnext_s
 } iss_rnnext_t;
 
 
+#define ISS_COVERAGE_EXECUTED   (1<<0)
+#define ISS_COVERAGE_TAKEN      (1<<1)
+#define ISS_COVERAGE_NOT_TAKEN  (1<<2)
+#define ISS_COVERAGE_BRANCH     (1<<3)
+
+#define ISS_COVERAGE_PAGE_BITS  12
+#define ISS_COVERAGE_PAGE_SIZE  (1<<ISS_COVERAGE_PAGE_BITS)
+
+// Coverage flags of all executed instructions, kept outside of the instruction cache
+// so that they survive cache flushes. One byte per half-word, allocated by pages.
+typedef struct iss_coverage_s {
+  bool active;
+  std::map<iss_addr_t, uint8_t *> pages;
+} iss_coverage_t;
+
 typedef struct iss_cpu_s {
   iss_prefetcher_t decode_prefetcher;
   iss_prefetcher_t prefetcher;
@@ -513,6 +545,7 @@ typedef struct iss_cpu_s {
   iss_pulpv2_t pulpv2;
   iss_pulp_nn_t pulp_nn;
   iss_rnnext_t rnnext;
+  iss_coverage_t coverage;
   std::vector<iss_resource_instance_t *>resources;     // When accesses to the resources are scheduled statically, this gives the instance allocated to this core for each resource
 } iss_cpu_t;
 
@@ -52,6 +52,18 @@ class Iss(st.Component):
         starts it (default: False).
     boot_addr : int, optional
         Address of the first instruction (default: 0)
+    hwloop_fast_cycles : int, optional
+        Maximum number of cycles that the ISS can execute at once on the body of a HW loop, without
+        going through the event scheduler for each instruction. This speeds-up loop-intensive code
+        but lets the core run ahead of other components by up to this amount of cycles. 0 disables
+        it (default: 0).
+    io_trace : str, optional
+        Path to a file where all data and fetch accesses are recorded with their latency, so that they
+        can be replayed later on with utils.io_trace_replay. Empty to disable (default: '').
+    coverage : str, optional
+        Path to a file where instruction and branch coverage is dumped at the end of the simulation.
+        It can be merged with other runs and converted to lcov with gvsoc-coverage. Empty to disable
+        (default: '').
     
     """
 
@@ -71,7 +83,10 @@ class Iss(st.Component):
             cluster_id: int=0,
             core_id: int=0,
             fetch_enable: bool=False,
-            boot_addr: int=0):
+            boot_addr: int=0,
+            hwloop_fast_cycles: int=0,
+            io_trace: str='',
+            coverage: str=''):
 
         super(Iss, self).__init__(parent, name)
 
@@ -93,6 +108,9 @@ class Iss(st.Component):
             'core_id': core_id,
             'fetch_enable': fetch_enable,
             'boot_addr': boot_addr,
+            'hwloop_fast_cycles': hwloop_fast_cycles,
+            'io_trace': io_trace,
+            'coverage': coverage,
         })
 
 
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+#include "iss.hpp"
+#include <string.h>
+
+#define ISS_COVERAGE_MAGIC "GVCOV1\n"
+
+static iss_insn_t *iss_coverage_exec(iss_t *iss, iss_insn_t *insn);
+static iss_insn_t *iss_coverage_exec_fast(iss_t *iss, iss_insn_t *insn);
+
+
+static uint8_t *iss_coverage_get(iss_t *iss, iss_addr_t addr)
+{
+  iss_coverage_t *coverage = &iss->cpu.coverage;
+  iss_addr_t page_base = addr & ~(ISS_COVERAGE_PAGE_SIZE - 1);
+  uint8_t *page;
+
+  auto it = coverage->pages.find(page_base);
+  if (it == coverage->pages.end())
+  {
+    page = new uint8_t[ISS_COVERAGE_PAGE_SIZE >> ISS_INSN_PC_BITS];
+    memset(page, 0, ISS_COVERAGE_PAGE_SIZE >> ISS_INSN_PC_BITS);
+    coverage->pages[page_base] = page;
+  }
+  else
+  {
+    page = it->second;
+  }
+
+  return &page[(addr & (ISS_COVERAGE_PAGE_SIZE - 1)) >> ISS_INSN_PC_BITS];
+}
+
+
+static inline bool iss_coverage_is_full(uint8_t flags)
+{
+  if (!(flags & ISS_COVERAGE_EXECUTED))
+    return false;
+
+  if (flags & ISS_COVERAGE_BRANCH)
+    return (flags & (ISS_COVERAGE_TAKEN | ISS_COVERAGE_NOT_TAKEN)) == (ISS_COVERAGE_TAKEN | ISS_COVERAGE_NOT_TAKEN);
+
+  return true;
+}
+
+
+// Put back the original handlers wherever the stubs are still referenced
+static void iss_coverage_insn_restore(iss_t *iss, iss_insn_t *insn)
+{
+  if (insn->handler == iss_coverage_exec)
+    insn->handler = insn->coverage_handler;
+  if (insn->fast_handler == iss_coverage_exec_fast)
+    insn->fast_handler = insn->coverage_fast_handler;
+  if (insn->hwloop_handler == iss_coverage_exec)
+    insn->hwloop_handler = insn->coverage_handler;
+}
+
+
+static inline void iss_coverage_update(iss_t *iss, iss_insn_t *insn, iss_insn_t *next)
+{
+  uint8_t flags = insn->coverage | ISS_COVERAGE_EXECUTED;
+
+  if (flags & ISS_COVERAGE_BRANCH)
+  {
+    if (next == insn->branch)
+      flags |= ISS_COVERAGE_TAKEN;
+    if (next == insn->next)
+      flags |= ISS_COVERAGE_NOT_TAKEN;
+  }
+
+  if (flags != insn->coverage)
+  {
+    insn->coverage = flags;
+    *iss_coverage_get(iss, insn->addr) |= flags;
+
+    if (iss_coverage_is_full(flags))
+    {
+      iss_coverage_insn_restore(iss, insn);
+    }
+  }
+}
+
+
+static iss_insn_t *iss_coverage_exec(iss_t *iss, iss_insn_t *insn)
+{
+  iss_insn_t *next = iss_exec_insn_handler(iss, insn, insn->coverage_handler);
+  iss_coverage_update(iss, insn, next);
+  return next;
+}
+
+
+static iss_insn_t *iss_coverage_exec_fast(iss_t *iss, iss_insn_t *insn)
+{
+  iss_insn_t *next = iss_exec_insn_handler(iss, insn, insn->coverage_fast_handler);
+  iss_coverage_update(iss, insn, next);
+  return next;
+}
+
+
+void iss_coverage_insn_init(iss_t *iss, iss_insn_t *insn)
+{
+  uint8_t *flags = iss_coverage_get(iss, insn->addr);
+
+  // Conditional branches are the only instructions with a branch target
+  if (insn->branch)
+    *flags |= ISS_COVERAGE_BRANCH;
+
+  insn->coverage = *flags;
+
+  if (!iss_coverage_is_full(insn->coverage))
+  {
+    insn->coverage_handler = insn->handler;
+    insn->coverage_fast_handler = insn->fast_handler;
+    insn->handler = iss_coverage_exec;
+    insn->fast_handler = iss_coverage_exec_fast;
+  }
+}
+
+
+void iss_coverage_init(iss_t *iss, bool active)
+{
+  iss->cpu.coverage.active = active;
+}
+
+
+// The file is made of a magic string followed by all pages. Each page is its base
+// address followed by one byte of flags per half-word. Files from several runs can
+// be merged by OR-ing the flags of identical pages.
+int iss_coverage_dump(iss_t *iss, const char *path)
+{
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+    return -1;
+
+  int err = fwrite(ISS_COVERAGE_MAGIC, strlen(ISS_COVERAGE_MAGIC), 1, file) != 1;
+
+  for (auto page: iss->cpu.coverage.pages)
+  {
+    uint64_t base = page.first;
+    err |= fwrite(&base, sizeof(base), 1, file) != 1;
+    err |= fwrite(page.second, ISS_COVERAGE_PAGE_SIZE >> ISS_INSN_PC_BITS, 1, file) != 1;
+  }
+
+  fclose(file);
+
+  return err ? -1 : 0;
+}
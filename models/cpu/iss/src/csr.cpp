@@ -905,6 +905,12 @@ static bool hwloop_read(iss_t *iss, int reg, iss_reg_t *value) {
 static bool hwloop_write(iss_t *iss, int reg, unsigned int value) {
   iss->cpu.pulpv2.hwloop_regs[reg] = value;
 
+  // Any change of the loop bounds invalidates the resolved loop body
+  if (reg == PULPV2_HWLOOP_LPSTART0 || reg == PULPV2_HWLOOP_LPEND0)
+    hwloop_body_invalidate(iss, 0);
+  else if (reg == PULPV2_HWLOOP_LPSTART1 || reg == PULPV2_HWLOOP_LPEND1)
+    hwloop_body_invalidate(iss, 1);
+
   // Since the HW loop is using decode instruction for the HW loop start to jump faster
   // we need to recompute it when it is modified.
   if (reg == 0)
@@ -210,6 +210,7 @@ static int decode_insn(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_de
   }
 
   insn->next = insn_cache_get(iss, insn->addr + insn->size);
+  insn->branch = NULL;
 
   if (item->u.insn.decode != NULL)
   {
@@ -331,6 +332,11 @@ iss_insn_t *iss_decode_pc_noexec(iss_t *iss, iss_insn_t *insn)
     insn->fast_handler = iss_exec_insn_with_trace;
   }
 
+  if (iss->cpu.coverage.active)
+  {
+    iss_coverage_insn_init(iss, insn);
+  }
+
   return insn;
 }
 
@@ -117,6 +117,9 @@ void iss_cache_flush(iss_t *iss)
 
   flush_cache(iss, &iss->cpu.insn_cache);
 
+  hwloop_body_invalidate(iss, 0);
+  hwloop_body_invalidate(iss, 1);
+
   if (iss->cpu.current_insn)
   {
     iss->cpu.current_insn = insn_cache_get(iss, current_addr);
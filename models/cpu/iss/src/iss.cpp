@@ -298,6 +298,8 @@ int iss_open(iss_t *iss)
   iss->cpu.state.fetch_cycles = 0;
   iss->cpu.state.hwloop_end_insn[0] = NULL;
   iss->cpu.state.hwloop_end_insn[1] = NULL;
+  iss->cpu.state.hwloop_body[0].size = 0;
+  iss->cpu.state.hwloop_body[1].size = 0;
 
   iss->cpu.state.fcsr.frm = 0;
 
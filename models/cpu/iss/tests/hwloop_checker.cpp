@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+// Test component for the HW loop fast path of the ISS.
+// It is the memory of 2 cores running the same program, one executing HW loops normally
+// (hwloop_fast_cycles set to 0) and one executing them by batches. Each core has its own
+// input port for both fetches and data accesses, and all the accesses are answered as
+// pending after latency cycles, in order, so that the cores stall in the middle of the loops.
+// The program ends with a store to the exit address, whose cycle and value are recorded
+// for each core. Once both cores are done, the simulation is stopped with status 0 if they
+// match, and 1 otherwise.
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <queue>
+
+#define HWLOOP_CHECKER_NB_CORES  2
+#define HWLOOP_CHECKER_MEM_SIZE  0x1100
+#define HWLOOP_CHECKER_BOOT_ADDR 0x1000
+#define HWLOOP_CHECKER_DATA_ADDR 0x100
+#define HWLOOP_CHECKER_EXIT_ADDR 0x200
+
+// Program executed by both cores, booting at HWLOOP_CHECKER_BOOT_ADDR, which is not 0 as the
+// empty prefetch buffer would be seen as holding the first line.
+// The performance counters are disabled as they prevent the HW loop fast path, and the loop
+// bodies fit a prefetch line, so that the batches are not stopped by fetches.
+static const uint32_t hwloop_checker_program[] = {
+    0x7a101073,     // 0x1000: csrw     pcmr, zero          Disable the performance counters
+    0x10000513,     // 0x1004: li       a0, 0x100
+    0x00000613,     // 0x1008: li       a2, 0
+    0x0143507b,     // 0x100c: lp.setupi 0, 20, 0x1018
+    0x00052683,     // 0x1010: lw       a3, 0(a0)           Pending load in the loop body
+    0x00160613,     // 0x1014: addi     a2, a2, 1
+    0x00d60633,     // 0x1018: add      a2, a2, a3
+    0x01e3507b,     // 0x101c: lp.setupi 0, 30, 0x1028
+    0x00160613,     // 0x1020: addi     a2, a2, 1
+    0x00260613,     // 0x1024: addi     a2, a2, 2
+    0x00360613,     // 0x1028: addi     a2, a2, 3
+    0x20c02023,     // 0x102c: sw       a2, 0x200(zero)     Exit
+    0x0000006f,     // 0x1030: j        0x1030
+};
+
+
+class Hwloop_checker;
+
+class Hwloop_checker_core
+{
+public:
+    Hwloop_checker *top;
+    uint8_t mem[HWLOOP_CHECKER_MEM_SIZE];
+    std::queue<std::pair<vp::io_req *, int64_t>> pending_reqs;    // Requests with their response cycle
+    vp::clock_event *resp_event;
+    int64_t exit_cycles;
+    uint32_t exit_value;
+};
+
+
+class Hwloop_checker : public vp::component
+{
+
+public:
+    Hwloop_checker(js::config *config);
+
+    int build();
+    void reset(bool active);
+
+private:
+    static vp::io_req_status_e req(void *__this, vp::io_req *req, int id);
+    static void resp_handler(void *__this, vp::clock_event *event);
+    void check();
+
+    vp::trace trace;
+    vp::io_slave input_itf[HWLOOP_CHECKER_NB_CORES];
+    Hwloop_checker_core cores[HWLOOP_CHECKER_NB_CORES];
+    int64_t latency;
+};
+
+
+Hwloop_checker::Hwloop_checker(js::config *config)
+    : vp::component(config)
+{
+}
+
+
+vp::io_req_status_e Hwloop_checker::req(void *__this, vp::io_req *req, int id)
+{
+    Hwloop_checker *_this = (Hwloop_checker *)__this;
+    Hwloop_checker_core *core = &_this->cores[id];
+    uint64_t offset = req->get_addr();
+    uint64_t size = req->get_size();
+
+    _this->trace.msg(vp::trace::LEVEL_TRACE, "Received request (core: %d, offset: 0x%lx, size: 0x%lx, is_write: %d)\n",
+        id, offset, size, req->get_is_write());
+
+    if (offset + size > HWLOOP_CHECKER_MEM_SIZE)
+    {
+        _this->trace.force_warning("Invalid access (core: %d, offset: 0x%lx, size: 0x%lx)\n", id, offset, size);
+        return vp::IO_REQ_INVALID;
+    }
+
+    if (req->get_is_write())
+    {
+        if (offset == HWLOOP_CHECKER_EXIT_ADDR && core->exit_cycles == -1)
+        {
+            core->exit_cycles = _this->get_cycles();
+            memcpy(&core->exit_value, req->get_data(), sizeof(core->exit_value));
+            _this->check();
+        }
+        memcpy(&core->mem[offset], req->get_data(), size);
+    }
+    else
+    {
+        memcpy(req->get_data(), &core->mem[offset], size);
+    }
+
+    core->pending_reqs.push(std::make_pair(req, _this->get_cycles() + _this->latency));
+    if (!core->resp_event->is_enqueued())
+    {
+        _this->event_enqueue(core->resp_event, _this->latency);
+    }
+
+    return vp::IO_REQ_PENDING;
+}
+
+
+void Hwloop_checker::resp_handler(void *__this, vp::clock_event *event)
+{
+    Hwloop_checker_core *core = (Hwloop_checker_core *)__this;
+    Hwloop_checker *top = core->top;
+    vp::io_req *req = core->pending_reqs.front().first;
+
+    core->pending_reqs.pop();
+
+    if (!core->pending_reqs.empty())
+    {
+        top->event_enqueue(core->resp_event, core->pending_reqs.front().second - top->get_cycles());
+    }
+
+    req->get_resp_port()->resp(req);
+}
+
+
+void Hwloop_checker::check()
+{
+    for (int i=0; i<HWLOOP_CHECKER_NB_CORES; i++)
+    {
+        if (this->cores[i].exit_cycles == -1)
+        {
+            return;
+        }
+    }
+
+    bool failed = this->cores[0].exit_cycles != this->cores[1].exit_cycles ||
+        this->cores[0].exit_value != this->cores[1].exit_value;
+
+    printf("HW loop check %s (cycles: %ld / %ld, value: %d / %d)\n", failed ? "failed" : "passed",
+        this->cores[0].exit_cycles, this->cores[1].exit_cycles, this->cores[0].exit_value, this->cores[1].exit_value);
+
+    this->get_clock()->stop_engine(failed);
+}
+
+
+int Hwloop_checker::build()
+{
+    this->traces.new_trace("trace", &this->trace, vp::DEBUG);
+
+    for (int i=0; i<HWLOOP_CHECKER_NB_CORES; i++)
+    {
+        Hwloop_checker_core *core = &this->cores[i];
+
+        core->top = this;
+        core->resp_event = this->event_new(core, &Hwloop_checker::resp_handler);
+
+        this->input_itf[i].set_req_meth_muxed(&Hwloop_checker::req, i);
+        this->new_slave_port("input_" + std::to_string(i), &this->input_itf[i]);
+    }
+
+    this->latency = this->get_js_config()->get_child_int("latency");
+
+    return 0;
+}
+
+
+void Hwloop_checker::reset(bool active)
+{
+    if (active)
+    {
+        for (int i=0; i<HWLOOP_CHECKER_NB_CORES; i++)
+        {
+            Hwloop_checker_core *core = &this->cores[i];
+            uint32_t data = 3;
+
+            memset(core->mem, 0, sizeof(core->mem));
+            memcpy(&core->mem[HWLOOP_CHECKER_BOOT_ADDR], hwloop_checker_program, sizeof(hwloop_checker_program));
+            memcpy(&core->mem[HWLOOP_CHECKER_DATA_ADDR], &data, sizeof(data));
+
+            core->pending_reqs = std::queue<std::pair<vp::io_req *, int64_t>>();
+            core->exit_cycles = -1;
+            core->exit_value = 0;
+        }
+    }
+}
+
+
+extern "C" vp::component *vp_constructor(js::config *config)
+{
+    return new Hwloop_checker(config);
+}
@@ -25,6 +25,7 @@
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
 #include <vp/itf/wire.hpp>
+#include <vp/trace/io_trace.hpp>
 #include "vp/gdbserver/gdbserver_engine.hpp"
 
 
@@ -50,6 +51,7 @@ public:
 
   int build();
   void start();
+  void stop();
   void pre_reset();
   void reset(bool active);
 
@@ -93,6 +95,8 @@ public:
 
   inline void trigger_check_all() { current_event = check_all_event; }
 
+  inline void add_wakeup_latency(int64_t cycles) { wakeup_latency += cycles; }
+
   void insn_trace_callback();
 
   int gdbserver_get_id();
@@ -123,6 +127,12 @@ public:
   vp::io_req     io_req;
   vp::io_req     fetch_req;
 
+  // Stream of data and fetch accesses, only allocated when io_trace is specified
+  vp::Io_trace_writer *io_trace = NULL;
+  int64_t io_trace_data_timestamp;
+  int64_t io_trace_fetch_timestamp;
+  inline void io_trace_dump(vp::io_req *req, int64_t timestamp, int flags, int status);
+
   iss_cpu_t cpu;
 
   vp::trace     trace;
@@ -257,6 +267,18 @@ void iss_wrapper::exec_misaligned(void *__this, vp::clock_event *event)
   }
 }
 
+inline void iss_wrapper::io_trace_dump(vp::io_req *req, int64_t timestamp, int flags, int status)
+{
+  // Latency is expressed in cycles and includes the time spent waiting for the
+  // response in case the request was pending
+  vp::io_trace_record_t record = { .timestamp=timestamp, .addr=req->get_addr(),
+    .latency=(int64_t)req->get_full_latency() + (this->get_time() - timestamp) / this->get_period(),
+    .size=(uint32_t)req->get_size(), .master=(uint16_t)this->cpu.config.mhartid,
+    .flags=(uint8_t)flags, .status=(uint8_t)status
+  };
+  this->io_trace->dump(&record);
+}
+
 inline int iss_wrapper::data_req_aligned(iss_addr_t addr, uint8_t *data_ptr, int size, bool is_write)
 {
   decode_trace.msg("Data request (addr: 0x%lx, size: 0x%x, is_write: %d)\n", addr, size, is_write);
@@ -267,6 +289,13 @@ inline int iss_wrapper::data_req_aligned(iss_addr_t addr, uint8_t *data_ptr, int
   req->set_is_write(is_write);
   req->set_data(data_ptr);
   int err = data.req(req);
+  if (this->io_trace)
+  {
+    if (err == vp::IO_REQ_PENDING)
+      this->io_trace_data_timestamp = this->get_time();
+    else
+      this->io_trace_dump(req, this->get_time(), is_write ? vp::IO_TRACE_FLAGS_WRITE : 0, err);
+  }
   if (err == vp::IO_REQ_OK) 
   {
     this->cpu.state.insn_cycles += req->get_latency();
@@ -93,6 +93,22 @@ static inline bool iss_insn_trace_active(iss_t *iss)
   return iss->insn_trace.get_active();
 }
 
+// HW loop bodies can be executed at once only if nothing needs to observe
+// each instruction individually
+static inline bool iss_hwloop_fast_active(iss_t *iss)
+{
+  return !iss->pc_trace_event.get_event_active() && !iss->active_pc_trace_event.get_event_active() &&
+    !iss->func_trace_event.get_event_active() && !iss->inline_trace_event.get_event_active() &&
+    !iss->file_trace_event.get_event_active() && !iss->line_trace_event.get_event_active() &&
+    !iss->ipc_stat_event.get_event_active() && !iss->power.get_power_trace()->get_active();
+}
+
+// Add cycles to the ones applied when the core is woken up after a stall
+static inline void iss_exec_add_wakeup_latency(iss_t *iss, int cycles)
+{
+  iss->add_wakeup_latency(cycles);
+}
+
 static bool iss_csr_ext_counter_is_bound(iss_t *iss, int id)
 {
   return iss->ext_counter[id].is_bound();
@@ -163,6 +179,13 @@ static inline int iss_fetch_req(iss_t *_this, uint64_t addr, uint8_t *data, uint
   req->set_is_write(is_write);
   req->set_data(data);
   vp::io_req_status_e err = _this->fetch.req(req);
+  if (_this->io_trace)
+  {
+    if (err == vp::IO_REQ_PENDING)
+      _this->io_trace_fetch_timestamp = _this->get_time();
+    else
+      _this->io_trace_dump(req, _this->get_time(), vp::IO_TRACE_FLAGS_FETCH, err);
+  }
   if (err != vp::IO_REQ_OK)
   {
     if (err == vp::IO_REQ_INVALID)
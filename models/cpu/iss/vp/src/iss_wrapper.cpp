@@ -150,7 +150,14 @@ void iss_wrapper::exec_instr(void *__this, vp::clock_event *event)
 {
   iss_t *_this = (iss_t *)__this;
 
-  EXEC_INSTR_COMMON(_this, event, iss_exec_step_nofetch);
+  if (_this->cpu.state.hwloop_fast_cycles)
+  {
+    EXEC_INSTR_COMMON(_this, event, iss_exec_step_nofetch_hwloop);
+  }
+  else
+  {
+    EXEC_INSTR_COMMON(_this, event, iss_exec_step_nofetch);
+  }
 }
 
 void iss_wrapper::exec_instr_check_all(void *__this, vp::clock_event *event)
@@ -205,8 +212,13 @@ void iss_wrapper::data_grant(void *__this, vp::io_req *req)
 void iss_wrapper::data_response(void *__this, vp::io_req *req)
 {
   iss_t *_this = (iss_t *)__this;
+  if (_this->io_trace)
+  {
+    _this->io_trace_dump(req, _this->io_trace_data_timestamp, req->get_is_write() ? vp::IO_TRACE_FLAGS_WRITE : 0, vp::IO_REQ_OK);
+  }
   _this->stalled.dec(1);
-  _this->wakeup_latency = req->get_latency();
+  // Added to the cycles which may have been carried by a HW loop batch
+  _this->wakeup_latency += req->get_latency();
   if (_this->misaligned_access.get())
   {
     _this->misaligned_access.set(false);
@@ -229,6 +241,11 @@ void iss_wrapper::fetch_response(void *__this, vp::io_req *req)
 {
   iss_t *_this = (iss_t *)__this;
 
+  if (_this->io_trace)
+  {
+    _this->io_trace_dump(req, _this->io_trace_fetch_timestamp, vp::IO_TRACE_FLAGS_FETCH, vp::IO_REQ_OK);
+  }
+
   _this->stalled.dec(1);
   if (_this->cpu.state.fetch_stall_callback)
   {
@@ -1452,6 +1469,8 @@ int iss_wrapper::build()
   //transform(isa.begin(), isa.end(), isa.begin(),(int (*)(int))tolower);
   this->cpu.config.isa = strdup(isa.c_str());
   this->cpu.config.debug_handler = this->get_js_config()->get_int("debug_handler");
+  this->cpu.state.hwloop_fast_cycles = this->get_js_config()->get_child_int("hwloop_fast_cycles");
+  iss_coverage_init(this, this->get_js_config()->get_child_str("coverage") != "");
 
   this->is_active_reg.set(false);
 
@@ -1480,6 +1499,17 @@ void iss_wrapper::start()
 
   this->iss_opened = true;
 
+  js::config *io_trace_config = this->get_js_config()->get("io_trace");
+  if (io_trace_config && io_trace_config->get_str() != "")
+  {
+    this->io_trace = new vp::Io_trace_writer(io_trace_config->get_str());
+    if (!this->io_trace->is_open())
+    {
+      this->trace.fatal("Unable to open IO trace file (path: %s, error: %s)\n",
+        io_trace_config->get_str().c_str(), strerror(errno));
+    }
+  }
+
   for (auto x:this->get_js_config()->get("**/debug_binaries")->get_elems())
   {
     iss_register_debug_info(this, x->get_str().c_str());
@@ -1505,6 +1535,26 @@ void iss_wrapper::start()
   }
 }
 
+void iss_wrapper::stop()
+{
+  if (this->cpu.coverage.active)
+  {
+    std::string path = this->get_js_config()->get_child_str("coverage");
+    if (iss_coverage_dump(this, path.c_str()))
+    {
+      this->trace.force_warning("Unable to dump coverage file (path: %s, error: %s)\n", path.c_str(), strerror(errno));
+    }
+  }
+
+  if (this->io_trace)
+  {
+    delete this->io_trace;
+    this->io_trace = NULL;
+  }
+}
+
+
+
 void iss_wrapper::pre_reset()
 {
   if (this->is_active_reg.get())
@@ -24,6 +24,14 @@
 #include <vp/itf/i2c.hpp>
 #include <unistd.h>
 #include <byteswap.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <stdint.h>
 #ifdef __MAGICK__
@@ -61,30 +69,55 @@ class Himax;
 class Camera_stream {
 
 public:
-    Camera_stream(Himax *top, string path, int color_mode, int little);
-    bool fetch_image();
+    Camera_stream(Himax *top, string path, int color_mode, int little, int nb_prefetch_frames);
+    ~Camera_stream();
+    bool open_video(string path);
+    void start();
+    void stop();
     unsigned int get_pixel();
     void set_image_size(int width, int height, int pixel_size);
 
   private:
+    // Decoded image, with one entry per pixel in the format expected by the sensor
+    typedef struct
+    {
+        std::vector<uint32_t> pixels;
+        string error;
+    } frame_t;
+
+    bool decode_image(frame_t *frame);
+    void decode_routine();
+    frame_t *get_frame();
+    void release_frame();
+    unsigned int get_raw_pixel(uint8_t *raw_image, int index);
+
     Himax *top;
     string stream_path;
     int frame_index;
-#ifdef __MAGICK__
-    Image image;
-#endif
     int width;
     int height;
     int pixel_size;
-#ifdef __MAGICK__
-    PixelPacket *image_buffer;
-#endif
     int current_pixel;
     int nb_pixel;
     int color_mode;
-    bool is_raw;
-    uint8_t *raw_image;
     int little;
+
+    // Ring of decoded images. The decoding thread fills it ahead of the simulation, and
+    // the image being sent stays in it until all its pixels are consumed.
+    std::vector<frame_t> frames;
+    int ring_first;
+    int ring_count;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread *decode_thread;
+    bool decode_end;
+    frame_t *current_frame;
+
+    // Pre-converted raw video, mapped into the process, with all the images stored
+    // one after the other
+    uint8_t *video;
+    size_t video_size;
+    int video_nb_frames;
 };
 
 
@@ -97,16 +130,20 @@ public:
 
     int build();
     void start();
+    void stop();
 
 protected:
 
     static void clock_handler(void *__this, vp::clock_event *event);
+    static void line_handler(void *__this, vp::clock_event *event);
     static void i2c_sync(void *__this, int scl, int sda);
+    bool next_byte();
 
     vp::cpi_master cpi_itf;
     vp::i2c_slave i2c_itf;
 
     vp::clock_event *clock_event;
+    vp::clock_event *line_event;
 
     vp::trace trace;
 
@@ -140,19 +177,38 @@ protected:
     uint32_t pixel;
     int pixel_bytes;
 
+    // Bytes of the line being sent, when the receiver accepts whole lines
+    std::vector<uint8_t> line;
+
     Camera_stream *stream;
 };
 
 
 
 
-Camera_stream::Camera_stream(Himax *top, string path, int color_mode, int little)
+Camera_stream::Camera_stream(Himax *top, string path, int color_mode, int little, int nb_prefetch_frames)
  : top(top), stream_path(path), frame_index(0), current_pixel(0), nb_pixel(0), color_mode(color_mode), little(little)
 {
-#ifdef __MAGICK__
-    image_buffer = NULL;
-#endif
-    raw_image = NULL;
+    this->frames.resize(nb_prefetch_frames > 0 ? nb_prefetch_frames : 1);
+    this->ring_first = 0;
+    this->ring_count = 0;
+    this->decode_thread = NULL;
+    this->decode_end = false;
+    this->current_frame = NULL;
+    this->video = NULL;
+    this->video_size = 0;
+    this->video_nb_frames = 0;
+}
+
+
+Camera_stream::~Camera_stream()
+{
+    this->stop();
+
+    if (this->video)
+    {
+        munmap(this->video, this->video_size);
+    }
 }
 
 
@@ -165,40 +221,213 @@ void Camera_stream::set_image_size(int width, int height, int pixel_size)
 }
 
 
-bool Camera_stream::fetch_image()
+bool Camera_stream::open_video(string path)
+{
+    struct stat file_stat;
+    size_t frame_size = this->nb_pixel * this->pixel_size;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        this->top->trace.fatal("Unable to open video file (path: %s, error: %s)\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (fstat(fd, &file_stat) < 0 || frame_size == 0 || file_stat.st_size < (off_t)frame_size)
+    {
+        close(fd);
+        this->top->trace.fatal("Video file is too short (path: %s)\n", path.c_str());
+        return false;
+    }
+
+    this->video_size = file_stat.st_size;
+    this->video = (uint8_t *)mmap(NULL, this->video_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (this->video == MAP_FAILED)
+    {
+        this->video = NULL;
+        this->top->trace.fatal("Unable to map video file (path: %s, error: %s)\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    // Images are consumed in order, this lets the kernel read ahead
+    madvise(this->video, this->video_size, MADV_SEQUENTIAL);
+
+    this->video_nb_frames = this->video_size / frame_size;
+
+    this->top->trace.msg(vp::trace::LEVEL_INFO, "Opened video file (path: %s, nb_frames: %d)\n", path.c_str(), this->video_nb_frames);
+
+    return true;
+}
+
+
+void Camera_stream::start()
+{
+    // Images are decoded in advance only if there is room for more than the image
+    // being sent, otherwise they are decoded synchronously when needed
+    if (this->video == NULL && this->frames.size() > 1)
+    {
+        this->decode_end = false;
+        this->decode_thread = new std::thread(&Camera_stream::decode_routine, this);
+    }
+}
+
+
+void Camera_stream::stop()
+{
+    if (this->decode_thread)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->decode_end = true;
+            this->cond.notify_all();
+        }
+
+        this->decode_thread->join();
+        delete this->decode_thread;
+        this->decode_thread = NULL;
+    }
+}
+
+
+void Camera_stream::decode_routine()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (1)
+    {
+        while (!this->decode_end && this->ring_count == (int)this->frames.size())
+        {
+            this->cond.wait(lock);
+        }
+
+        if (this->decode_end)
+        {
+            break;
+        }
+
+        // The slot after the last decoded image is not seen by the simulation until the
+        // count is incremented, so it can be filled without the lock
+        frame_t *frame = &this->frames[(this->ring_first + this->ring_count) % this->frames.size()];
+
+        lock.unlock();
+        this->decode_image(frame);
+        lock.lock();
+
+        this->ring_count++;
+        this->cond.notify_all();
+    }
+}
+
+
+Camera_stream::frame_t *Camera_stream::get_frame()
+{
+    if (this->decode_thread == NULL)
+    {
+        this->decode_image(&this->frames[0]);
+        return &this->frames[0];
+    }
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (this->ring_count == 0)
+    {
+        this->cond.wait(lock);
+    }
+
+    return &this->frames[this->ring_first];
+}
+
+
+void Camera_stream::release_frame()
+{
+    if (this->decode_thread)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        this->ring_first = (this->ring_first + 1) % this->frames.size();
+        this->ring_count--;
+        this->cond.notify_all();
+    }
+}
+
+
+unsigned int Camera_stream::get_raw_pixel(uint8_t *raw_image, int index)
+{
+    uint8_t *pixel = &raw_image[index*this->pixel_size];
+    unsigned int result = 0;
+
+    for (int i=0; i<this->pixel_size; i++)
+    {
+        result |= pixel[i] << (i*8);
+    }
+
+    if (!this->little)
+    {
+        if (this->pixel_size == 2)
+        {
+            result = ((result & 0xFF00) >> 8) | ((result & 0x00FF) << 8);
+        }
+        else if (this->pixel_size == 3)
+        {
+            result = ((result & 0xFF0000) >> 16) | ((result & 0x00FF00) >> 0) | ((result & 0x0000FF) << 16);
+        }
+    }
+
+    return result;
+}
+
+
+// Called from the decoding thread when it is active, so errors are only recorded in the
+// frame and reported by the simulation when the frame is consumed
+bool Camera_stream::decode_image(frame_t *frame)
 {
     char path[strlen(stream_path.c_str()) + 100];
+    bool is_raw;
+#ifdef __MAGICK__
+    Image image;
+#endif
+
+    frame->error = "";
+    frame->pixels.resize(this->nb_pixel);
+
     while(1)
     {
         sprintf(path, stream_path.c_str(), frame_index);
-        this->is_raw = strstr(path, ".raw") != NULL;
+        is_raw = strstr(path, ".raw") != NULL;
 
-        if (this->is_raw)
+        if (is_raw)
         {
             FILE *file = fopen(path, "r");
             if (file)
             {
                 int size = this->width * this->height * this->pixel_size;
-                int read_size;
+                uint8_t *raw_image = new uint8_t[size];
 
-                this->raw_image = new uint8_t[size];
-                if ((read_size = ::fread(this->raw_image, 1, size, file)) == size)
+                if ((int)::fread(raw_image, 1, size, file) != size)
                 {
+                    delete[] raw_image;
                     fclose(file);
-                    break;
+                    frame->error = "Image file is too short(" + string(path) + ")\n";
+                    return false;
                 }
 
-                delete this->raw_image;
-                this->raw_image = NULL;
                 fclose(file);
-                this->top->trace.fatal("Image file is too short(%s)\n", path);
-                return false;
+
+                for (int i=0; i<this->nb_pixel; i++)
+                {
+                    frame->pixels[i] = this->get_raw_pixel(raw_image, i);
+                }
+
+                delete[] raw_image;
+                break;
             }
 
             if (frame_index == 0)
             {
-              this->top->trace.fatal("Unable to open image file (%s)\n", path);
-              return false;
+                frame->error = "Unable to open image file (" + string(path) + ")\n";
+                return false;
             }
         }
         else
@@ -210,11 +439,13 @@ bool Camera_stream::fetch_image()
           }
           catch( Exception &error_ ) {
               if (frame_index == 0) {
-                  throw;
+                  frame->error = "Unable to open image file (" + string(path) + "): " + error_.what() + "\n";
+                  return false;
               }
           }
 #else
-          this->top->trace.fatal("Trying to open image file while ImageMagick has not been installed, use a raw image instead (with.raw extension) (%s)\n", path);
+          frame->error = "Trying to open image file while ImageMagick has not been installed, use a raw image instead (with.raw extension) (" + string(path) + ")\n";
+          return false;
 #endif
         }
 
@@ -224,7 +455,7 @@ bool Camera_stream::fetch_image()
     //dpi_print(top->handle, ("Opened image (path: " + string(path) + ")").c_str());
     frame_index++;
 
-    if (!this->is_raw)
+    if (!is_raw)
     {
 #ifdef __MAGICK__
         image.extent(Geometry(width, height));
@@ -236,8 +467,24 @@ bool Camera_stream::fetch_image()
             image.quantize( );
         }
 
+        PixelPacket *image_buffer = (PixelPacket*) image.getPixels(0, 0, width, height);
 
-        image_buffer = (PixelPacket*) image.getPixels(0, 0, width, height);
+        for (int i=0; i<this->nb_pixel; i++)
+        {
+            PixelPacket *pixel = &image_buffer[i];
+            unsigned int shift = (sizeof(pixel->red) - 1)*8;
+            if (color_mode == COLOR_MODE_GRAY)
+            {
+                frame->pixels[i] = pixel->red >> shift;
+            }
+            else
+            {
+                unsigned char red = pixel->red >> shift;
+                unsigned char green = pixel->green >> shift;
+                unsigned char blue = pixel->blue >> shift;
+                frame->pixels[i] = (red << 16) | (green << 8) | blue;
+            }
+        }
 #endif
     }
 
@@ -246,71 +493,172 @@ bool Camera_stream::fetch_image()
 
 unsigned int Camera_stream::get_pixel()
 {
-#ifdef __MAGICK__
-    if (image_buffer == NULL && raw_image == NULL) fetch_image();
-#else
-    if (raw_image == NULL) fetch_image();
-#endif
+    unsigned int result;
 
-    if (this->is_raw)
+    if (this->video)
     {
-        unsigned int result;
-
-        result = (*(uint32_t *)&(this->raw_image[current_pixel*this->pixel_size])) & ((1<<(this->pixel_size*8)) - 1);
+        result = this->get_raw_pixel(this->video + (size_t)frame_index * this->nb_pixel * this->pixel_size, current_pixel);
 
-        if (!this->little)
+        current_pixel++;
+        if (current_pixel == nb_pixel)
         {
-            if (this->pixel_size == 2)
-            {
-                result = ((result & 0xFF00) >> 8) | ((result & 0x00FF) << 8);
-            }
-            else if (this->pixel_size == 3)
+            current_pixel = 0;
+            frame_index++;
+            if (frame_index == this->video_nb_frames)
             {
-                result = ((result & 0xFF0000) >> 16) | ((result & 0x00FF00) >> 0) | ((result & 0x0000FF) << 16);
+                frame_index = 0;
             }
         }
+        return result;
+    }
 
-        current_pixel++;
-        if (current_pixel == nb_pixel)
+    if (this->current_frame == NULL)
+    {
+        this->current_frame = this->get_frame();
+
+        if (this->current_frame->error != "")
         {
-            current_pixel = 0;
-            delete this->raw_image;
-            this->raw_image = NULL;
+            this->top->trace.fatal("%s", this->current_frame->error.c_str());
+            this->current_frame = NULL;
+            this->release_frame();
+            return 0;
         }
-        return result;
     }
-    else
+
+    result = this->current_frame->pixels[current_pixel];
+
+    current_pixel++;
+    if (current_pixel == nb_pixel)
     {
-#ifdef __MAGICK__
-        PixelPacket *pixel = &image_buffer[current_pixel];
-        current_pixel++;
-        if (current_pixel == nb_pixel)
+        current_pixel = 0;
+        this->current_frame = NULL;
+        this->release_frame();
+    }
+
+    return result;
+}
+
+
+void Himax::i2c_sync(void *__this, int scl, int sda)
+{
+}
+
+
+// Compute the next byte of the image and move to the next byte position, returns true
+// when this byte is the last one of the line
+bool Himax::next_byte()
+{
+    bool end_of_line = false;
+    int last_byte = 0;
+
+    if (this->color_mode == COLOR_MODE_CUSTOM)
+    {
+        last_byte = this->pixel_size - 1;
+        if (this->stream)
         {
-            current_pixel = 0;
-            image_buffer = NULL;
+            if (this->pixel_bytes == 0)
+            {
+                this->pixel = this->stream->get_pixel();
+                this->pixel_bytes = this->pixel_size;
+            }
+            this->pixel_bytes--;
         }
 
-        unsigned int shift = (sizeof(pixel->red) - 1)*8;
-        if (color_mode == COLOR_MODE_GRAY)
+        this->data = this->pixel & 0xFF;
+        this->pixel >>= 8;
+    }
+    else if (this->color_mode == COLOR_MODE_GRAY)
+    {
+        if (this->stream)
         {
-            return pixel->red >> shift;
+            if (this->pixel_bytes == 0)
+            {
+                this->data = this->stream->get_pixel();
+                this->pixel_bytes = this->pixel_size;
+            }
+            this->pixel_bytes--;
         }
+
+        //if (stimImg != NULL) {
+        //  pixel = ((uint32_t *)stimImg[framesel])[(lineptr*width)+2*colptr+offset];
+        //}
+
+        //data = 0.2989 * ((pixel >> 16) & 0xff) +
+        //       0.5870 * ((pixel >>  8) & 0xff) +
+        //       0.1140 * ((pixel >>  0) & 0xff);
+    }
+    else if (this->color_mode == COLOR_MODE_RAW)
+    {
+      if (this->stream)
+        {
+            if (this->pixel_bytes == 0)
+            {
+                this->pixel = this->stream->get_pixel();
+                this->pixel_bytes = this->pixel_size;
+            }
+            this->pixel_bytes--;
+      }
+
+      // Raw bayer mode. Line 0: BGBG, Line 1: GRGR
+      int line = this->width - this->lineptr -1;
+      if (line & 1)
+      {
+          if (this->colptr & 1)
+              this->data = (this->pixel >> 16) & 0xff;
+          else
+              this->data = (this->pixel >> 8) & 0xff;
+      }
+      else
+      {
+        if (this->colptr & 1)
+            this->data = (this->pixel >> 8) & 0xff;
         else
+            this->data = (this->pixel >> 0) & 0xff;
+      }
+    }
+    else
+    {
+        if (this->stream)
         {
-            unsigned char red = pixel->red >> shift;
-            unsigned char green = pixel->green >> shift;
-            unsigned char blue = pixel->blue >> shift;
-            return (red << 16) | (green << 8) | blue;
+            if (this->pixel_bytes == 0)
+            {
+                this->pixel = this->stream->get_pixel();
+                this->pixel_bytes = this->pixel_size;
+            }
+            this->pixel_bytes--;
         }
-#endif
+
+        //if (stimImg != NULL) {
+        //  ((uint32_t *)stimImg[framesel])[(lineptr*width)+colptr];
+        //}
+
+        // Coded with RGB565
+        if (this->bytesel) this->data = (((this->pixel >> 10) & 0x7) << 5) | (((this->pixel >> 3) & 0x1f) << 0);
+        else         this->data = (((this->pixel >> 19) & 0x1f) << 3) | (((this->pixel >> 13) & 0x7) << 0);
     }
 
-    return 0;
-}
+    if (this->bytesel == last_byte) {
+        this->bytesel = 0;
+        if(this->colptr == (this->width-1)) {
+            this->colptr = 0;
+            end_of_line = true;
+            if(this->lineptr == (this->height-1)) {
+                this->state = STATE_WAIT_EOF;
+                this->cnt = 0;
+                this->targetcnt = 10*TLINE(this->width);
+                this->lineptr = 0;
+            } else {
+                this->lineptr = this->lineptr + 1;
+            }
+        } else {
+            this->colptr = this->colptr + 1;
+        }
 
+    } else {
+        this->bytesel++;
+    }
 
-void Himax::i2c_sync(void *__this, int scl, int sda)
-{
+    return end_of_line;
 }
 
 
@@ -362,115 +710,8 @@ void Himax::clock_handler(void *__this, vp::clock_event *event)
                 break;
 
             case STATE_SEND_LINE: {
-                int last_byte = 0;
-
                 _this->href = _this->hsync_polarity;
-
-                if (_this->color_mode == COLOR_MODE_CUSTOM)
-                {
-                    last_byte = _this->pixel_size - 1;
-                    if (_this->stream)
-                    {
-                        if (_this->pixel_bytes == 0)
-                        {
-                            _this->pixel = _this->stream->get_pixel();
-                            _this->pixel_bytes = _this->pixel_size;
-                        }
-                        _this->pixel_bytes--;
-                    }
-
-                    _this->data = _this->pixel & 0xFF;
-                    _this->pixel >>= 8;
-                }
-                else if (_this->color_mode == COLOR_MODE_GRAY)
-                {
-                    if (_this->stream)
-                    {
-                        if (_this->pixel_bytes == 0)
-                        {
-                            _this->data = _this->stream->get_pixel();
-                            _this->pixel_bytes = _this->pixel_size;
-                        }
-                        _this->pixel_bytes--;
-                    }
-
-                    //if (stimImg != NULL) {
-                    //  pixel = ((uint32_t *)stimImg[framesel])[(lineptr*width)+2*colptr+offset];
-                    //}
-
-                    //data = 0.2989 * ((pixel >> 16) & 0xff) +
-                    //       0.5870 * ((pixel >>  8) & 0xff) +
-                    //       0.1140 * ((pixel >>  0) & 0xff);
-                }
-                else if (_this->color_mode == COLOR_MODE_RAW)
-                {
-                  if (_this->stream)
-                    {
-                        if (_this->pixel_bytes == 0)
-                        {
-                            _this->pixel = _this->stream->get_pixel();
-                            _this->pixel_bytes = _this->pixel_size;
-                        }
-                        _this->pixel_bytes--;
-                  }
-
-                  // Raw bayer mode. Line 0: BGBG, Line 1: GRGR
-                  int line = _this->width - _this->lineptr -1;
-                  if (line & 1)
-                  {
-                      if (_this->colptr & 1)
-                          _this->data = (_this->pixel >> 16) & 0xff;
-                      else
-                          _this->data = (_this->pixel >> 8) & 0xff;
-                  }
-                  else
-                  {
-                    if (_this->colptr & 1)
-                        _this->data = (_this->pixel >> 8) & 0xff;
-                    else
-                        _this->data = (_this->pixel >> 0) & 0xff;
-                  }
-                }
-                else
-                {
-                    if (_this->stream)
-                    {
-                        if (_this->pixel_bytes == 0)
-                        {
-                            _this->pixel = _this->stream->get_pixel();
-                            _this->pixel_bytes = _this->pixel_size;
-                        }
-                        _this->pixel_bytes--;
-                    }
-
-                    //if (stimImg != NULL) {
-                    //  ((uint32_t *)stimImg[framesel])[(lineptr*width)+colptr];
-                    //}
-
-                    // Coded with RGB565
-                    if (_this->bytesel) _this->data = (((_this->pixel >> 10) & 0x7) << 5) | (((_this->pixel >> 3) & 0x1f) << 0);
-                    else         _this->data = (((_this->pixel >> 19) & 0x1f) << 3) | (((_this->pixel >> 13) & 0x7) << 0);
-                }
-
-                if (_this->bytesel == last_byte) {
-                    _this->bytesel = 0;
-                    if(_this->colptr == (_this->width-1)) {
-                        _this->colptr = 0;
-                        if(_this->lineptr == (_this->height-1)) {
-                            _this->state = STATE_WAIT_EOF;
-                            _this->cnt = 0;
-                            _this->targetcnt = 10*TLINE(_this->width);
-                            _this->lineptr = 0;
-                        } else {
-                            _this->lineptr = _this->lineptr + 1;
-                        }
-                    } else {
-                        _this->colptr = _this->colptr + 1;
-                    }
-
-                } else {
-                    _this->bytesel++;
-                }
+                _this->next_byte();
                 _this->trace.msg(vp::trace::LEVEL_DEBUG, "State SEND_LINE (data: 0x%x)\n", _this->data);
                 break;
             }
@@ -497,6 +738,80 @@ void Himax::clock_handler(void *__this, vp::clock_event *event)
 
 
 
+// Used instead of clock_handler when the receiver accepts whole lines. Each step of the
+// frame is done in one event, and the event is then delayed by the number of pixel clock
+// cycles that the step takes in clock_handler.
+void Himax::line_handler(void *__this, vp::clock_event *event)
+{
+    Himax *_this = (Himax *)__this;
+    int64_t cycles = 1;
+
+    switch (_this->state)
+    {
+        case STATE_INIT:
+            _this->trace.msg(vp::trace::LEVEL_DEBUG, "State INIT\n");
+            _this->state = STATE_SOF;
+            _this->bytesel = 0;
+            _this->framesel = 0;
+            break;
+
+        case STATE_SOF:
+            _this->trace.msg(vp::trace::LEVEL_DEBUG, "Starting frame\n");
+            _this->vsync = _this->vsync_polarity;
+            _this->cpi_itf.sync(_this->pclk_value, _this->href, _this->vsync, _this->data);
+            _this->state = STATE_WAIT_SOF;
+            cycles = 3*TLINE(_this->width);
+            break;
+
+        case STATE_WAIT_SOF:
+            _this->trace.msg(vp::trace::LEVEL_DEBUG, "State WAIT_SOF\n");
+            _this->vsync = !_this->vsync_polarity;
+            _this->cpi_itf.sync(_this->pclk_value, _this->href, _this->vsync, _this->data);
+            _this->state = STATE_SEND_LINE;
+            _this->lineptr = 0;
+            _this->colptr = 0;
+            cycles = 17*TLINE(_this->width);
+            break;
+
+        case STATE_SEND_LINE: {
+            _this->href = _this->hsync_polarity;
+            _this->line.clear();
+
+            bool end_of_line;
+            do
+            {
+                end_of_line = _this->next_byte();
+                _this->line.push_back(_this->data);
+            }
+            while (!end_of_line);
+
+            cycles = _this->line.size();
+
+            _this->trace.msg(vp::trace::LEVEL_DEBUG, "State SEND_LINE (size: %d)\n", (int)_this->line.size());
+
+            _this->cpi_itf.sync_line(_this->vsync, _this->line.data(), _this->line.size(), cycles * 2 * _this->get_period());
+            break;
+        }
+
+        case STATE_WAIT_EOF:
+            _this->trace.msg(vp::trace::LEVEL_DEBUG, "State WAIT_EOF\n");
+            _this->href = !_this->hsync_polarity;
+            _this->data = 0;
+            _this->cpi_itf.sync(_this->pclk_value, _this->href, _this->vsync, _this->data);
+            _this->state = STATE_SOF;
+            _this->framesel++;
+            if (_this->framesel == _this->nb_images) _this->framesel = 0;
+            cycles = 10*TLINE(_this->width);
+            break;
+    }
+
+    // Each pixel clock cycle is 2 cycles of this component
+    _this->event_enqueue(_this->line_event, cycles * 2);
+}
+
+
+
+
 int Himax::build()
 {
     traces.new_trace("trace", &trace, vp::DEBUG);
@@ -507,6 +822,7 @@ int Himax::build()
     this->new_slave_port("i2c", &this->i2c_itf);
 
     this->clock_event = this->event_new(this, Himax::clock_handler);
+    this->line_event = this->event_new(this, Himax::line_handler);
 
 #ifdef __MAGICK__
     InitializeMagick(NULL);
@@ -541,7 +857,12 @@ int Himax::build()
             this->color_mode = COLOR_MODE_CUSTOM;
         }
 
-        this->stream = new Camera_stream(this, stream_path.c_str(), this->color_mode, this->little);
+        // Number of images decoded in advance by the decoding thread, including the one
+        // being sent. With 1, images are decoded synchronously when needed.
+        js::config *prefetch_config = get_js_config()->get("prefetch-frames");
+        int nb_prefetch_frames = prefetch_config ? prefetch_config->get_int() : 3;
+
+        this->stream = new Camera_stream(this, stream_path.c_str(), this->color_mode, this->little, nb_prefetch_frames);
 
         if (this->pixel_size == 0)
         {
@@ -559,6 +880,14 @@ int Himax::build()
         }
 
         this->stream->set_image_size(this->width, this->height, this->pixel_size);
+
+        // Optional pre-converted raw video, with all the images in the sensor format one
+        // after the other, used instead of decoding one image file per frame
+        std::string video_path = get_js_config()->get_child_str("video-stream");
+        if (video_path != "")
+        {
+            this->stream->open_video(video_path);
+        }
     }
 
     return 0;
@@ -566,7 +895,20 @@ int Himax::build()
 
 void Himax::start()
 {
-    this->event_enqueue(this->clock_event, 1);
+    if (this->stream)
+    {
+        this->stream->start();
+    }
+
+    if (this->cpi_itf.has_sync_line())
+    {
+        this->trace.msg(vp::trace::LEVEL_INFO, "Sending whole lines\n");
+        this->event_enqueue(this->line_event, 1);
+    }
+    else
+    {
+        this->event_enqueue(this->clock_event, 1);
+    }
 
     this->pclk_value = 0;
     this->state = STATE_INIT;
@@ -578,6 +920,15 @@ void Himax::start()
 }
 
 
+void Himax::stop()
+{
+    if (this->stream)
+    {
+        this->stream->stop();
+    }
+}
+
+
 Himax::Himax(js::config *config)
     : vp::component(config)
 {
@@ -35,6 +35,7 @@
 
 #include <vp/itf/hyper.hpp>
 #include <vp/itf/wire.hpp>
+#include <vp/mem_file.hpp>
 #include <vp/time/time_scheduler.hpp>
 
 // Flash sector size
@@ -133,7 +134,7 @@ private:
      * @param path   Path to the file
      * @param writeback True if the file should be kept synced with the flash array so that.
      */
-    int preload_file(char *path, bool writeback);
+    int preload_file(char *path, bool mapped, bool writeback);
 
     /**
      * @brief Send the next output data
@@ -859,47 +860,24 @@ void Mx25::cs_sync(int cs, int value)
 
 
 
-int Mx25::preload_file(char *path, bool writeback)
+int Mx25::preload_file(char *path, bool mapped, bool writeback)
 {
     this->get_trace()->msg(vp::trace::LEVEL_INFO,
         "Preloading memory with stimuli file (path: %s)\n", path);
 
-    if (writeback)
+    if (mapped)
     {
-        // Writeback mode where the file is kept synced with the flash array so that it is still
-        // available at the end of the simulation.
-
-        // Create a read/write file and map it in the process to directly access the file
-        // from the flash array
-        int fd = open(path, O_RDWR | O_CREAT, 0600);
-        if (fd < 0)
-        {
-            this->trace.force_warning("Unable to open writeback file (path: %s, error: %s)\n",
-                path, strerror(errno));
-            return -1;
-        }
-
-        if (ftruncate(fd, this->size) < 0)
+        // Mapped mode where the flash array is directly mapped on the file. In writeback
+        // mode, the file is kept synced with the flash array so that it is still available
+        // at the end of the simulation. Otherwise it is mapped copy-on-write so that the
+        // file is shared with other simulations using it.
+        this->data = vp::mem_file_map(path, this->size, 0xff, writeback);
+        if (this->data == NULL)
         {
-            this->trace.force_warning("Unable to truncate writeback file (path: %s, error: %s)\n",
-                path, strerror(errno));
-            close(fd);
-            return -1;
-        }
-        this->data = (uint8_t *)mmap(NULL, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-        if (!this->data)
-        {
-            this->trace.force_warning("Unable to mmap writeback file (path: %s, error: %s)\n",
-                path, strerror(errno));
-            close(fd);
+            this->trace.force_warning("Unable to mmap preload file (path: %s, writeback: %d, error: %s)\n",
+                path, writeback, strerror(errno));
             return -1;
         }
-
-        // fd is even not useful anymore and can be closed.
-        // Data are automatically write back to the file
-        // at random time during execution (depending of the kernel cache behavior)
-        // and, anyway, at the termination of the application.
-        close(fd);
     }
     else
     {
@@ -989,6 +967,7 @@ int Mx25::build()
     // Now take care of the flash content
     js::config *preload_file_conf = conf->get("preload_file");
     bool writeback = this->get_js_config()->get_child_bool("writeback");
+    bool mapped = writeback || this->get_js_config()->get_child_bool("mmap_stim_file");
     this->size = conf->get("size")->get_int();
 
     this->trace.msg(vp::trace::LEVEL_INFO, "Building flash (size: 0x%x)\n", this->size);
@@ -996,7 +975,7 @@ int Mx25::build()
     // If there is no preload file or if the preload file is a classi input file,
     // Allocate an array for the flash and fill it with clean state which is 1 everywhere so that
     //. the whole flash can be programmed without being erased.
-    if (!preload_file_conf || !writeback)
+    if (!preload_file_conf || !mapped)
     {
         this->data = new uint8_t[this->size];
         memset(this->data, 0xff, this->size);
@@ -1006,7 +985,7 @@ int Mx25::build()
     // on workstation
     if (preload_file_conf)
     {
-        if (this->preload_file((char *)preload_file_conf->get_str().c_str(), writeback))
+        if (this->preload_file((char *)preload_file_conf->get_str().c_str(), mapped, writeback))
         {
             return -1;
         }
@@ -48,4 +48,5 @@ class Mx25uw6445g(Flash):
         self.add_property('preload_file', self.get_image_path())
 
         self.add_property('writeback', True)
+        self.add_property('mmap_stim_file', False)
         self.add_property('size', size)
@@ -52,6 +52,7 @@ class Hyperflash(Flash):
         self.set_component('devices.hyperbus.hyperflash_impl')
 
         self.add_property('writeback', True)
+        self.add_property('mmap_stim_file', False)
         self.add_property('size', size)
 
         # TODO this is needed by GAPY but is not aligned with the size given to model
@@ -31,6 +31,7 @@
 
 #include <vp/itf/hyper.hpp>
 #include <vp/itf/wire.hpp>
+#include <vp/mem_file.hpp>
 
 #define REGS_AREA_SIZE 1024
 
@@ -44,6 +45,9 @@
 
 #define FLASH_SECTOR_SIZE (1<<18)
 
+// Initial read latency in clock cycles, from the default configuration register
+#define FLASH_READ_LATENCY 16
+
 
 typedef enum {
   HYPERFLASH_STATE_WAIT_CMD0,
@@ -74,6 +78,7 @@ public:
   Hyperflash(js::config *config);
 
   void handle_access(int reg_access, int address, int read, uint8_t data);
+  uint8_t read_byte(int address);
   int preload_file(char *path);
   void erase_sector(unsigned int addr);
   void erase_chip();
@@ -81,6 +86,7 @@ public:
 
   static void sync_cycle(void *_this, int data);
   static void cs_sync(void *__this, int cs, int value);
+  static void burst(void *__this, vp::hyper_burst_t *burst);
 
   int get_nb_word() {return nb_word;}
 
@@ -154,6 +160,28 @@ void Hyperflash::erase_chip()
 
 
 
+uint8_t Hyperflash::read_byte(int address)
+{
+  uint8_t data;
+  if (this->state == HYPERFLASH_STATE_GET_STATUS_REG)
+  {
+    data = this->pending_cmd;
+    this->pending_bytes--;
+    this->pending_cmd >>= 8;
+    if (this->pending_bytes == 0)
+      this->state = HYPERFLASH_STATE_WAIT_CMD0;
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Sending data byte (value: 0x%x)\n", data);
+  }
+  else
+  {
+    data = this->data[address];
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Sending data byte (address: 0x%x, value: 0x%x)\n", address, data);
+  }
+  return data;
+}
+
+
+
 void Hyperflash::handle_access(int reg_access, int address, int read, uint8_t data)
 {
   if (address >= this->size)
@@ -164,22 +192,7 @@ void Hyperflash::handle_access(int reg_access, int address, int read, uint8_t da
   {
     if (read)
     {
-      uint8_t data;
-      if (this->state == HYPERFLASH_STATE_GET_STATUS_REG)
-      {
-        data = this->pending_cmd;
-        this->pending_bytes--;
-        this->pending_cmd >>= 8;
-        if (this->pending_bytes == 0)
-          this->state = HYPERFLASH_STATE_WAIT_CMD0;
-        this->trace.msg(vp::trace::LEVEL_TRACE, "Sending data byte (value: 0x%x)\n", data);
-      }
-      else
-      {
-        data = this->data[address];
-        this->trace.msg(vp::trace::LEVEL_TRACE, "Sending data byte (address: 0x%x, value: 0x%x)\n", address, data);
-      }
-      this->in_itf.sync_cycle(data);
+      this->in_itf.sync_cycle(this->read_byte(address));
     }
     else
     {
@@ -331,33 +344,19 @@ int Hyperflash::preload_file(char *path)
 {
   this->get_trace()->msg(vp::trace::LEVEL_INFO, "Preloading memory with stimuli file (path: %s)\n", path);
 
-  if (this->get_js_config()->get_child_bool("writeback"))
-  {
-    int fd = open(path, O_RDWR | O_CREAT, 0600);
-    if (fd < 0) {
-      printf("Unable to open writeback file (path: %s, error: %s)\n", path, strerror(errno));
-      return 0;
-    }
+  bool writeback = this->get_js_config()->get_child_bool("writeback");
 
-    if (ftruncate(fd, this->size) < 0) {
-      printf("Unable to truncate writeback file (path: %s, error: %s)\n", path, strerror(errno));
-      close(fd);
-      return -1;
-    }
-    this->data = (uint8_t *) mmap(NULL, this->size, PROT_READ | PROT_WRITE, MAP_SHARED , fd, 0);
-    if (!this->data) {
-      printf("Unable to mmap writeback file (path: %s, error: %s)\n", path, strerror(errno));
-      close(fd);
+  if (writeback || this->get_js_config()->get_child_bool("mmap_stim_file"))
+  {
+    // Map the flash array on the file, either copy-on-write so that the file is shared
+    // with other simulations, or shared so that the flash writes are propagated to the file.
+    this->data = vp::mem_file_map(path, this->size, 0xff, writeback);
+    if (this->data == NULL) {
+      printf("Unable to mmap file (path: %s, writeback: %d, error: %s)\n", path, writeback, strerror(errno));
       return -1;
     }
 
-    /*
-    * fd is even not useful anymore and can be closed.
-    * Data are automatically write back to the file
-    * at random time during execution (depending of the kernel cache behavior)
-    * and, anyway, at the termination of the application.
-    */
-    close(fd);
+    this->data_is_mmapped = true;
   }
   else
   {
@@ -401,7 +400,10 @@ int Hyperflash::setup_writeback_file(const char *path)
 
   /* copy the current data content into the mmap area and replace data pointer with the mmap pointer */
   memcpy(mmapped_data, this->data, this->size);
-  free(this->data);
+  if (this->data_is_mmapped)
+    vp::mem_file_unmap(this->data, this->size);
+  else
+    delete[] this->data;
   this->data = mmapped_data;
   this->data_is_mmapped = true;
 
@@ -485,12 +487,65 @@ void Hyperflash::cs_sync(void *__this, int cs, int value)
   }
 }
 
+// The command-address bytes and the writes go through the byte-level state machine,
+// since they only carry commands or small program buffers, while array reads, which
+// are the bulk of the traffic, are done with a single copy.
+void Hyperflash::burst(void *__this, vp::hyper_burst_t *burst)
+{
+  Hyperflash *_this = (Hyperflash *)__this;
+
+  Hyperflash::cs_sync(_this, burst->cs, 1);
+  for (int i=0; i<6; i++)
+  {
+    Hyperflash::sync_cycle(_this, burst->ca[i]);
+  }
+
+  int address = _this->current_address;
+
+  _this->trace.msg(vp::trace::LEVEL_TRACE, "Received burst (reg_access: %d, addr: 0x%x, size: 0x%x, read: %d, duration: %ld)\n",
+    _this->reg_access, address, burst->size, _this->ca.read, burst->duration);
+
+  if (_this->ca.read)
+  {
+    burst->latency = FLASH_READ_LATENCY;
+
+    if (_this->state != HYPERFLASH_STATE_GET_STATUS_REG && address + burst->size <= _this->size)
+    {
+      memcpy(burst->data, &_this->data[address], burst->size);
+    }
+    else
+    {
+      for (int i=0; i<burst->size; i++)
+      {
+        if (address + i >= _this->size)
+        {
+          _this->warning.force_warning("Received out-of-bound request (addr: 0x%x, flash_size: 0x%x)\n", address + i, _this->size);
+          break;
+        }
+        burst->data[i] = _this->read_byte(address + i);
+      }
+    }
+  }
+  else
+  {
+    for (int i=0; i<burst->size; i++)
+    {
+      _this->handle_access(_this->reg_access, address + i, 0, burst->data[i]);
+    }
+  }
+
+  _this->current_address += burst->size;
+
+  Hyperflash::cs_sync(_this, burst->cs, 0);
+}
+
 int Hyperflash::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in_itf.set_sync_cycle_meth(&Hyperflash::sync_cycle);
   in_itf.set_cs_sync_meth(&Hyperflash::cs_sync);
+  in_itf.set_burst_meth(&Hyperflash::burst);
   new_slave_port("input", &in_itf);
 
 
@@ -499,9 +554,19 @@ int Hyperflash::build()
   this->size = conf->get("size")->get_int();
   this->trace.msg(vp::trace::LEVEL_INFO, "Building flash (size: 0x%x)\n", this->size);
 
-  this->data = new uint8_t[this->size];
-  memset(this->data, 0xff, this->size);
+  js::config *preload_file_conf = conf->get("preload_file");
+  if (preload_file_conf == NULL)
+  {
+    preload_file_conf = conf->get("content/image");
+  }
+
+  // When the preload file is mapped, the array is the mapping itself
   this->data_is_mmapped = false;
+  if (!preload_file_conf || !(conf->get_child_bool("writeback") || conf->get_child_bool("mmap_stim_file")))
+  {
+    this->data = new uint8_t[this->size];
+    memset(this->data, 0xff, this->size);
+  }
 
   this->reg_data = new uint8_t[REGS_AREA_SIZE];
   memset(this->reg_data, 0x57, REGS_AREA_SIZE);
@@ -511,12 +576,6 @@ int Hyperflash::build()
   this->pending_bytes = 0;
   this->pending_cmd = 0;
 
-  js::config *preload_file_conf = conf->get("preload_file");
-  if (preload_file_conf == NULL)
-  {
-    preload_file_conf = conf->get("content/image");
-  }
-
   if (preload_file_conf)
   {
     if (this->preload_file((char *)preload_file_conf->get_str().c_str()))
@@ -55,6 +55,7 @@ public:
 
   static void sync_cycle(void *_this, int data);
   static void cs_sync(void *__this, int cs, int value);
+  static void burst(void *__this, vp::hyper_burst_t *burst);
 
 protected:
   vp::trace     trace;
@@ -83,6 +84,8 @@ private:
   int reg_access;
 
   Hyperbus_state_e state;
+
+  int get_latency();
 };
 
 
@@ -91,7 +94,23 @@ private:
 
 void Hyperram::handle_access(int reg_access, int address, int read, uint8_t data)
 {
-  if (address >= this->size)
+  if (reg_access)
+  {
+    // Registers are decoded on the low address bits, so that CR0, at word address 0x800,
+    // is at the beginning of the register area
+    uint8_t *reg = &this->reg_data[address & (REGS_AREA_SIZE - 1)];
+    if (read)
+    {
+      this->trace.msg(vp::trace::LEVEL_TRACE, "Sending register byte (value: 0x%x)\n", *reg);
+      this->in_itf.sync_cycle(*reg);
+    }
+    else
+    {
+      this->trace.msg(vp::trace::LEVEL_TRACE, "Received register byte (value: 0x%x)\n", data);
+      *reg = data;
+    }
+  }
+  else if (address >= this->size)
   {
     this->warning.force_warning("Received out-of-bound request (addr: 0x%x, ram_size: 0x%x)\n", address, this->size);
   }
@@ -148,6 +167,87 @@ void Hyperram::sync_cycle(void *__this, int data)
   }
 }
 
+// Initial latency in clock cycles, as configured in CR0
+int Hyperram::get_latency()
+{
+  uint16_t cr0 = ((uint16_t *)this->reg_data)[0];
+  int latency;
+
+  switch ((cr0 >> 4) & 0xf)
+  {
+    case 0x0: latency = 5; break;
+    case 0x1: latency = 6; break;
+    case 0x2: latency = 7; break;
+    case 0xe: latency = 3; break;
+    case 0xf: latency = 4; break;
+    default: latency = 6; break;
+  }
+
+  // Fixed latency, the device always asks for the doubled latency
+  if ((cr0 >> 3) & 1)
+    latency *= 2;
+
+  return latency;
+}
+
+
+
+void Hyperram::burst(void *__this, vp::hyper_burst_t *burst)
+{
+  Hyperram *_this = (Hyperram *)__this;
+
+  // Go through the same command-address decoding as the byte-level path
+  Hyperram::cs_sync(_this, burst->cs, 1);
+  for (int i=0; i<6; i++)
+  {
+    Hyperram::sync_cycle(_this, burst->ca[i]);
+  }
+
+  int address = _this->current_address;
+  int size = burst->size;
+
+  _this->trace.msg(vp::trace::LEVEL_TRACE, "Received burst (reg_access: %d, addr: 0x%x, size: 0x%x, read: %d, duration: %ld)\n",
+    _this->reg_access, address, size, _this->ca.read, burst->duration);
+
+  // Register writes are the only accesses without initial latency
+  if (!_this->reg_access || _this->ca.read)
+    burst->latency = _this->get_latency();
+
+  if (_this->reg_access)
+  {
+    // Registers are accessed byte per byte, as on the byte-level path, so that they
+    // can for example update the latency used by the next bursts
+    for (int i=0; i<size; i++)
+    {
+      uint8_t *reg = &_this->reg_data[(address + i) & (REGS_AREA_SIZE - 1)];
+      if (_this->ca.read)
+        burst->data[i] = *reg;
+      else
+        *reg = burst->data[i];
+    }
+
+    _this->current_address += burst->size;
+    _this->state = HYPERBUS_STATE_CA;
+    return;
+  }
+
+  if (address + size > _this->size)
+  {
+    _this->warning.force_warning("Received out-of-bound request (addr: 0x%x, size: 0x%x, ram_size: 0x%x)\n", address, size, _this->size);
+    size = address < _this->size ? _this->size - address : 0;
+  }
+
+  if (_this->ca.read)
+    memcpy(burst->data, &_this->data[address], size);
+  else
+    memcpy(&_this->data[address], burst->data, size);
+
+  _this->current_address += burst->size;
+  _this->state = HYPERBUS_STATE_CA;
+}
+
+
+
 void Hyperram::cs_sync(void *__this, int cs, int value)
 {
   Hyperram *_this = (Hyperram *)__this;
@@ -163,6 +263,7 @@ int Hyperram::build()
 
   in_itf.set_sync_cycle_meth(&Hyperram::sync_cycle);
   in_itf.set_cs_sync_meth(&Hyperram::cs_sync);
+  in_itf.set_burst_meth(&Hyperram::burst);
   new_slave_port("input", &in_itf);
 
   js::config *conf = this->get_js_config();
@@ -167,6 +167,57 @@ void I2c_eeprom::i2c_sync(void *__this, int scl, int sda)
     _this->i2c_helper.update_pins(scl, sda);
 }
 
+void I2c_eeprom::i2c_transfer(void *__this, vp::i2c_transfer_t *req)
+{
+    assert(NULL != __this);
+    I2c_eeprom* _this = (I2c_eeprom*) __this;
+
+    if (req->addr != _this->i2c_address)
+    {
+        return;
+    }
+
+    _this->trace.msg(vp::trace::LEVEL_DEBUG, "Handling transfer (is_write: %d, size: %d)\n", req->is_write, req->size);
+
+    req->addr_ack = true;
+
+    if (req->is_write)
+    {
+        // Same as the pin-level path, the first 2 bytes are the memory address
+        for (int i = 0; i < req->size; i++)
+        {
+            uint8_t value = req->data[i];
+
+            if (i == 0)
+            {
+                _this->current_address = value << 8;
+            }
+            else if (i == 1)
+            {
+                _this->current_address = value | _this->current_address;
+                _this->memory.set_address(_this->current_address);
+            }
+            else
+            {
+                _this->trace.msg(vp::trace::LEVEL_TRACE, "EEPROM: Storing data=%d into memory\n", value);
+                _this->memory.write(value);
+            }
+        }
+
+        req->nb_acked = req->size;
+    }
+    else
+    {
+        for (int i = 0; i < req->size; i++)
+        {
+            req->data[i] = _this->memory.read();
+        }
+    }
+
+    _this->starting = false;
+    _this->is_addressed = false;
+}
+
 
 void I2c_eeprom::reset(bool active)
 {
@@ -185,6 +236,7 @@ int I2c_eeprom::build(void)
     this->trace.msg(vp::trace::LEVEL_TRACE, "Building component\n");
 
     this->i2c_itf.set_sync_meth(&I2c_eeprom::i2c_sync);
+    this->i2c_itf.set_transfer_meth(&I2c_eeprom::i2c_transfer);
     this->new_master_port("i2c", &this->i2c_itf);
 
     this->new_master_port("clock_cfg", &this->clock_cfg);
@@ -68,6 +68,7 @@ class I2c_eeprom : public vp::component
         void i2c_enqueue_event(vp::clock_event* event, uint64_t time_ps);
         void i2c_cancel_event(vp::clock_event* event);
         static void i2c_sync(void *__this, int scl, int sda);
+        static void i2c_transfer(void *__this, vp::i2c_transfer_t *req);
         void i2c_helper_callback(i2c_operation_e id, i2c_status_e status, int value);
 
         /**********/
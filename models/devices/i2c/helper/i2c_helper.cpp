@@ -237,6 +237,36 @@ void I2C_helper::send_stop(void)
     this->is_stopping = true;
 }
 
+bool I2C_helper::is_busy(void)
+{
+    return this->internal_state != I2C_INTERNAL_IDLE || this->is_starting || this->pending_data_bits != 0;
+}
+
+bool I2C_helper::send_transfer(vp::i2c_transfer_t *req)
+{
+    if (this->is_busy())
+    {
+        return false;
+    }
+
+    // Start, then address and data bytes with their ack bit, then stop
+    const int nb_bits = 1 + (1 + req->size) * 9 + (req->stop ? 1 : 0);
+    req->duration = nb_bits * (this->delay_low_ps + this->delay_high_ps);
+
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Request to send transfer (addr: 0x%x, is_write: %d, size: %d, stop: %d)\n",
+            req->addr, req->is_write, req->size, req->stop);
+
+    if (!this->itf->transfer(req))
+    {
+        this->trace.msg(vp::trace::LEVEL_TRACE, "Transfer refused, falling back to pins\n");
+        return false;
+    }
+
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Transfer done (addr_ack: %d, nb_acked: %d)\n", req->addr_ack, req->nb_acked);
+
+    return true;
+}
+
 void I2C_helper::start_clock(void)
 {
     this->trace.msg(vp::trace::LEVEL_TRACE, "Starting clock\n");
@@ -104,6 +104,16 @@ class I2C_helper {
         //TODO
         void release_pins(void);
 
+        /**
+         * \brief Send a whole transfer at transaction level
+         *
+         * The request is filled by the caller, except its duration which is computed
+         * from the timings. Returns false if the helper or the bus is busy, or if a
+         * device on the bus only handles pins. The transfer must then be sent with the
+         * pin-level operations.
+         */
+        bool send_transfer(vp::i2c_transfer_t *req);
+
         //TODO
         bool is_busy(void);
 
@@ -37,6 +37,7 @@ public:
 private:
 
     static void sync(void *__this, int scl, int sda, int id);
+    static bool transfer(void *__this, vp::i2c_transfer_t *req, int id);
 
     vp::trace trace;
 
@@ -62,6 +63,7 @@ int I2c_bus::build()
     traces.new_trace("trace", &trace, vp::DEBUG);
 
     this->in.set_sync_meth_demuxed(&I2c_bus::sync);
+    this->in.set_transfer_meth_demuxed(&I2c_bus::transfer);
     new_slave_port("input", &in);
 
     uint8_t reset_val = 1;
@@ -139,6 +141,41 @@ void I2c_bus::sync(void *__this, int scl, int sda, int id)
 }
 
 
+bool I2c_bus::transfer(void *__this, vp::i2c_transfer_t *req, int id)
+{
+    I2c_bus *_this = (I2c_bus *)__this;
+
+    // A transfer replaces the arbitration done on the pins, so it is only possible when
+    // no device is driving the bus, and if all devices can handle it. Otherwise the
+    // initiator goes through the pins. The initiator itself does not need to handle
+    // transfers as it never receives its own.
+    for (std::pair<int, i2c_pair_t> i2c_val : _this->i2c_values)
+    {
+        if (i2c_val.second.scl == 0 || i2c_val.second.sda == 0)
+        {
+            _this->trace.msg(vp::trace::LEVEL_TRACE, "Refusing transfer, bus is busy [id=%d]\n", id);
+            return false;
+        }
+    }
+
+    if (!_this->in.is_transfer_supported(req))
+    {
+        _this->trace.msg(vp::trace::LEVEL_TRACE, "Refusing transfer, not supported by all devices [id=%d]\n", id);
+        return false;
+    }
+
+    _this->trace.msg(vp::trace::LEVEL_DEBUG, "Transfer [id=%d] (addr: 0x%x, is_write: %d, size: %d, stop: %d, duration: %ld)\n",
+        id, req->addr, req->is_write, req->size, req->stop, req->duration);
+
+    _this->in.transfer(req);
+
+    _this->trace.msg(vp::trace::LEVEL_DEBUG, "Transfer done [id=%d] (addr_ack: %d, nb_acked: %d)\n",
+        id, req->addr_ack, req->nb_acked);
+
+    return true;
+}
+
+
 extern "C" vp::component *vp_constructor(js::config *config)
 {
     return new I2c_bus(config);
@@ -44,6 +44,7 @@ public:
 
 protected:
     static void i2c_sync(void *__this, int scl, int sda);
+    static void i2c_transfer(void *__this, vp::i2c_transfer_t *req);
     void i2c_start(unsigned int address, bool is_read);
     void i2c_handle_byte(uint8_t byte);
     void i2c_stop();
@@ -252,6 +253,46 @@ end:
     _this->i2c_prev_scl = scl;
 }
 
+void Ak4332::i2c_transfer(void *__this, vp::i2c_transfer_t *req)
+{
+    Ak4332 *_this = (Ak4332 *)__this;
+
+    _this->trace.msg(vp::trace::LEVEL_TRACE, "I2C transfer (addr: 0x%x, is_write: %d, size: %d)\n", req->addr, req->is_write, req->size);
+
+    _this->i2c_start(req->addr, !req->is_write);
+
+    if (_this->i2c_being_addressed)
+    {
+        req->addr_ack = true;
+
+        if (req->is_write)
+        {
+            for (int i=0; i<req->size; i++)
+            {
+                _this->i2c_handle_byte(req->data[i]);
+            }
+            req->nb_acked = req->size;
+        }
+        else if (req->size > 0)
+        {
+            // Only one byte is sent per read, the next ones are not driven
+            _this->i2c_get_data();
+            req->data[0] = _this->i2c_pending_send_byte;
+            for (int i=1; i<req->size; i++)
+            {
+                req->data[i] = 0xff;
+            }
+        }
+    }
+
+    if (req->stop)
+    {
+        _this->i2c_stop();
+    }
+
+    _this->i2c_state = I2C_STATE_WAIT_START;
+}
+
 void Ak4332::i2c_start(unsigned int address, bool is_read)
 {
     this->trace.msg(vp::trace::LEVEL_TRACE, "Received header (address: 0x%x, is_read: %d)\n", address, is_read);
@@ -596,6 +637,7 @@ int Ak4332::build()
     traces.new_trace("trace", &trace, vp::DEBUG);
 
     this->i2c_itf.set_sync_meth(&Ak4332::i2c_sync);
+    this->i2c_itf.set_transfer_meth(&Ak4332::i2c_transfer);
     this->new_master_port("i2c", &this->i2c_itf);
 
     this->i2c_state = I2C_STATE_WAIT_START;
@@ -24,6 +24,7 @@
 #include <vp/itf/io.hpp>
 #include <vp/itf/i2s.hpp>
 #include <vp/itf/clock.hpp>
+#include <vp/pcm_file.hpp>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
@@ -109,6 +110,7 @@ private:
   Microphone *top;
   int width;
   FILE *stim_file;
+  vp::Pcm_file_reader *stim_reader;
   std::string file_path;
   int period;
   int64_t last_data_time;
@@ -142,6 +144,15 @@ Stim_txt::Stim_txt(Microphone *top, std::string file, int width, int freq, bool
 
     #endif
 
+    }
+    else if (raw)
+    {
+        // Raw samples are read from a mapping of the file, which is replayed in loop
+        stim_reader = new vp::Pcm_file_reader(file, true);
+        if (!stim_reader->is_open())
+        {
+            this->top->get_trace()->fatal("Failed to open stimuli file: %s: %s\n", file.c_str(), strerror(errno));
+        }
     }
     else
     {
@@ -198,10 +209,10 @@ long long Stim_txt::get_data_from_file()
     else if (raw)
     {
         unsigned long long data = 0;
-        while(fread((void *)&data, 2, 1, this->stim_file) != 1)
+        if (!this->stim_reader->read((void *)&data, 2))
         {
-            fclose(this->stim_file);
-            this->stim_file = fopen(this->file_path.c_str(), "r");    
+            this->top->get_trace()->fatal("Stimuli file does not contain any sample: %s\n", this->file_path.c_str());
+            return 0;
         }
 
         long long result = get_signed_value(data, width);
@@ -24,6 +24,7 @@
 #include <vp/itf/io.hpp>
 #include <vp/itf/i2s.hpp>
 #include <vp/itf/clock.hpp>
+#include <vp/pcm_file.hpp>
 
 #ifdef USE_SNDFILE
 #include <sndfile.hh>
@@ -116,7 +117,11 @@ protected:
 Outfile_hex::Outfile_hex(Speaker *top, std::string file, int width)
 : top(top)
 {
-    this->file = fopen(file.c_str(), "w");
+    this->file = vp::pcm_file_open_writer(file);
+    if (this->file == NULL)
+    {
+        this->top->get_trace()->fatal("Failed to open output file: %s: %s\n", file.c_str(), strerror(errno));
+    }
 }
 
 
@@ -49,6 +49,7 @@ class Atxp032(st.Component):
         self.set_component('devices.spiflash.spiflash_impl')
 
         self.add_property('writeback', True)
+        self.add_property('mmap_stim_file', False)
         self.add_property('size', size)
 
         # TODO this is needed by GAPY but is not aligned with the size given to model
@@ -39,6 +39,7 @@ class Spiflash(Flash):
         self.set_component('devices.spiflash.spiflash_impl')
 
         self.add_property('writeback', True)
+        self.add_property('mmap_stim_file', False)
         self.add_property('size', size)
 
         self.add_property('preload_file', self.get_image_path())
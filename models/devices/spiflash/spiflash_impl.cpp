@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <vp/itf/qspim.hpp>
+#include <vp/mem_file.hpp>
 
 #define CMD_READ_ID       0x9f
 #define CMD_RDCR          0x35
@@ -115,6 +116,9 @@ private:
 
   static void sync(void *__this, int sck, int data_0, int data_1, int data_2, int data_3, int mask);
   static void cs_sync(void *__this, bool active);
+  static void burst(void *__this, vp::qspim_burst_t *burst);
+
+  bool access(unsigned int addr, uint8_t *data, int size, bool is_write);
 
   void handle_data(int data_0, int data_1, int data_2, int data_3);
   void start_command();
@@ -431,6 +435,79 @@ void spiflash::sync(void *__this, int sck, int data_0, int data_1, int data_2, i
 }
 
 
+bool spiflash::access(unsigned int addr, uint8_t *data, int size, bool is_write)
+{
+  if ((uint64_t)addr + size > (uint64_t)this->size) {
+    this->warning.force_warning("Received out-of-bound request (address: 0x%x, size: 0x%x, memSize: 0x%x)\n", addr, size, this->size);
+    return false;
+  }
+
+  this->trace.msg(vp::trace::LEVEL_DEBUG, "%s data (address: 0x%x, size: 0x%x)\n", is_write ? "Writing" : "Reading", addr, size);
+
+  if (is_write)
+    memcpy(&this->mem_data[addr], data, size);
+  else
+    memcpy(data, &this->mem_data[addr], size);
+
+  return true;
+}
+
+
+// Handle a whole transaction at once, with the same behavior as the edge-level path.
+// The timing is fully given by the master through the burst duration.
+void spiflash::burst(void *__this, vp::qspim_burst_t *burst)
+{
+  spiflash *_this = (spiflash *)__this;
+  command_t *command = _this->commands[burst->cmd];
+
+  if (command == NULL)
+  {
+    _this->warning.force_warning("Received unknown command (cmd: 0x%x)\n", burst->cmd);
+    return;
+  }
+
+  _this->trace.msg(vp::trace::LEVEL_TRACE, "Received burst (ID: 0x%x, name: %s, addr: 0x%x, size: 0x%x, duration: %ld)\n",
+    burst->cmd, command->desc.c_str(), burst->addr, burst->size, burst->duration);
+
+  switch (burst->cmd)
+  {
+    case CMD_PP:
+      _this->access(burst->addr & 0xffffff, burst->data, burst->size, true);
+      break;
+
+    case CMD_QIOR_4B:
+      _this->access(burst->addr, burst->data, burst->size, false);
+      break;
+
+    case CMD_READ:
+    case CMD_READ_SIMPLE:
+      _this->access(burst->addr & 0xffffff, burst->data, burst->size, false);
+      break;
+
+    case CMD_SECTOR_ERASE:
+      _this->sr2v.raw &= ~(1<<2);
+      _this->current_addr = burst->addr;
+      _this->trace.msg(vp::trace::LEVEL_INFO, "Received address (address: 0x%x)\n", _this->current_addr);
+      _this->event_enqueue(_this->sector_erase_event, 1000000);
+      break;
+
+    case CMD_WRAR:
+      if (burst->size > 0 && burst->addr == 0x800002)
+      {
+        _this->trace.msg(vp::trace::LEVEL_INFO, "Writing cr1 register (value: %d)\n", burst->data[0]);
+        _this->cr1.raw = burst->data[0];
+      }
+      break;
+
+    case CMD_READ_SR2V:
+      memset(burst->data, _this->sr2v.raw, burst->size);
+      break;
+  }
+
+  _this->start_command();
+}
+
+
 void spiflash::cs_sync(void *__this, bool active)
 {
   spiflash *_this = (spiflash *)__this;  
@@ -449,6 +526,7 @@ int spiflash::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   this->in_itf.set_sync_meth(&spiflash::sync);
+  this->in_itf.set_burst_meth(&spiflash::burst);
   this->new_slave_port("input", &this->in_itf);
 
   this->cs_itf.set_sync_meth(&spiflash::cs_sync);
@@ -464,10 +542,6 @@ int spiflash::build()
 
   this->size = this->get_config_int("size");
 
-  this->mem_data = new uint8_t[this->size];
-
-  memset(this->mem_data, 0x57, this->size);
-
   this->cr1.raw = 0;
   this->quad = false;
 
@@ -494,7 +568,33 @@ void spiflash::start()
     stim_file_conf = this->get_js_config()->get("preload_file");
   }
 
-  if (stim_file_conf != NULL)
+  // The default configurations enable writeback although this model has always read
+  // the stimuli file, so it is only honoured when the file is explicitly mapped
+  bool mapped = this->get_js_config()->get_child_bool("mmap_stim_file");
+  bool writeback = mapped && this->get_js_config()->get_child_bool("writeback");
+
+  if (stim_file_conf != NULL && mapped)
+  {
+    // The flash array is directly mapped on the file, either copy-on-write or
+    // with the flash writes propagated to the file
+    string path = stim_file_conf->get_str();
+    this->get_trace()->msg(vp::trace::LEVEL_INFO, "Mapping memory on stimuli file (path: %s, writeback: %d)\n", path.c_str(), writeback);
+
+    this->mem_data = vp::mem_file_map(path, this->size, 0x57, writeback);
+    if (this->mem_data == NULL)
+    {
+      this->get_trace()->fatal("Unable to map stim file: %s, %s\n", path.c_str(), strerror(errno));
+      return;
+    }
+  }
+  else
+  {
+    this->mem_data = new uint8_t[this->size];
+
+    memset(this->mem_data, 0x57, this->size);
+  }
+
+  if (stim_file_conf != NULL && !mapped)
   {
     string path = stim_file_conf->get_str();
     this->get_trace()->msg(vp::trace::LEVEL_INFO, "Preloading memory with stimuli file (path: %s)\n", path.c_str());
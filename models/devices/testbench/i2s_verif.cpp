@@ -24,6 +24,7 @@
 #endif
 
 #include <vp/vp.hpp>
+#include <vp/pcm_file.hpp>
 #include "i2s_verif.hpp"
 #ifdef USE_SNDFILE
 #include <sndfile.hh>
@@ -79,11 +80,13 @@ class Rx_stream_raw_file : public Rx_stream
 {
 public:
     Rx_stream_raw_file(Slot *slot, string filepath, int width, bool is_bin, pi_testbench_i2s_verif_start_config_file_encoding_type_e encoding);
+    ~Rx_stream_raw_file();
     uint32_t get_sample(int channel_id);
     Slot *slot;
 
 private:
     FILE *infile;
+    vp::Pcm_file_reader *reader;
     int width;
     bool is_bin;
     pi_testbench_i2s_verif_start_config_file_encoding_type_e encoding;
@@ -94,6 +97,7 @@ class Tx_stream_raw_file : public Tx_stream
 {
 public:
     Tx_stream_raw_file(Slot *slot, string filepath, int width, bool is_bin, pi_testbench_i2s_verif_start_config_file_encoding_type_e encoding);
+    ~Tx_stream_raw_file();
     void push_sample(uint32_t sample, int channel_id);
     Slot *slot;
 
@@ -149,15 +153,20 @@ public:
     void start_frame();
     int get_data();
     void send_data(int sdo);
+    bool get_word(uint32_t *word);
+    void send_word(uint32_t word);
     void pdm_sync(int sd);
     void pdm_get();
     int64_t exec();
 
 protected:
     Testbench *top;
+
     pi_testbench_i2s_verif_slot_config_t config_rx;
 
 private:
+    void push_tx_sample();
+
     I2s_verif *i2s;
     int id;
     vp::trace trace;
@@ -196,6 +205,8 @@ I2s_verif::I2s_verif(Testbench *top, vp::i2s_master *itf, int itf_id, pi_testben
     ::memcpy(&this->config, config, sizeof(pi_testbench_i2s_verif_config_t));
 
     this->itf = itf;
+    this->itf_id = itf_id;
+    this->frame_mode = false;
     this->prev_ws = 0;
     this->frame_active = false;
     this->ws_delay = config->ws_delay;
@@ -276,6 +287,13 @@ I2s_verif::I2s_verif(Testbench *top, vp::i2s_master *itf, int itf_id, pi_testben
         this->slots.push_back(new Slot(top, this, itf_id, i));
     }
 
+    this->frame_master_data.resize(this->config.nb_slots);
+    this->frame_slave_data.resize(this->config.nb_slots);
+    this->frame.nb_slots = this->config.nb_slots;
+    this->frame.width = this->config.word_size;
+    this->frame.master_data = this->frame_master_data.data();
+    this->frame.slave_data = this->frame_slave_data.data();
+
     if (this->config.is_ext_ws)
     {
         this->ws_value = 0;
@@ -564,9 +582,24 @@ void I2s_verif::start(pi_testbench_i2s_verif_start_config_t *config)
     this->clk_active = config->start;
     this->prev_frame_start_time = -1;
 
+    // Frames can only be exchanged as a whole if this side generates the clock and the
+    // word select, and if no other interface is sampling them edge by edge
+    this->frame_mode = this->is_ext_clk && this->config.is_ext_ws && !this->is_pdm &&
+        !this->config.is_sai0_clk && !this->config.is_sai0_ws &&
+        this->top->i2ss[this->itf_id]->clk_propagate == 0 &&
+        this->top->i2ss[this->itf_id]->ws_propagate == 0 &&
+        this->config.nb_slots <= 32 && this->config.word_size <= 32 &&
+        this->itf->has_sync_frame();
+
+    if (this->frame_mode)
+    {
+        this->frame_period = this->clk_period * 2 * this->config.word_size * this->config.nb_slots;
+        this->trace.msg(vp::trace::LEVEL_INFO, "Using frame-level mode (frame_period: %ld)\n", this->frame_period);
+    }
+
     if (this->clk_active && this->is_ext_clk)
     {
-        this->enqueue_to_engine(this->clk_period);
+        this->enqueue_to_engine(this->frame_mode ? this->frame_period : this->clk_period);
     }
 }
 
@@ -577,7 +610,7 @@ Tx_stream_raw_file::Tx_stream_raw_file(Slot *slot, std::string filepath, int wid
     this->is_bin = is_bin;
     this->encoding = encoding;
     this->slot = slot;
-    this->outfile = fopen(filepath.c_str(), "w");
+    this->outfile = vp::pcm_file_open_writer(filepath);
     this->slot->trace.msg(vp::trace::LEVEL_INFO, "Opening dumper (path: %s)\n", filepath.c_str());
     if (this->outfile == NULL)
     {
@@ -586,6 +619,15 @@ Tx_stream_raw_file::Tx_stream_raw_file(Slot *slot, std::string filepath, int wid
 }
 
 
+Tx_stream_raw_file::~Tx_stream_raw_file()
+{
+    if (this->outfile)
+    {
+        fclose(this->outfile);
+    }
+}
+
+
 void Tx_stream_raw_file::push_sample(uint32_t sample, int channel_id)
 {
     if (this->is_bin)
@@ -690,25 +732,47 @@ Rx_stream_raw_file::Rx_stream_raw_file(Slot *slot, std::string filepath, int wid
     this->is_bin = is_bin;
     this->encoding = encoding;
     this->slot = slot;
-    this->infile = fopen(filepath.c_str(), "r");
-    if (this->infile == NULL)
+    this->infile = NULL;
+    this->reader = NULL;
+
+    if (is_bin)
     {
-         this->slot->top->trace.fatal("Unable to open input file (file: %s, error: %s)\n", filepath.c_str(), strerror(errno));
+        // Binary samples are read from a mapping of the file, text ones go through stdio
+        this->reader = new vp::Pcm_file_reader(filepath, false);
+        if (!this->reader->is_open())
+        {
+            this->slot->top->trace.fatal("Unable to open input file (file: %s, error: %s)\n", filepath.c_str(), strerror(errno));
+        }
+    }
+    else
+    {
+        this->infile = fopen(filepath.c_str(), "r");
+        if (this->infile == NULL)
+        {
+             this->slot->top->trace.fatal("Unable to open input file (file: %s, error: %s)\n", filepath.c_str(), strerror(errno));
+        }
     }
 }
 
 
+Rx_stream_raw_file::~Rx_stream_raw_file()
+{
+    if (this->infile)
+    {
+        fclose(this->infile);
+    }
+    delete this->reader;
+}
+
+
 uint32_t Rx_stream_raw_file::get_sample(int channel_id)
 {
     if (this->is_bin)
     {
         int nb_bytes = (this->width + 7) / 8;
         uint32_t result = 0;
-        int freadres = fread((void *)&result, nb_bytes, 1, this->infile);
-
-        // this->slot->top->trace.msg(vp::trace::LEVEL_TRACE, "channel_id=%d, nb_bytes=%d, freadres=%d, result=%d\n", channel_id, nb_bytes, freadres, result);
 
-        if (freadres != 1)
+        if (!this->reader->read((void *)&result, nb_bytes))
         {
             return 0;
         }
@@ -1113,73 +1177,123 @@ void Slot::send_data(int sd)
 
             if (this->tx_pending_bits == 0)
             {
-                int msb_first = (this->config_tx.format >> 0) & 1;
-                int left_align = (this->config_tx.format >> 1) & 1;
-                int sign_extend = (this->config_tx.format >> 2) & 1;
-                int dummy_cycles = this->i2s->config.word_size - this->config_tx.word_size;
+                this->push_tx_sample();
+            }
+        }
+    }
+}
 
-                if (dummy_cycles)
-                {
-                    if (msb_first)
-                    {
-                        if (left_align)
-                        {
-                            this->tx_pending_value >>= dummy_cycles;
-                        }
-                        else
-                        {
-                        }
-                    }
-                    else
-                    {
-                        if (left_align)
-                        {
-                            uint32_t value = 0;
-                            for (int i=0; i<this->i2s->config.word_size; i++)
-                            {
-                                value = (value << 1) | (this->tx_pending_value & 1);
-                                this->tx_pending_value >>= 1;
-                            }
-                            this->tx_pending_value = value;
-                        }
-                        else
-                        {
-                            uint32_t value = 0;
-                            for (int i=0; i<this->config_tx.word_size; i++)
-                            {
-                                value = (value << 1) | (this->tx_pending_value & 1);
-                                this->tx_pending_value >>= 1;
-                            }
-                            this->tx_pending_value = value;
-                        }
-                    }
-                }
-                else
+
+bool Slot::get_word(uint32_t *word)
+{
+    // Frame-level equivalent of get_data, returns the whole word of this slot at once,
+    // or false if the slot is not driven
+    if (!this->rx_started)
+    {
+        return false;
+    }
+
+    if (this->rx_pending_bits > 0)
+    {
+        *word = this->rx_pending_value & ((1ULL << this->i2s->config.word_size) - 1);
+        this->rx_pending_bits = 0;
+    }
+    else
+    {
+        if (this->start_config_rx.rx_iter.nb_samples == 0)
+        {
+            this->rx_started = false;
+        }
+        *word = 0;
+    }
+
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Getting word (word: 0x%x)\n", *word);
+
+    return true;
+}
+
+
+void Slot::send_word(uint32_t word)
+{
+    // Frame-level equivalent of send_data, receives the whole word of this slot at once
+    if (this->tx_started && this->tx_pending_bits > 0)
+    {
+        this->tx_pending_value = word & ((1ULL << this->i2s->config.word_size) - 1);
+        this->tx_pending_bits = 0;
+
+        this->trace.msg(vp::trace::LEVEL_DEBUG, "Sampling word (value: 0x%x)\n", word);
+
+        this->push_tx_sample();
+    }
+}
+
+
+void Slot::push_tx_sample()
+{
+    int msb_first = (this->config_tx.format >> 0) & 1;
+    int left_align = (this->config_tx.format >> 1) & 1;
+    int sign_extend = (this->config_tx.format >> 2) & 1;
+    int dummy_cycles = this->i2s->config.word_size - this->config_tx.word_size;
+
+    if (dummy_cycles)
+    {
+        if (msb_first)
+        {
+            if (left_align)
+            {
+                this->tx_pending_value >>= dummy_cycles;
+            }
+            else
+            {
+            }
+        }
+        else
+        {
+            if (left_align)
+            {
+                uint32_t value = 0;
+                for (int i=0; i<this->i2s->config.word_size; i++)
                 {
-                    if (!msb_first)
-                    {
-                        uint32_t value = 0;
-                        for (int i=0; i<this->config_tx.word_size; i++)
-                        {
-                            value = (value << 1) | (this->tx_pending_value & 1);
-                            this->tx_pending_value >>= 1;
-                        }
-                        this->tx_pending_value = value;
-                    }
+                    value = (value << 1) | (this->tx_pending_value & 1);
+                    this->tx_pending_value >>= 1;
                 }
-
-                this->trace.msg(vp::trace::LEVEL_DEBUG, "Writing sample (value: 0x%lx)\n", this->tx_pending_value);
-                if (this->outstream)
+                this->tx_pending_value = value;
+            }
+            else
+            {
+                uint32_t value = 0;
+                for (int i=0; i<this->config_tx.word_size; i++)
                 {
-                    for (auto channel_id: this->tx_channel_id)
-                    {
-                        this->outstream->push_sample(this->tx_pending_value, channel_id);
-                    }
+                    value = (value << 1) | (this->tx_pending_value & 1);
+                    this->tx_pending_value >>= 1;
                 }
-                this->tx_pending_bits = this->i2s->config.word_size;
+                this->tx_pending_value = value;
             }
         }
     }
+    else
+    {
+        if (!msb_first)
+        {
+            uint32_t value = 0;
+            for (int i=0; i<this->config_tx.word_size; i++)
+            {
+                value = (value << 1) | (this->tx_pending_value & 1);
+                this->tx_pending_value >>= 1;
+            }
+            this->tx_pending_value = value;
+        }
+    }
+
+    this->trace.msg(vp::trace::LEVEL_DEBUG, "Writing sample (value: 0x%lx)\n", this->tx_pending_value);
+    if (this->outstream)
+    {
+        for (auto channel_id: this->tx_channel_id)
+        {
+            this->outstream->push_sample(this->tx_pending_value, channel_id);
+        }
+    }
+    this->tx_pending_bits = this->i2s->config.word_size;
 }
 
 
@@ -1259,10 +1373,48 @@ void Slot::pdm_get()
 }
 
 
+int64_t I2s_verif::exec_frame()
+{
+    vp::i2s_frame_t *frame = &this->frame;
+
+    frame->master_valid = 0;
+    frame->slave_valid = 0;
+    frame->duration = this->frame_period;
+
+    for (int i=0; i<this->config.nb_slots; i++)
+    {
+        this->slots[i]->start_frame();
+        if (this->slots[i]->get_word(&frame->master_data[i]))
+        {
+            frame->master_valid |= 1U << i;
+        }
+    }
+
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Sending frame (valid_slots: 0x%x)\n", frame->master_valid);
+
+    this->itf->sync_frame(frame);
+
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Received frame (valid_slots: 0x%x)\n", frame->slave_valid);
+
+    for (int i=0; i<this->config.nb_slots; i++)
+    {
+        // Undriven slots are sampled as 0, as in bit-level mode
+        this->slots[i]->send_word((frame->slave_valid >> i) & 1 ? frame->slave_data[i] : 0);
+    }
+
+    return this->frame_period;
+}
+
+
 int64_t I2s_verif::exec()
 {
     if (this->clk_active)
     {
+        if (this->frame_mode)
+        {
+            return this->exec_frame();
+        }
+
         this->clk ^= 1;
 
         this->itf->sync(this->clk, this->ws_value, this->data, this->is_full_duplex);
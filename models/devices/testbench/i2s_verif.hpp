@@ -41,6 +41,7 @@ public:
     void sync_sck(int sck);
     void sync_ws(int ws);
     int64_t exec();
+    int64_t exec_frame();
     void set_pdm_data(int slot, int data);
 
     Testbench *top;
@@ -76,6 +77,15 @@ public:
     int64_t prev_frame_start_time;
     int64_t sampling_period;
 
+    // Frame-level mode, used instead of toggling the clock when this side generates
+    // both the clock and the word select and the other side supports it
+    int itf_id;
+    bool frame_mode;
+    int64_t frame_period;
+    vp::i2s_frame_t frame;
+    std::vector<uint32_t> frame_master_data;
+    std::vector<uint32_t> frame_slave_data;
+
     std::vector<Slot *> slots;
 };
 
@@ -308,11 +308,11 @@ void Uart::handle_received_byte(uint8_t byte)
     }
     else if (this->is_control)
     {
-        this->top->handle_received_byte(uart_byte);
+        this->top->handle_received_byte(byte);
     }
     else if (this->dev)
     {
-        dev->handle_received_byte(uart_byte);
+        dev->handle_received_byte(byte);
     }
 }
 
@@ -361,12 +361,68 @@ void Uart::check_send_byte()
     {
         if (this->rtr == 0)
         {
-            this->tx_clock->reenqueue(this->uart_tx_event, 2);
+            if (this->itf.has_sync_buffer())
+            {
+                this->send_frames();
+            }
+            else
+            {
+                this->tx_clock->reenqueue(this->uart_tx_event, 2);
+            }
         }
     }
 }
 
 
+// Send the pending byte and all the queued ones at once to the UART, which supports
+// transaction-level transfers. The TX event is then only used to wait until the line
+// is free again. Flow control is only checked before each transfer.
+void Uart::send_frames()
+{
+    std::vector<uint8_t> frames;
+
+    frames.push_back(this->tx_pending_byte);
+    while (this->pending_buffers.size())
+    {
+        frames.push_back(this->pending_buffers.front());
+        this->pending_buffers.pop();
+    }
+    this->tx_pending_bits = 0;
+
+    int frame_bits = 1 + 8 + this->tx_parity_en + this->tx_stop_bits;
+    int64_t duration = (int64_t)frames.size() * frame_bits * 1000000000000LL / this->baudrate;
+
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Sending frames (size: %d, duration: %ld)\n", (int)frames.size(), duration);
+
+    this->itf.sync_buffer(frames.data(), frames.size(), duration);
+    this->tx_frames_pending = true;
+
+    // TX clock is running at twice the baudrate
+    this->tx_clock->reenqueue(this->uart_tx_event, 2 * frame_bits * frames.size());
+}
+
+
+void Uart::send_frames_done()
+{
+    this->tx_frames_pending = false;
+
+    if (this->tx_pending_bits)
+    {
+        this->check_send_byte();
+    }
+    else if (this->pending_buffers.size())
+    {
+        uint8_t byte = this->pending_buffers.front();
+        this->pending_buffers.pop();
+        this->send_byte(byte);
+    }
+    else if (this->dev)
+    {
+        this->dev->send_byte_done();
+    }
+}
+
+
 void Uart::send_buffer(uint8_t *buffer, int size)
 {
     if (this->pending_buffers.size() == 0 && this->tx_pending_bits == 0)
@@ -418,6 +474,7 @@ Uart::Uart(Testbench *top, int id)
     this->init_event = top->event_new(this, Uart::init_handler);
     this->itf.set_sync_meth(&Uart::sync);
     this->itf.set_sync_full_meth(&Uart::sync_full);
+    this->itf.set_sync_buffer_meth(&Uart::sync_buffer);
     this->top->new_slave_port(this, "uart" + std::to_string(this->id), &this->itf);
     this->top->new_master_port(this, "uart" + std::to_string(this->id) + "_clock_cfg", &clock_cfg);
     this->top->new_master_port(this, "uart" + std::to_string(this->id) + "_tx_clock_cfg", &tx_clock_cfg);
@@ -495,6 +552,23 @@ void Uart::sync_full(void *__this, int data, int clk, int rtr, unsigned int mask
 }
 
 
+void Uart::sync_buffer(void *__this, uint8_t *data, int size, int64_t duration)
+{
+    Uart *_this = (Uart *)__this;
+
+    if (!_this->is_control && !_this->dev && !_this->proxy_file)
+        return;
+
+    _this->trace.msg(vp::trace::LEVEL_TRACE, "UART sync buffer (size: %d, duration: %ld)\n", size, duration);
+
+    for (int i=0; i<size; i++)
+    {
+        _this->trace.msg(vp::trace::LEVEL_DEBUG, "Received byte (value: 0x%x)\n", data[i]);
+        _this->handle_received_byte(data[i]);
+    }
+}
+
+
 void Uart::sync(void *__this, int data)
 {
     Uart *_this = (Uart *)__this;
@@ -549,7 +623,14 @@ void Uart::set_cts(int cts)
 void Uart::uart_tx_handler(void *__this, vp::clock_event *event)
 {
     Uart *_this = (Uart *)__this;
-    _this->send_bit();
+    if (_this->tx_frames_pending)
+    {
+        _this->send_frames_done();
+    }
+    else
+    {
+        _this->send_bit();
+    }
 }
 
 
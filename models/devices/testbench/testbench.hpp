@@ -39,6 +39,7 @@
 #include <iostream>
 #include <regex>
 #include <queue>
+#include <vector>
 
 extern "C" void dpi_set_status(int status);
 
@@ -490,10 +491,13 @@ private:
 
     static void sync(void *__this, int data);
     static void sync_full(void *__this, int data, int clk, int rtr, unsigned int mask);
+    static void sync_buffer(void *__this, uint8_t *data, int size, int64_t duration);
 
     void uart_tx_sampling();
 
     void check_send_byte();
+    void send_frames();
+    void send_frames_done();
 
     void uart_start_tx_sampling(int baudrate);
     void uart_stop_tx_sampling();
@@ -544,6 +548,8 @@ private:
     int tx_bit = 1;
     int tx_cts = 0;
     int rtr = 0;
+    // True while frames sent at transaction level are occupying the line
+    bool tx_frames_pending = false;
 
     uart_tx_state_e tx_state;
 
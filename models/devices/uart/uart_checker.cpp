@@ -65,6 +65,9 @@ private:
     void stop_rx_sampling();
 
     static void sync(void *__this, int data);
+    static void sync_buffer(void *__this, uint8_t *data, int size, int64_t duration);
+
+    void handle_byte(uint8_t byte);
 
     static void event_handler(void *__this, vp::clock_event *event);
 
@@ -123,6 +126,12 @@ int Uart_checker::build()
     telnet = get_js_config()->get("telnet")->get_bool();
 
     this->in.set_sync_meth(&Uart_checker::sync);
+    // The loopback needs to echo every bit, so frames can be received at transaction
+    // level only without it
+    if (!loopback)
+    {
+        this->in.set_sync_buffer_meth(&Uart_checker::sync_buffer);
+    }
     new_slave_port("input", &in);
 
     this->event = event_new(Uart_checker::event_handler);
@@ -175,18 +184,7 @@ void Uart_checker::tx_sampling()
         if (nb_bits == 8)
         {
             this->trace.msg(vp::trace::LEVEL_INFO, "Sampled TX byte (value: 0x%x)\n", byte);
-            if (this->telnet)
-            {
-                //this->telnet_proxy->push_byte(&byte);
-            }
-            else if (this->stdout)
-            {
-                std::cout << byte;
-            }
-            else if (tx_file)
-            {
-                fwrite((void *)&byte, 1, 1, tx_file);
-            }
+            this->handle_byte(byte);
             this->trace.msg(vp::trace::LEVEL_INFO, "Waiting for stop bit\n");
             tx_wait_stop = true;
         }
@@ -194,6 +192,37 @@ void Uart_checker::tx_sampling()
 }
 
 
+void Uart_checker::handle_byte(uint8_t byte)
+{
+    if (this->telnet)
+    {
+        //this->telnet_proxy->push_byte(&byte);
+    }
+    else if (this->stdout)
+    {
+        std::cout << byte;
+    }
+    else if (tx_file)
+    {
+        fwrite((void *)&byte, 1, 1, tx_file);
+    }
+}
+
+
+void Uart_checker::sync_buffer(void *__this, uint8_t *data, int size, int64_t duration)
+{
+    Uart_checker *_this = (Uart_checker *)__this;
+
+    _this->trace.msg(vp::trace::LEVEL_TRACE, "Sync buffer (size: %d, duration: %ld)\n", size, duration);
+
+    for (int i=0; i<size; i++)
+    {
+        _this->trace.msg(vp::trace::LEVEL_INFO, "Received TX byte (value: 0x%x)\n", data[i]);
+        _this->handle_byte(data[i]);
+    }
+}
+
+
 void Uart_checker::event_handler(void *__this, vp::clock_event *event)
 {
     Uart_checker *_this = (Uart_checker *)__this;
@@ -17,8 +17,31 @@
 import gsystree as st
 
 class Converter(st.Component):
+    """
+    Converter
 
-    def __init__(self, parent, name, output_width=4, output_align=4):
+    Splits requests into packets of the output width.
+
+    Attributes
+    ----------
+    output_width : int
+        Width in bytes of the output packets.
+    output_align : int
+        Alignment in bytes of the output packets.
+    write_combining : bool
+        True if narrow writes falling into the same output beat should be merged before being
+        sent. The beat is written when another beat is written, when it is read, when the
+        flush port is triggered or when the combining window expires.
+    read_coalescing : bool
+        True if narrow reads should fetch the whole output beat so that the next reads to the
+        same beat within the combining window are served by the converter. This must only be
+        used in front of memories which are not modified by other masters.
+    combining_window : int
+        Number of cycles during which writes are combined and read beats are kept.
+    """
+
+    def __init__(self, parent, name, output_width=4, output_align=4, write_combining=False,
+            read_coalescing=False, combining_window=16):
         super(Converter, self).__init__(parent, name)
 
         self.set_component('interco.converter_impl')
@@ -26,4 +49,7 @@ class Converter(st.Component):
         self.add_properties({
             'output_width': output_width,
             'output_align': output_align,
+            'write_combining': write_combining,
+            'read_coalescing': read_coalescing,
+            'combining_window': combining_window,
         })
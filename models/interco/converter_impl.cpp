@@ -21,7 +21,9 @@
 
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
+#include <vp/itf/wire.hpp>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 class converter : public vp::component
@@ -34,6 +36,7 @@ public:
   converter(js::config *config);
 
   int build();
+  void stop();
   void reset(bool active);
 
 
@@ -48,22 +51,42 @@ private:
 
   static void event_handler(void *__this, vp::clock_event *event);
 
+  static void wc_handler(void *__this, vp::clock_event *event);
+
+  static void flush_sync(void *__this, bool active);
+
   vp::io_req_status_e process_req(vp::io_req *req);
 
   vp::io_req_status_e process_pending_req(vp::io_req *req);
 
   void check_state();
 
+  inline bool is_beat_access(vp::io_req *req);
+
+  inline bool wc_overlaps(uint64_t offset, uint64_t size);
+
+  void wc_write(vp::io_req *req);
+
+  int64_t wc_flush();
+
+  int64_t wc_send(int start, int size);
+
+  vp::io_req_status_e rc_read(vp::io_req *req);
+
+  void rc_fill(vp::io_req *fetch, vp::io_req *req);
+
 
   vp::trace     trace;
 
   vp::io_master out;
   vp::io_slave in;
+  vp::wire_slave<bool> flush_itf;
 
   int output_width;
   int output_align;
 
   vp::io_req *pending_req;
+  vp::io_req *pending_last;
   vp::clock_event *event;
 
   int64_t ready_cycle;
@@ -71,6 +94,35 @@ private:
   vp::io_req *ongoing_req;
   vp::io_req *stalled_req;
   vp::io_req *last_stalled_req;
+
+  // Write-combining buffer. Narrow writes falling into the same output beat are merged
+  // and acknowledged right away, and the beat is written when another beat is written,
+  // when an access reads it, on a fence or when the combining window expires.
+  bool write_combining;
+  int combining_window;
+  vp::clock_event *wc_event;
+  bool wc_valid;
+  uint64_t wc_base;
+  uint8_t *wc_data;
+  bool *wc_mask;
+
+  // Read-coalescing buffer. Narrow reads fetch the whole output beat, and the next
+  // narrow reads to the same beat within the combining window are served from it.
+  // Writes going through the converter update it, which makes it only suitable for
+  // memories which are not modified by other masters during the window.
+  bool read_coalescing;
+  bool rc_valid;
+  uint64_t rc_base;
+  int64_t rc_expiry;
+  uint8_t *rc_data;
+
+  // Statistics
+  int64_t nb_writes;
+  int64_t nb_combined_writes;
+  int64_t nb_write_beats;
+  int64_t nb_reads;
+  int64_t nb_coalesced_reads;
+  int64_t nb_read_beats;
 };
 
 converter::converter(js::config *config)
@@ -94,6 +146,7 @@ void converter::event_handler(void *__this, vp::clock_event *event)
   {
     _this->ready_cycle = _this->get_cycles() + req->get_latency() + 1;
     _this->ongoing_size -= req->get_size();
+    _this->out.req_del(req);
     if (_this->ongoing_size == 0)
     {
       vp::io_req *req = _this->ongoing_req;
@@ -134,30 +187,44 @@ void converter::check_state()
 
 vp::io_req_status_e converter::process_pending_req(vp::io_req *req)
 {
-  uint64_t offset = req->get_addr();
-  uint64_t size = req->get_size();
   uint8_t *data = req->get_data();
   bool is_write = req->get_is_write();
 
   int mask = output_align - 1;
 
   ongoing_req = req;
-  ongoing_size = size;
+  ongoing_size = req->get_burst_size();
 
-  while (size)
+  // Bursts are converted chunk by chunk
+  int nb_chunks = req->get_nb_chunks();
+  for (int chunk=0; chunk<nb_chunks; chunk++)
   {
-    int iter_size = output_width;
-    if (offset & mask) iter_size -= offset & mask;
-    if (iter_size > size) iter_size = size;
-
-    vp::io_req *req = out.req_new(offset, data, iter_size, is_write);
-    req->set_next(pending_req);
-    pending_req = req;
+    uint64_t offset, size;
+    req->get_chunk(chunk, &offset, &size);
 
-
-    size -= iter_size;
-    offset += iter_size;
-    data += iter_size;
+    while (size)
+    {
+      int iter_size = output_width;
+      if (offset & mask) iter_size -= offset & mask;
+      if (iter_size > size) iter_size = size;
+
+      // Partial packets are sent in order, and are tagged so that they are not
+      // taken for combined writes or coalesced reads when they are replied
+      vp::io_req *req = out.req_new(offset, data, iter_size, is_write);
+      req->arg_push(NULL);
+      req->set_next(NULL);
+      if (pending_req)
+        pending_last->set_next(req);
+      else
+        pending_req = req;
+      pending_last = req;
+
+
+      size -= iter_size;
+      offset += iter_size;
+      if (data)
+        data += iter_size;
+    }
   }
 
   return vp::IO_REQ_PENDING;
@@ -173,7 +240,7 @@ vp::io_req_status_e converter::process_req(vp::io_req *req)
   int mask = output_align - 1;
 
   // Simple case where the request fit, just forward it
-  if ((offset & ~mask) == ((offset + size - 1) & ~mask))
+  if (req->get_burst() == NULL && (offset & ~mask) == ((offset + size - 1) & ~mask))
   {
     trace.msg("No conversion applied, forwarding request (req: %p)\n", req);
     return out.req_forward(req);
@@ -182,6 +249,179 @@ vp::io_req_status_e converter::process_req(vp::io_req *req)
   return this->process_pending_req(req);
 }
 
+inline bool converter::is_beat_access(vp::io_req *req)
+{
+  uint64_t offset = req->get_addr();
+  uint64_t size = req->get_size();
+  uint64_t mask = this->output_width - 1;
+
+  return req->get_burst() == NULL && !req->is_debug() && req->get_data() != NULL && size != 0 &&
+    (offset & ~mask) == ((offset + size - 1) & ~mask);
+}
+
+inline bool converter::wc_overlaps(uint64_t offset, uint64_t size)
+{
+  return this->wc_valid && offset < this->wc_base + this->output_width && offset + size > this->wc_base;
+}
+
+void converter::wc_write(vp::io_req *req)
+{
+  uint64_t offset = req->get_addr();
+  uint64_t size = req->get_size();
+  uint64_t base = offset & ~((uint64_t)this->output_width - 1);
+
+  this->nb_writes++;
+
+  if (this->wc_valid && this->wc_base != base)
+  {
+    // The buffer must be drained before it can take the new beat
+    req->inc_latency(this->wc_flush());
+  }
+
+  if (!this->wc_valid)
+  {
+    this->wc_valid = true;
+    this->wc_base = base;
+    memset(this->wc_mask, 0, this->output_width);
+    this->event_enqueue(this->wc_event, this->combining_window);
+  }
+  else
+  {
+    this->nb_combined_writes++;
+  }
+
+  this->trace.msg(vp::trace::LEVEL_TRACE, "Combining write (req: %p, offset: 0x%llx, size: 0x%llx, beat: 0x%llx)\n",
+    req, offset, size, base);
+
+  memcpy(&this->wc_data[offset - base], req->get_data(), size);
+  memset(&this->wc_mask[offset - base], 1, size);
+}
+
+int64_t converter::wc_flush()
+{
+  if (!this->wc_valid)
+    return 0;
+
+  this->wc_valid = false;
+  this->nb_write_beats++;
+
+  if (this->wc_event->is_enqueued())
+  {
+    this->event_cancel(this->wc_event);
+  }
+
+  this->trace.msg(vp::trace::LEVEL_TRACE, "Flushing combined writes (beat: 0x%llx)\n", this->wc_base);
+
+  // There is no byte enable on IO requests, so each contiguous set of written bytes
+  // is sent as a separate request
+  int64_t latency = 0;
+  int start = -1;
+  for (int i=0; i<=this->output_width; i++)
+  {
+    if (i < this->output_width && this->wc_mask[i])
+    {
+      if (start == -1)
+        start = i;
+    }
+    else if (start != -1)
+    {
+      int64_t iter_latency = this->wc_send(start, i - start);
+      if (iter_latency > latency)
+        latency = iter_latency;
+      start = -1;
+    }
+  }
+
+  return latency;
+}
+
+int64_t converter::wc_send(int start, int size)
+{
+  uint8_t *data = new uint8_t[size];
+  memcpy(data, &this->wc_data[start], size);
+
+  vp::io_req *req = this->out.req_new(this->wc_base + start, data, size, true);
+  req->arg_push(data);
+
+  vp::io_req_status_e err = this->out.req(req);
+  if (err == vp::IO_REQ_PENDING || err == vp::IO_REQ_DENIED)
+  {
+    // Released when the response is received
+    return 0;
+  }
+
+  if (err != vp::IO_REQ_OK)
+  {
+    this->trace.force_warning("Invalid combined write (offset: 0x%llx, size: 0x%x)\n", this->wc_base + start, size);
+  }
+
+  int64_t latency = req->get_full_latency();
+  delete[] data;
+  this->out.req_del(req);
+  return latency;
+}
+
+vp::io_req_status_e converter::rc_read(vp::io_req *req)
+{
+  uint64_t offset = req->get_addr();
+  uint64_t base = offset & ~((uint64_t)this->output_width - 1);
+
+  this->nb_reads++;
+
+  // Read-after-write, the combined writes must be written first
+  if (this->wc_overlaps(offset, req->get_size()))
+  {
+    req->inc_latency(this->wc_flush());
+  }
+
+  if (this->rc_valid && this->rc_base == base && this->get_cycles() < this->rc_expiry)
+  {
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Coalescing read (req: %p, offset: 0x%llx, size: 0x%llx)\n",
+      req, offset, req->get_size());
+    this->nb_coalesced_reads++;
+    memcpy(req->get_data(), &this->rc_data[offset - base], req->get_size());
+    return vp::IO_REQ_OK;
+  }
+
+  // Fetch the whole beat, the original request is kept in the fetch so that it can
+  // be replied if the fetch is asynchronous
+  this->nb_read_beats++;
+
+  uint8_t *data = new uint8_t[this->output_width];
+  vp::io_req *fetch = this->out.req_new(base, data, this->output_width, false);
+  fetch->status = vp::IO_REQ_OK;
+  fetch->arg_push(req);
+
+  vp::io_req_status_e err = this->out.req(fetch);
+  if (err == vp::IO_REQ_PENDING || err == vp::IO_REQ_DENIED)
+  {
+    return vp::IO_REQ_PENDING;
+  }
+
+  if (err == vp::IO_REQ_OK)
+  {
+    this->rc_fill(fetch, req);
+  }
+
+  delete[] data;
+  this->out.req_del(fetch);
+
+  return err;
+}
+
+void converter::rc_fill(vp::io_req *fetch, vp::io_req *req)
+{
+  uint64_t base = fetch->get_addr();
+
+  memcpy(this->rc_data, fetch->get_data(), this->output_width);
+  this->rc_valid = true;
+  this->rc_base = base;
+  this->rc_expiry = this->get_cycles() + fetch->get_full_latency() + this->combining_window;
+
+  memcpy(req->get_data(), &this->rc_data[req->get_addr() - base], req->get_size());
+  req->inc_latency(fetch->get_full_latency());
+}
+
 vp::io_req_status_e converter::req(void *__this, vp::io_req *req)
 {
   converter *_this = (converter *)__this;
@@ -206,6 +446,38 @@ vp::io_req_status_e converter::req(void *__this, vp::io_req *req)
     return vp::IO_REQ_DENIED;
   }
 
+  if (_this->write_combining || _this->read_coalescing)
+  {
+    bool is_beat = _this->is_beat_access(req);
+    uint64_t extent = req->get_burst_extent();
+
+    if (is_write)
+    {
+      // Keep the coalesced read data up-to-date
+      if (_this->rc_valid && offset < _this->rc_base + _this->output_width && offset + extent > _this->rc_base)
+      {
+        _this->rc_valid = false;
+      }
+
+      if (_this->write_combining && is_beat)
+      {
+        _this->wc_write(req);
+        return vp::IO_REQ_OK;
+      }
+
+      // Other writes must not overtake the combined ones
+      req->inc_latency(_this->wc_flush());
+    }
+    else if (_this->read_coalescing && is_beat)
+    {
+      return _this->rc_read(req);
+    }
+    else if (_this->wc_overlaps(offset, extent))
+    {
+      req->inc_latency(_this->wc_flush());
+    }
+  }
+
   if (_this->process_req(req) == vp::IO_REQ_OK)
     return vp::IO_REQ_OK;
 
@@ -218,8 +490,62 @@ void converter::grant(void *_this, vp::io_req *req)
 {
 }
 
-void converter::response(void *_this, vp::io_req *req)
+void converter::response(void *__this, vp::io_req *req)
+{
+  converter *_this = (converter *)__this;
+  void *arg = req->arg_pop();
+
+  // Partial packets
+  if (arg == NULL)
+    return;
+
+  if (req->get_is_write())
+  {
+    // Combined write
+    delete[] (uint8_t *)arg;
+    _this->out.req_del(req);
+  }
+  else
+  {
+    // Beat fetched for a coalesced read
+    vp::io_req *parent = (vp::io_req *)arg;
+    parent->status = req->status;
+    if (req->status == vp::IO_REQ_OK)
+    {
+      _this->rc_fill(req, parent);
+    }
+    delete[] req->get_data();
+    _this->out.req_del(req);
+    parent->get_resp_port()->resp(parent);
+  }
+}
+
+void converter::wc_handler(void *__this, vp::clock_event *event)
+{
+  converter *_this = (converter *)__this;
+
+  // The combining window has expired, the next partial packets will have to wait
+  // for the beat to be written
+  int64_t end_cycle = _this->get_cycles() + _this->wc_flush();
+  if (end_cycle > _this->ready_cycle)
+  {
+    _this->ready_cycle = end_cycle;
+  }
+}
+
+void converter::flush_sync(void *__this, bool active)
 {
+  converter *_this = (converter *)__this;
+
+  if (active)
+  {
+    int64_t end_cycle = _this->get_cycles() + _this->wc_flush();
+    if (end_cycle > _this->ready_cycle)
+    {
+      _this->ready_cycle = end_cycle;
+    }
+    _this->rc_valid = false;
+  }
 }
 
 int converter::build()
@@ -233,13 +559,57 @@ int converter::build()
   out.set_grant_meth(&converter::grant);
   new_master_port("out", &out);
 
+  flush_itf.set_sync_meth(&converter::flush_sync);
+  new_slave_port("flush", &flush_itf);
+
   output_width = get_config_int("output_width");
   output_align = get_config_int("output_align");
 
+  write_combining = get_js_config()->get_child_bool("write_combining");
+  read_coalescing = get_js_config()->get_child_bool("read_coalescing");
+  combining_window = get_js_config()->get_child_int("combining_window");
+  if (combining_window <= 0)
+  {
+    combining_window = 1;
+  }
+
+  if ((write_combining || read_coalescing) && (output_width & (output_width - 1)) != 0)
+  {
+    trace.fatal("Output width must be a power of 2 for write combining and read coalescing (width: %d)\n", output_width);
+    return -1;
+  }
+
+  wc_data = new uint8_t[output_width];
+  wc_mask = new bool[output_width];
+  rc_data = new uint8_t[output_width];
+
+  nb_writes = 0;
+  nb_combined_writes = 0;
+  nb_write_beats = 0;
+  nb_reads = 0;
+  nb_coalesced_reads = 0;
+  nb_read_beats = 0;
+
   event = event_new(converter::event_handler);
+  wc_event = event_new(converter::wc_handler);
   return 0;
 }
 
+void converter::stop()
+{
+  if (this->nb_writes)
+  {
+    this->trace.msg(vp::trace::LEVEL_INFO, "Write combining statistics (writes: %ld, combined: %ld, beats: %ld, merge rate: %f)\n",
+      this->nb_writes, this->nb_combined_writes, this->nb_write_beats, (float)this->nb_combined_writes / this->nb_writes);
+  }
+
+  if (this->nb_reads)
+  {
+    this->trace.msg(vp::trace::LEVEL_INFO, "Read coalescing statistics (reads: %ld, coalesced: %ld, beats: %ld, merge rate: %f)\n",
+      this->nb_reads, this->nb_coalesced_reads, this->nb_read_beats, (float)this->nb_coalesced_reads / this->nb_reads);
+  }
+}
+
 extern "C" vp::component *vp_constructor(js::config *config)
 {
   return new converter(config);
@@ -251,9 +621,12 @@ void converter::reset(bool active)
   if (active)
   {
     pending_req = NULL;
+    pending_last = NULL;
     ready_cycle = 0;
     ongoing_req = NULL;
     ongoing_size = 0;
     stalled_req = NULL;
+    wc_valid = false;
+    rc_valid = false;
   }
 }
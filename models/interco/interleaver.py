@@ -35,10 +35,15 @@ class Interleaver(st.Component):
     remove_offset: int, optional
         Specify an offset to be removed to the incoming access address when it is
         dispatched (default: 0).
+    max_pending: int, optional
+        Maximum number of chunks which can be outstanding on each bank. When it is
+        0 (default), the number is unlimited and requests which fit in one bank are
+        directly forwarded to it.
     
     """
 
-    def __init__(self, parent, name, nb_slaves: int, interleaving_bits: int, stage_bits: int=0, remove_offset: int=0):
+    def __init__(self, parent, name, nb_slaves: int, interleaving_bits: int, stage_bits: int=0, remove_offset: int=0,
+            max_pending: int=0):
 
         super(Interleaver, self).__init__(parent, name)
 
@@ -49,4 +54,5 @@ class Interleaver(st.Component):
             'interleaving_bits': interleaving_bits,
             'stage_bits': stage_bits,
             'remove_offset': remove_offset,
+            'max_pending': max_pending,
         })
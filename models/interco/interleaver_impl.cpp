@@ -24,6 +24,18 @@
 #include <stdio.h>
 #include <math.h>
 
+// Context of a request which is split into several chunks dispatched to the banks.
+// The request is completed when all its chunks are done.
+class Interleaver_req
+{
+public:
+  vp::io_req *req;
+  vp::io_req_status_e status;
+  int pending;
+  int64_t start_cycles;
+  int64_t end_cycles;
+};
+
 class interleaver : public vp::component
 {
 
@@ -32,6 +44,7 @@ public:
   interleaver(js::config *config);
 
   int build();
+  void reset(bool active);
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
 
@@ -41,6 +54,12 @@ public:
   static void response(void *_this, vp::io_req *req);
 
 private:
+  vp::io_req_status_e forward_req(vp::io_req *req, int output_id, uint64_t new_offset);
+  vp::io_req_status_e split_req(vp::io_req *req);
+  void send_chunk(int output_id, vp::io_req *chunk);
+  void flush_bank(int output_id);
+  void chunk_done(vp::io_req *chunk, int64_t cycles);
+
   vp::trace     trace;
 
   vp::io_master **out;
@@ -53,6 +72,14 @@ private:
   int stage_bits;
   uint64_t offset_mask;
   uint64_t remove_offset;
+
+  // Maximum number of chunks which can be outstanding on each bank, 0 if unlimited
+  int max_pending;
+  // Per-bank state, number of outstanding chunks, denied flag and chunks waiting to be sent
+  int *bank_pending;
+  bool *bank_denied;
+  vp::io_req **bank_first;
+  vp::io_req **bank_last;
 };
 
 interleaver::interleaver(js::config *config)
@@ -61,91 +88,237 @@ interleaver::interleaver(js::config *config)
 
 }
 
-vp::io_req_status_e interleaver::req(void *__this, vp::io_req *req)
+vp::io_req_status_e interleaver::forward_req(vp::io_req *req, int output_id, uint64_t new_offset)
 {
-  interleaver *_this = (interleaver *)__this;
   uint64_t offset = req->get_addr();
-  bool is_write = req->get_is_write();
-  uint64_t size = req->get_size();
-  uint8_t *data = req->get_data();
   int64_t latency = req->get_latency();
 
-  uint8_t *init_data = data;
-  uint64_t init_size = size;
-  uint64_t init_offset = offset;
+  // The whole request falls into one bank, forward it so that the bank replies
+  // directly to the initiator
+  req->set_addr(new_offset);
+  req->set_latency(0);
 
-  _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, is_write);
- 
-  int port_size = 1<<_this->interleaving_bits;
-  int align_size = offset & (port_size - 1);
-  if (align_size) align_size = port_size - align_size;
+  vp::io_req_status_e err = this->out[output_id]->req_forward(req);
+  if (err == vp::IO_REQ_OK)
+  {
+    int64_t iter_latency = req->get_latency();
+    if (iter_latency > latency)
+    {
+      latency = iter_latency;
+    }
 
-  offset -= _this->remove_offset;
+    req->set_addr(offset);
+    req->set_latency(latency);
+  }
 
-  while(size) {
-    
-    int loop_size = port_size;
-    if (align_size) {
-      loop_size = align_size;
-      align_size = 0;
-    }
-    if (loop_size > size) loop_size = size;
+  return err;
+}
 
-    int output_id = (offset >> _this->interleaving_bits) & ((1 << _this->stage_bits) - 1);
-    uint64_t new_offset = ((offset & _this->offset_mask) >> _this->stage_bits) + (offset & ((1<<_this->interleaving_bits)-1));
+vp::io_req_status_e interleaver::split_req(vp::io_req *req)
+{
+  bool is_write = req->get_is_write();
+  uint8_t *data = req->get_data();
+  int port_size = 1<<this->interleaving_bits;
+
+  Interleaver_req *ctx = new Interleaver_req();
+  ctx->req = req;
+  ctx->status = vp::IO_REQ_OK;
+  ctx->start_cycles = this->get_cycles();
+  ctx->end_cycles = ctx->start_cycles;
+  // Keep one extra reference while the chunks are being sent so that the request
+  // is not completed by a chunk which is done before all chunks are sent
+  ctx->pending = 1;
+
+  // Each chunk of a burst is interleaved on the banks like a normal request, and
+  // the burst is completed when all the bank chunks are done
+  int nb_chunks = req->get_nb_chunks();
+  for (int burst_chunk=0; burst_chunk<nb_chunks && ctx->status == vp::IO_REQ_OK; burst_chunk++)
+  {
+    uint64_t offset, size;
+    req->get_chunk(burst_chunk, &offset, &size);
 
-    _this->trace.msg("Forwarding interleaved packet (port: %d, offset: 0x%x, size: 0x%x)\n", output_id, new_offset, loop_size);
+    int align_size = offset & (port_size - 1);
+    if (align_size) align_size = port_size - align_size;
 
-    if (!_this->out[output_id]) return vp::IO_REQ_INVALID;
+    offset -= this->remove_offset;
 
-    req->set_addr(new_offset);
-    req->set_size(loop_size);
-    req->set_data(data);
-    req->set_latency(0);
+    while(size) {
 
-    vp::io_req_status_e err = _this->out[output_id]->req_forward(req);
-    if (err != vp::IO_REQ_OK)
-    {
-      // Temporary hack, until this component supports asynchronous requests.
-      // If we get an asynchronous reply and we are done, just return
-      if (err == vp::IO_REQ_PENDING && size == loop_size)
-      {
-        return vp::IO_REQ_PENDING;
+      int loop_size = port_size;
+      if (align_size) {
+        loop_size = align_size;
+        align_size = 0;
       }
-      else
+      if (loop_size > size) loop_size = size;
+
+      int output_id = (offset >> this->interleaving_bits) & ((1 << this->stage_bits) - 1);
+      uint64_t new_offset = ((offset & this->offset_mask) >> this->stage_bits) + (offset & ((1<<this->interleaving_bits)-1));
+
+      if (!this->out[output_id]->is_bound())
       {
-        return vp::IO_REQ_INVALID;
+        ctx->status = vp::IO_REQ_INVALID;
+        break;
       }
+
+      vp::io_req *chunk = this->out[output_id]->req_new(new_offset, data, loop_size, is_write);
+      chunk->set_debug(req->is_debug());
+      chunk->arg_push(ctx);
+      chunk->arg_push((void *)(long)output_id);
+      ctx->pending++;
+
+      this->trace.msg("Sending interleaved chunk (req: %p, chunk: %p, port: %d, offset: 0x%x, size: 0x%x)\n", req, chunk, output_id, new_offset, loop_size);
+
+      this->send_chunk(output_id, chunk);
+
+      size -= loop_size;
+      offset += loop_size;
+      if (data)
+        data += loop_size;
     }
-    
-    int64_t iter_latency = req->get_latency();
-    if (iter_latency > latency)
+  }
+
+  ctx->pending--;
+
+  if (ctx->pending == 0)
+  {
+    // All chunks were handled synchronously
+    vp::io_req_status_e status = ctx->status;
+    int64_t latency = ctx->end_cycles - ctx->start_cycles;
+    if (latency > (int64_t)req->get_latency())
     {
-      latency = iter_latency;
+      req->set_latency(latency);
+    }
+    delete ctx;
+    return status;
+  }
+
+  return vp::IO_REQ_PENDING;
+}
+
+void interleaver::send_chunk(int output_id, vp::io_req *chunk)
+{
+  // Keep the chunks ordered on each bank, and do not exceed the number of outstanding chunks
+  if (this->bank_first[output_id] || this->bank_denied[output_id] ||
+    (this->max_pending && this->bank_pending[output_id] >= this->max_pending))
+  {
+    this->trace.msg("Bank is busy, queueing chunk (chunk: %p, port: %d)\n", chunk, output_id);
+
+    chunk->set_next(NULL);
+    if (this->bank_first[output_id])
+      this->bank_last[output_id]->set_next(chunk);
+    else
+      this->bank_first[output_id] = chunk;
+    this->bank_last[output_id] = chunk;
+    return;
+  }
+
+  this->bank_pending[output_id]++;
+
+  vp::io_req_status_e err = this->out[output_id]->req(chunk);
+  if (err == vp::IO_REQ_OK || err == vp::IO_REQ_INVALID)
+  {
+    if (err == vp::IO_REQ_INVALID)
+    {
+      Interleaver_req *ctx = (Interleaver_req *)*chunk->arg_get(0);
+      ctx->status = vp::IO_REQ_INVALID;
     }
-    
-    size -= loop_size;
-    offset += loop_size;
-    if (data)
-      data += loop_size;
+    this->bank_pending[output_id]--;
+    this->chunk_done(chunk, this->get_cycles());
   }
+  else if (err == vp::IO_REQ_DENIED)
+  {
+    // The bank will grant the chunk later on, stop sending until then
+    this->bank_denied[output_id] = true;
+  }
+}
+
+void interleaver::flush_bank(int output_id)
+{
+  while (this->bank_first[output_id] && !this->bank_denied[output_id] &&
+    (!this->max_pending || this->bank_pending[output_id] < this->max_pending))
+  {
+    vp::io_req *chunk = this->bank_first[output_id];
+    this->bank_first[output_id] = chunk->get_next();
+    this->send_chunk(output_id, chunk);
+  }
+}
+
+void interleaver::chunk_done(vp::io_req *chunk, int64_t cycles)
+{
+  int output_id = (int)(long)chunk->arg_pop();
+  Interleaver_req *ctx = (Interleaver_req *)chunk->arg_pop();
+
+  // The chunks are handled in parallel by the banks, the request is done when the
+  // last one is done
+  int64_t end_cycles = cycles + chunk->get_full_latency();
+  if (end_cycles > ctx->end_cycles)
+  {
+    ctx->end_cycles = end_cycles;
+  }
+
+  this->out[output_id]->req_del(chunk);
+
+  ctx->pending--;
+  if (ctx->pending == 0)
+  {
+    vp::io_req *req = ctx->req;
+
+    this->trace.msg("Finished handling request (req: %p)\n", req);
+
+    req->set_latency(ctx->end_cycles - cycles);
+    req->status = ctx->status;
+    delete ctx;
+    req->get_resp_port()->resp(req);
+  }
+}
+
+vp::io_req_status_e interleaver::req(void *__this, vp::io_req *req)
+{
+  interleaver *_this = (interleaver *)__this;
+  uint64_t offset = req->get_addr();
+  bool is_write = req->get_is_write();
+  uint64_t size = req->get_size();
 
-  req->set_addr(init_offset);
-  req->set_size(init_size);
-  req->set_data(init_data);
-  req->set_latency(latency);
+  _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, is_write);
+ 
+  int port_size = 1<<_this->interleaving_bits;
+
+  // Single-chunk requests are directly forwarded to the bank, unless the outstanding
+  // requests per bank are limited, since they must then be tracked
+  if (_this->max_pending == 0 && req->get_burst() == NULL &&
+    (offset & ~(port_size - 1)) == ((offset + size - 1) & ~(port_size - 1)))
+  {
+    uint64_t bank_offset = offset - _this->remove_offset;
+    int output_id = (bank_offset >> _this->interleaving_bits) & ((1 << _this->stage_bits) - 1);
+    uint64_t new_offset = ((bank_offset & _this->offset_mask) >> _this->stage_bits) + (bank_offset & ((1<<_this->interleaving_bits)-1));
+
+    _this->trace.msg("Forwarding interleaved packet (port: %d, offset: 0x%x, size: 0x%x)\n", output_id, new_offset, size);
 
+    if (!_this->out[output_id]->is_bound()) return vp::IO_REQ_INVALID;
 
-  return vp::IO_REQ_OK;
+    return _this->forward_req(req, output_id, new_offset);
+  }
+
+  return _this->split_req(req);
 }
 
-void interleaver::grant(void *_this, vp::io_req *req)
+void interleaver::grant(void *__this, vp::io_req *req)
 {
+  interleaver *_this = (interleaver *)__this;
+  int output_id = (long)*req->arg_get();
 
+  _this->bank_denied[output_id] = false;
+  _this->flush_bank(output_id);
 }
 
-void interleaver::response(void *_this, vp::io_req *req)
+void interleaver::response(void *__this, vp::io_req *req)
 {
+  interleaver *_this = (interleaver *)__this;
+  int output_id = (long)*req->arg_get();
+
+  _this->bank_pending[output_id]--;
+  _this->chunk_done(req, _this->get_cycles());
+  _this->flush_bank(output_id);
 }
 
 int interleaver::build()
@@ -160,6 +333,7 @@ int interleaver::build()
   stage_bits = get_config_int("stage_bits");
   interleaving_bits = get_config_int("interleaving_bits");
   remove_offset = get_config_int("remove_offset");
+  max_pending = get_config_int("max_pending");
 
   if (stage_bits == 0)
   {
@@ -178,6 +352,11 @@ int interleaver::build()
     new_master_port("out_" + std::to_string(i), out[i]);
   }
 
+  bank_pending = new int[nb_slaves];
+  bank_denied = new bool[nb_slaves];
+  bank_first = new vp::io_req *[nb_slaves];
+  bank_last = new vp::io_req *[nb_slaves];
+
   masters_in = new vp::io_slave *[nb_masters];
   for (int i=0; i<nb_masters; i++)
   {
@@ -188,6 +367,19 @@ int interleaver::build()
   return 0;
 }
 
+void interleaver::reset(bool active)
+{
+  if (active)
+  {
+    for (int i=0; i<nb_slaves; i++)
+    {
+      bank_pending[i] = 0;
+      bank_denied[i] = false;
+      bank_first[i] = NULL;
+    }
+  }
+}
+
 extern "C" vp::component *vp_constructor(js::config *config)
 {
   return new interleaver(config);
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+// Routing micro-benchmark.
+// A router is instantiated outside of any simulation, with a synthetic SoC-like map of
+// targets of various sizes, and requests are sent to router::req back-to-back to measure
+// the host time spent per request.
+// Each run is done with two access patterns: "local", where consecutive requests go to
+// the same target, as for a core executing from one memory, and "scattered", where each
+// request goes to a random target.
+//
+// Usage: router_bench [nb_requests] [nb_targets...]
+// By default, 10M requests are sent for maps of 20, 35 and 50 targets.
+// As the trace domain is instantiated, an empty trace_file.txt is created in the current
+// directory.
+
+#include <chrono>
+#include <random>
+
+// The router is only defined in its model source, which is included here with its
+// constructor renamed, as the trace domain, which the router needs for its traces,
+// provides one too.
+#define vp_constructor router_vp_constructor
+#include "router_impl.cpp"
+#undef vp_constructor
+
+extern "C" vp::component *vp_constructor(js::config *config);
+
+
+static vp::io_req_status_e target_req(void *__this, vp::io_req *req)
+{
+  return vp::IO_REQ_OK;
+}
+
+
+static double run(int nb_targets, int64_t nb_requests, bool local)
+{
+  // Targets are placed as on a SoC, with sizes going from a few registers to big memories,
+  // and holes between them
+  std::string mappings;
+  std::vector<uint64_t> bases, sizes;
+  uint64_t base = 0x10000000;
+  for (int i=0; i<nb_targets; i++)
+  {
+    uint64_t size = 0x1000ULL << ((i * 7) % 13);
+    bases.push_back(base);
+    sizes.push_back(size);
+
+    if (i) mappings += ", ";
+    mappings += "\"target_" + std::to_string(i) + "\": {\"base\": " + std::to_string(base) + ", \"size\": " + std::to_string(size) + "}";
+
+    base += size + 0x1000;
+  }
+
+  js::config *config = js::import_config_from_string("{\"mappings\": {" + mappings + "}, \"latency\": 0, \"bandwidth\": 0}");
+
+  router *bench_router = (router *)router_vp_constructor(config);
+  bench_router->new_service("trace", vp_constructor(js::import_config_from_string("{}")));
+  bench_router->build();
+
+  // All targets answer immediately from the same slave port
+  vp::io_slave target;
+  target.set_owner(bench_router);
+  target.set_req_meth(&target_req);
+
+  for (int i=0; i<nb_targets; i++)
+  {
+    vp::io_master *itf = (vp::io_master *)bench_router->get_master_port("target_" + std::to_string(i));
+    itf->bind_to(&target, NULL);
+    target.bind_to(itf, NULL);
+  }
+
+  // Addresses are generated before the measure, so that only the routing is measured
+  std::mt19937_64 rand(0);
+  std::vector<uint64_t> addrs(4096);
+  for (size_t i=0; i<addrs.size(); i++)
+  {
+    int target_id = local ? (i / 1024) % nb_targets : rand() % nb_targets;
+    addrs[i] = bases[target_id] + (rand() % sizes[target_id] & ~3ULL);
+  }
+
+  uint32_t data;
+  vp::io_req req;
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (int64_t i=0; i<nb_requests; i++)
+  {
+    req.init();
+    req.set_addr(addrs[i & (addrs.size() - 1)]);
+    req.set_size(4);
+    req.set_data((uint8_t *)&data);
+    req.set_is_write(false);
+
+    if (router::req(bench_router, &req) != vp::IO_REQ_OK)
+    {
+      fprintf(stderr, "Request was not routed (addr: 0x%lx)\n", req.get_addr());
+      exit(1);
+    }
+  }
+
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+  return elapsed.count() / nb_requests;
+}
+
+
+int main(int argc, char **argv)
+{
+  int64_t nb_requests = argc > 1 ? strtoll(argv[1], NULL, 0) : 10000000;
+  std::vector<int> nb_targets_list;
+
+  for (int i=2; i<argc; i++)
+  {
+    nb_targets_list.push_back(atoi(argv[i]));
+  }
+
+  if (nb_targets_list.size() == 0)
+  {
+    nb_targets_list = { 20, 35, 50 };
+  }
+
+  for (int nb_targets: nb_targets_list)
+  {
+    printf("targets: %3d, local: %6.2f ns/req, scattered: %6.2f ns/req\n", nb_targets,
+      run(nb_targets, nb_requests, true), run(nb_targets, nb_requests, false));
+  }
+
+  return 0;
+}
@@ -56,27 +56,35 @@ public:
 class MapEntry {
 public:
   MapEntry() {}
-  MapEntry(unsigned long long base, MapEntry *left, MapEntry *right);
 
   void insert(router *router);
 
   string target_name;
   MapEntry *next = NULL;
   int id = -1;
+  Perf_counter *counter = NULL;
   unsigned long long base = 0;
-  unsigned long long lowestBase = 0;
   unsigned long long size = 0;
   unsigned long long remove_offset = 0;
   unsigned long long add_offset = 0;
   uint32_t latency = 0;
   int64_t next_read_packet_time = 0;
   int64_t next_write_packet_time = 0;
-  MapEntry *left = NULL;
-  MapEntry *right = NULL;
   vp::io_slave *port = NULL;
   vp::io_master *itf = NULL;
 };
 
+// Context of a request which spans several mapping entries and is split into
+// one piece per target. The parent request is completed when all pieces are done.
+class Router_split {
+public:
+  vp::io_req *parent;
+  vp::io_req_status_e status;
+  int pending;
+  int64_t start_cycles;
+  int64_t end_cycles;
+};
+
 class io_master_map : public vp::io_master
 {
 
@@ -111,12 +119,25 @@ private:
   bool init = false;
 
   void init_entries();
+  inline MapEntry *get_entry(uint64_t offset);
+  MapEntry *find_entry(uint64_t offset, uint64_t size);
+  vp::io_req_status_e forward(vp::io_req *req, MapEntry *entry, Router_split *split);
+  vp::io_req_status_e split_req(vp::io_req *req);
+  void split_piece_done(Router_split *split, vp::io_req *piece, int64_t cycles);
+  void split_response(vp::io_req *piece);
+
   MapEntry *firstMapEntry = NULL;
   MapEntry *defaultMapEntry = NULL;
   MapEntry *errorMapEntry = NULL;
-  MapEntry *topMapEntry = NULL;
   MapEntry *externalBindingMapEntry = NULL;
 
+  // Mapping entries sorted by base address, with their bases in a separate
+  // contiguous array to speed-up the binary search
+  std::vector<MapEntry *> entries;
+  std::vector<uint64_t> entries_base;
+  // Last entry which was hit, checked first as accesses are usually local
+  MapEntry *last_entry = NULL;
+
   std::map<int, Perf_counter *> counters;
 
   int bandwidth = 0;
@@ -130,13 +151,8 @@ router::router(js::config *config)
 
 }
 
-MapEntry::MapEntry(unsigned long long base, MapEntry *left, MapEntry *right) : next(NULL), base(base), lowestBase(left->lowestBase), left(left), right(right) {
-}
-
 void MapEntry::insert(router *router)
 {
-  lowestBase = base;
-
   if (size != 0) {
     if (port != NULL || itf != NULL) {    
       MapEntry *current = router->firstMapEntry;
@@ -162,173 +178,321 @@ void MapEntry::insert(router *router)
   }
 }
 
-vp::io_req_status_e router::req(void *__this, vp::io_req *req)
+inline MapEntry *router::get_entry(uint64_t offset)
 {
-  router *_this = (router *)__this;
-  vp::io_req_status_e result;
-  
-  if (!_this->init)
+  MapEntry *entry = this->last_entry;
+
+  if (entry && offset >= entry->base && offset - entry->base < entry->size)
   {
-    _this->init = true;
-    _this->init_entries();
+    return entry;
   }
 
-  uint64_t offset = req->get_addr();
-  uint64_t size = req->get_size();
-  uint8_t *data = req->get_data();
-  uint64_t req_size = size;
-  uint64_t req_offset = offset;
-  uint8_t *req_data = data;
+  // Look for the last entry whose base is lower or equal to the offset
+  int low = 0;
+  int high = this->entries_base.size();
+  while (low < high)
+  {
+    int mid = (low + high) / 2;
+    if (this->entries_base[mid] <= offset)
+      low = mid + 1;
+    else
+      high = mid;
+  }
 
-  int count = 0;
-  while (size)
+  if (low == 0)
   {
-    MapEntry *entry = _this->topMapEntry;
-    bool isRead = !req->get_is_write();
+    return NULL;
+  }
 
-    _this->trace.msg(vp::trace::LEVEL_TRACE, "Received IO req (offset: 0x%llx, size: 0x%llx, isRead: %d, bandwidth: %d)\n",
-        offset, size, isRead, _this->bandwidth);
+  entry = this->entries[low - 1];
+  if (offset - entry->base >= entry->size)
+  {
+    return NULL;
+  }
 
-    if (entry)
-    {
-      while(1) {
-      // The entry does not have any child, this means we are at a final entry
-        if (entry->left == NULL) break;
+  this->last_entry = entry;
 
-        if (offset >= entry->base) entry = entry->right;
-        else entry = entry->left;
-      }
+  return entry;
+}
 
-      if (entry && (offset < entry->base || offset > entry->base + entry->size - 1)) {
-        entry = NULL;
-      }
-    }
+MapEntry *router::find_entry(uint64_t offset, uint64_t size)
+{
+  MapEntry *entry = this->get_entry(offset);
 
-    if (!entry) {
-      if (_this->errorMapEntry && offset >= _this->errorMapEntry->base && offset + size - 1 <= _this->errorMapEntry->base + _this->errorMapEntry->size - 1) {
-      } else {
-        entry = _this->defaultMapEntry;
-      }
+  if (!entry) {
+    if (this->errorMapEntry && offset >= this->errorMapEntry->base && offset + size - 1 <= this->errorMapEntry->base + this->errorMapEntry->size - 1) {
+    } else {
+      entry = this->defaultMapEntry;
     }
+  }
 
-    if (!entry) {
-      //_this->trace.msg(&warning, "Invalid access (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
-      return vp::IO_REQ_INVALID;
-    }
+  return entry;
+}
 
-    if (entry == _this->defaultMapEntry) {
-      _this->trace.msg(vp::trace::LEVEL_TRACE, "Routing to default entry (target: %s)\n", entry->target_name.c_str());
-    } else {
-      _this->trace.msg(vp::trace::LEVEL_TRACE, "Routing to entry (target: %s)\n", entry->target_name.c_str());
-    }
-    
-    if (!req->is_debug())
+vp::io_req_status_e router::forward(vp::io_req *req, MapEntry *entry, Router_split *split)
+{
+  vp::io_req_status_e result;
+  uint64_t offset = req->get_addr();
+  uint64_t size = req->get_size();
+  bool isRead = !req->get_is_write();
+
+  if (entry == this->defaultMapEntry) {
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Routing to default entry (target: %s)\n", entry->target_name.c_str());
+  } else {
+    this->trace.msg(vp::trace::LEVEL_TRACE, "Routing to entry (target: %s)\n", entry->target_name.c_str());
+  }
+
+  if (!req->is_debug())
+  {
+    if (this->bandwidth != 0)
     {
-      if (_this->bandwidth != 0)
-      {
-        // Duration of this packet in this router according to router bandwidth
-        int64_t packet_duration = (size + _this->bandwidth - 1) / _this->bandwidth;
-
-        // Update packet duration
-        // This will update it only if it is bigger than the current duration, in case there is a
-        // slower router on the path
-        req->set_duration(packet_duration);
-
-        // Update the request latency.
-        int64_t latency = req->get_latency();
-        // First check if the latency should be increased due to bandwidth 
-        int64_t *next_packet_time = req->get_is_write() ? &entry->next_write_packet_time : &entry->next_read_packet_time;
-        int64_t router_latency = *next_packet_time - _this->get_cycles();
-        if (router_latency > latency)
-        {
-          latency = router_latency;
-        }
+      // Duration of this packet in this router according to router bandwidth.
+      // Bursts are accounted as a whole.
+      uint64_t burst_size = req->get_burst_size();
+      int64_t packet_duration = (burst_size + this->bandwidth - 1) / this->bandwidth;
 
-        // Then apply the router latency
-        req->set_latency(latency + entry->latency + _this->latency);
+      // Update packet duration
+      // This will update it only if it is bigger than the current duration, in case there is a
+      // slower router on the path
+      req->set_duration(packet_duration);
 
-        // Update the bandwidth information
-        int64_t router_time = _this->get_cycles();
-        if (router_time < *next_packet_time)
-        {
-          router_time = *next_packet_time;
-        }
-        *next_packet_time = router_time + packet_duration;
+      // Update the request latency.
+      int64_t latency = req->get_latency();
+      // First check if the latency should be increased due to bandwidth 
+      int64_t *next_packet_time = req->get_is_write() ? &entry->next_write_packet_time : &entry->next_read_packet_time;
+      int64_t router_latency = *next_packet_time - this->get_cycles();
+      if (router_latency > latency)
+      {
+        latency = router_latency;
       }
-      else
+
+      // Then apply the router latency
+      req->set_latency(latency + entry->latency + this->latency);
+
+      // Update the bandwidth information
+      int64_t router_time = this->get_cycles();
+      if (router_time < *next_packet_time)
       {
-        req->inc_latency(entry->latency + _this->latency);
+        router_time = *next_packet_time;
       }
+      *next_packet_time = router_time + packet_duration;
     }
+    else
+    {
+      req->inc_latency(entry->latency + this->latency);
+    }
+  }
 
-    int iter_size = entry == _this->defaultMapEntry ? size : entry->size - (offset - entry->base);
+  // Forward the request to the target port
+  if (entry->remove_offset) req->set_addr(offset - entry->remove_offset);
+  if (entry->add_offset) req->set_addr(offset + entry->add_offset);
 
-    if (iter_size > size)
+  // Pieces of a split request are tagged with the router itself instead of the
+  // response port, so that their responses are merged into the parent request
+  result = vp::IO_REQ_OK;
+  if (entry->port)
+  {
+    req->arg_push(split ? (void *)this : NULL);
+    result = this->out.req(req, entry->port);
+    if (result == vp::IO_REQ_OK)
+      req->arg_pop();
+  }
+  else if (entry->itf)
+  {
+    if (!entry->itf->is_bound())
     {
-      iter_size = size;
+      this->warning.msg(vp::trace::LEVEL_WARNING, "Invalid access, trying to route to non-connected interface (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, !isRead);
+      return vp::IO_REQ_INVALID;
     }
+    req->arg_push(split ? (void *)this : (void *)req->resp_port);
+    result = entry->itf->req(req);
+    if (result == vp::IO_REQ_OK)
+      req->arg_pop();
+  }
+
+  if (entry->counter) 
+  {
+    int64_t latency = req->get_latency();
+    int64_t duration = req->get_duration();
+    if (duration > 1) latency += duration - 1;
+
+    Perf_counter *counter = entry->counter;
+
+    if (isRead)
+      counter->read_stalls += latency;
+    else
+      counter->write_stalls += latency;
+  
+    if (isRead)
+      counter->nb_read++;
+    else
+      counter->nb_write++;
+
+  }
 
-    // Forward the request to the target port
+  if (result == vp::IO_REQ_OK)
+  {
     req->set_addr(offset);
-    req->set_size(iter_size);
-    req->set_data(data);
-    if (entry->remove_offset) req->set_addr(offset - entry->remove_offset);
-    if (entry->add_offset) req->set_addr(offset + entry->add_offset);
+  }
 
-    result = vp::IO_REQ_OK;
-    if (entry->port)
-    {
-      req->arg_push(NULL);
-      result = _this->out.req(req, entry->port);
-      if (result == vp::IO_REQ_OK)
-        req->arg_pop();
-    }
-    else if (entry->itf)
+  return result;
+}
+
+vp::io_req_status_e router::req(void *__this, vp::io_req *req)
+{
+  router *_this = (router *)__this;
+  
+  if (!_this->init)
+  {
+    _this->init = true;
+    _this->init_entries();
+  }
+
+  uint64_t offset = req->get_addr();
+  uint64_t size = req->get_size();
+  bool isRead = !req->get_is_write();
+
+  _this->trace.msg(vp::trace::LEVEL_TRACE, "Received IO req (offset: 0x%llx, size: 0x%llx, isRead: %d, bandwidth: %d)\n",
+      offset, size, isRead, _this->bandwidth);
+
+  // Bursts are routed as a whole if all their chunks go to the same target
+  uint64_t extent = req->get_burst() ? req->get_burst_extent() : size;
+
+  MapEntry *entry = _this->find_entry(offset, extent);
+
+  if (!entry) {
+    //_this->trace.msg(&warning, "Invalid access (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
+    return vp::IO_REQ_INVALID;
+  }
+
+  // Usual case, the whole access goes to the same target
+  if (entry == _this->defaultMapEntry || offset - entry->base + extent <= entry->size)
+  {
+    return _this->forward(req, entry, NULL);
+  }
+
+  return _this->split_req(req);
+}
+
+vp::io_req_status_e router::split_req(vp::io_req *req)
+{
+  uint64_t offset = req->get_addr();
+  uint64_t size = req->get_burst_size();
+  uint8_t *data = req->get_data();
+
+  Router_split *split = new Router_split();
+  split->parent = req;
+  split->status = vp::IO_REQ_OK;
+  split->start_cycles = this->get_cycles();
+  split->end_cycles = split->start_cycles;
+  // Keep one extra reference while the pieces are being sent so that the parent
+  // is not completed by a piece responding before all pieces have been sent
+  split->pending = 1;
+
+  this->trace.msg(vp::trace::LEVEL_DEBUG, "Splitting request over several targets (req: %p, offset: 0x%llx, size: 0x%llx)\n",
+    req, offset, size);
+
+  // Bursts are split chunk by chunk, each chunk being split over the targets it spans
+  int nb_chunks = req->get_nb_chunks();
+  for (int chunk=0; chunk<nb_chunks && split->status == vp::IO_REQ_OK; chunk++)
+  {
+    req->get_chunk(chunk, &offset, &size);
+
+    while (size)
     {
-      if (!entry->itf->is_bound())
+      MapEntry *entry = this->find_entry(offset, size);
+
+      if (!entry) {
+        split->status = vp::IO_REQ_INVALID;
+        break;
+      }
+
+      uint64_t iter_size = entry == this->defaultMapEntry ? size : entry->size - (offset - entry->base);
+
+      if (iter_size > size)
       {
-        _this->warning.msg(vp::trace::LEVEL_WARNING, "Invalid access, trying to route to non-connected interface (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, !isRead);
-        return vp::IO_REQ_INVALID;
+        iter_size = size;
       }
-      req->arg_push(req->resp_port);
-      result = entry->itf->req(req);
-      if (result == vp::IO_REQ_OK)
-        req->arg_pop();
-    }
 
-    if (entry->id != -1) 
-    {
-      int64_t latency = req->get_latency();
-      int64_t duration = req->get_duration();
-      if (duration > 1) latency += duration - 1;
+      vp::io_req *piece = this->out.req_new(offset, data, iter_size, req->get_is_write());
+      piece->set_debug(req->is_debug());
+      piece->arg_push(split);
 
-      Perf_counter *counter = _this->counters[entry->id];
+      split->pending++;
 
-      if (isRead)
-        counter->read_stalls += latency;
-      else
-        counter->write_stalls += latency;
-    
-      if (isRead)
-        counter->nb_read++;
+      vp::io_req_status_e result = this->forward(piece, entry, split);
+
+      // A denied piece is still owned by the target, which grants it later and then
+      // responds, so it is kept outstanding like a pending one. Its grant is ignored
+      // and it is completed by its response.
+      if (result == vp::IO_REQ_PENDING || result == vp::IO_REQ_DENIED)
+      {
+        this->trace.msg(vp::trace::LEVEL_TRACE, "Pending piece (req: %p, piece: %p, offset: 0x%llx, size: 0x%llx, denied: %d)\n",
+          req, piece, offset, iter_size, result == vp::IO_REQ_DENIED);
+      }
       else
-        counter->nb_write++;
+      {
+        if (result != vp::IO_REQ_OK)
+        {
+          split->status = result;
+        }
+        this->split_piece_done(split, piece, this->get_cycles());
+      }
 
+      size -= iter_size;
+      offset += iter_size;
+      if (data)
+        data += iter_size;
     }
+  }
+
+  split->pending--;
 
-    size -= iter_size;
-    offset += iter_size;
-    data += iter_size;
+  if (split->pending == 0)
+  {
+    // All pieces were handled synchronously
+    vp::io_req_status_e status = split->status;
+    req->inc_latency(split->end_cycles - split->start_cycles);
+    delete split;
+    return status;
   }
 
-  if (result == vp::IO_REQ_OK)
+  return vp::IO_REQ_PENDING;
+}
+
+void router::split_piece_done(Router_split *split, vp::io_req *piece, int64_t cycles)
+{
+  // The pieces are handled in parallel, the parent is done when the last one is done
+  int64_t end_cycles = cycles + piece->get_full_latency();
+  if (end_cycles > split->end_cycles)
   {
-    req->set_addr(req_offset);
-    req->set_size(req_size);
-    req->set_data(req_data);
+    split->end_cycles = end_cycles;
   }
 
-  return result;
+  split->pending--;
+  this->out.req_del(piece);
+}
+
+void router::split_response(vp::io_req *piece)
+{
+  Router_split *split = (Router_split *)piece->arg_pop();
+  vp::io_req *req = split->parent;
+  int64_t cycles = this->get_cycles();
+
+  this->trace.msg(vp::trace::LEVEL_TRACE, "Received piece response (req: %p, piece: %p, remaining: %d)\n",
+    req, piece, split->pending - 1);
+
+  this->split_piece_done(split, piece, cycles);
+
+  if (split->pending == 0)
+  {
+    // Last piece, send the response for the whole request, with the latency
+    // of the slowest piece relative to the current time
+    req->inc_latency(split->end_cycles - cycles);
+    req->status = split->status;
+    delete split;
+    req->get_resp_port()->resp(req);
+  }
 }
 
 void router::grant(void *__this, vp::io_req *req)
@@ -336,7 +500,8 @@ void router::grant(void *__this, vp::io_req *req)
   router *_this = (router *)__this;
 
   vp::io_slave *port = (vp::io_slave *)req->arg_pop();
-  if (port != NULL)
+  // Pieces of split requests are not granted individually
+  if (port != NULL && (void *)port != _this)
   {
     port->grant(req);
   }
@@ -344,10 +509,14 @@ void router::grant(void *__this, vp::io_req *req)
   req->arg_push(port);
 }
 
-void router::response(void *_this, vp::io_req *req)
+void router::response(void *__this, vp::io_req *req)
 {
+  router *_this = (router *)__this;
+
   vp::io_slave *port = (vp::io_slave *)req->arg_pop();
-  if (port != NULL)
+  if ((void *)port == _this)
+    _this->split_response(req);
+  else if (port != NULL)
     port->resp(req);
 }
 
@@ -472,7 +641,12 @@ int router::build()
         counter->stalls_itf.set_sync_back_meth(&Perf_counter::stalls_sync_back);
         counter->stalls_itf.set_sync_meth(&Perf_counter::stalls_sync);
         new_slave_port((void *)counter, "stalls[" + std::to_string(entry->id) + "]", &counter->stalls_itf);
-      }  
+      }
+
+      if (entry->id != -1)
+      {
+        entry->counter = this->counters[entry->id];
+      }
 
       entry->insert(this);
     }
@@ -488,8 +662,6 @@ extern "C" vp::component *vp_constructor(js::config *config)
 
 
 
-#define max(a, b) ((a) > (b) ? (a) : (b))
-
 void router::init_entries() {
 
   MapEntry *current = firstMapEntry;
@@ -505,52 +677,13 @@ void router::init_entries() {
     trace.msg(vp::trace::LEVEL_INFO, "       -     :      -     -> %s\n", defaultMapEntry->target_name.c_str());
   }
 
-  MapEntry *firstInLevel = firstMapEntry;
-
-  // Loop until we merged everything into a single entry
-  // Start with the routing table entries
+  // The entries are already sorted by base address, just flatten them
   current = firstMapEntry;
-
-  // The first loop is here to loop until we have merged everything to a single entry
-  while(1) {
-
-    // Gives the map entry that should be on the left side of the next created entry
-    MapEntry *left = NULL;
-
-    // Gives the last allocated entry where the entry should be inserted
-    MapEntry *currentInLevel=NULL;
-
-    // The second loop is iterating on a single level to merge entries 2 by 2
-    while(current) {
-      if (left == NULL) left = current;
-      else {
-
-        MapEntry *entry = new MapEntry(current->lowestBase, left, current);
-
-        left = NULL;
-        if (currentInLevel) {
-          currentInLevel->next = entry;
-        } else {
-          firstInLevel = entry;
-        }
-        currentInLevel = entry;
-      }
-
-      current = current->next;
-    }
-
-    current = firstInLevel;
-
-    // Stop in case we got a single entry
-    if (currentInLevel == NULL) break;
-
-    // In case an entry is alone, insert it at the end, it will be merged with an upper entry
-    if (left != NULL) {
-      currentInLevel->next = left;
-    }
+  while(current) {
+    entries.push_back(current);
+    entries_base.push_back(current->base);
+    current = current->next;
   }
-
-  topMapEntry = firstInLevel;
 }
 
 inline void io_master_map::bind_to(vp::port *_port, vp::config *config)
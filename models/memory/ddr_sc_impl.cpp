@@ -111,6 +111,20 @@ vp::io_req_status_e ddr::req(void *__this, vp::io_req *req)
     return vp::IO_REQ_INVALID;
   }
 
+  if (req->is_debug()) {
+    _this->sc_bridge->debug_access(req);
+    return vp::IO_REQ_OK;
+  }
+
+  // With DMI, the access is served without any synchronization with SystemC
+  if (_this->sc_bridge->dmi_access(req)) {
+    return vp::IO_REQ_OK;
+  }
+
+  // Forwarded requests keep the engine synchronized with SystemC until they are
+  // responded by the bridge
+  _this->get_time_engine()->systemc_sync_retain();
+
   if (_this->first_pending_reqs)
     _this->last_pending_reqs->set_next(req);
   else
@@ -146,6 +160,8 @@ int ddr::build()
 void ddr::elab()
 {
   sc_bridge = new gvsoc_tlm_br("sc_br", this, ACCEPT_DELAY_PS, BYTES_PER_ACCESS);
+  sc_bridge->blocking = get_config_bool("tlm/blocking");
+  sc_bridge->dmi_enabled = get_config_bool("tlm/dmi");
   at_bus = new ems::at_bus("at_bus");
   pcib = new tlm_utils::tlm2_base_protocol_checker<>("pcib");
   pcbt = new tlm_utils::tlm2_base_protocol_checker<>("pcbt");
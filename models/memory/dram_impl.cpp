@@ -0,0 +1,558 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <deque>
+
+// Analytical DRAM timing model.
+// Requests are queued by the controller, which picks the next one with a FR-FCFS policy
+// (oldest request hitting an open row first, then oldest request) each time the previous
+// command has been issued. The timing of each request is then computed in one step from
+// the state of its bank (open row, activation time, write recovery), the data bus
+// turnaround and the refresh periods, instead of simulating each DRAM command.
+// All timings are in cycles of the component clock.
+
+class Dram_bank
+{
+public:
+  int64_t open_row;       // Row in the row buffer, -1 if the bank is precharged
+  int64_t ready;          // Cycle where the bank can accept the next command
+  int64_t activated;      // Cycle where the open row was activated, for tRAS
+  int64_t write_end;      // Cycle where the last write data was received, for tWR
+};
+
+class Dram_entry
+{
+public:
+  vp::io_req *req;
+  int bank;
+  int64_t row;
+  int64_t end_cycles;
+};
+
+class dram : public vp::component
+{
+
+public:
+
+  dram(js::config *config);
+
+  int build();
+  void start();
+  void stop();
+  void reset(bool active);
+
+  static vp::io_req_status_e req(void *__this, vp::io_req *req);
+
+private:
+
+  static void sched_handler(void *__this, vp::clock_event *event);
+  static void resp_handler(void *__this, vp::clock_event *event);
+
+  inline uint8_t *get_page(uint64_t index);
+  vp::io_req_status_e access(vp::io_req *req);
+  void refresh(int64_t cycles);
+  void schedule(Dram_entry &entry, int64_t cycles);
+  void check_state();
+
+  vp::trace     trace;
+  vp::io_slave in;
+
+  uint64_t size;
+
+  // Address mapping, row:bank:column
+  int nb_banks;
+  uint64_t row_size;
+  // Bytes transferred per cycle on the data bus
+  int width;
+  int queue_size;
+  // Precharge the row after each access instead of keeping it open
+  bool close_page;
+  int latency;
+
+  int t_rcd;
+  int t_rp;
+  int t_cl;
+  int t_cwl;
+  int t_ras;
+  int t_wr;
+  int t_wtr;
+  int t_rtw;
+  int t_rfc;
+  int t_refi;
+
+  // Data storage, allocated by pages when first accessed since DRAMs are usually big
+  // and only partially used
+  int page_bits;
+  uint8_t **pages;
+
+  std::vector<Dram_bank> banks;
+  // Requests waiting to be scheduled, in arrival order
+  std::vector<Dram_entry> queue;
+  // Requests which have been scheduled, in completion order since the data bus is shared
+  std::deque<Dram_entry> inflight;
+  // Requests denied because the queue was full
+  std::deque<vp::io_req *> stalled;
+
+  int64_t bus_free;
+  bool bus_is_write;
+  int64_t next_refresh;
+  int64_t next_sched;
+
+  vp::clock_event *sched_event;
+  vp::clock_event *resp_event;
+
+  // Statistics
+  int64_t nb_reqs;
+  int64_t nb_row_hits;
+  int64_t nb_row_misses;
+  int64_t nb_row_conflicts;
+  int64_t nb_refreshes;
+  int64_t nb_bytes;
+  int64_t busy_cycles;
+  int64_t total_latency;
+};
+
+dram::dram(js::config *config)
+: vp::component(config)
+{
+
+}
+
+inline uint8_t *dram::get_page(uint64_t index)
+{
+  uint8_t *page = this->pages[index];
+  if (page == NULL)
+  {
+    uint64_t page_size = 1ULL << this->page_bits;
+    page = new uint8_t[page_size];
+    memset(page, 0x57, page_size);
+    this->pages[index] = page;
+  }
+  return page;
+}
+
+vp::io_req_status_e dram::access(vp::io_req *req)
+{
+  uint64_t page_mask = (1ULL << this->page_bits) - 1;
+  uint8_t *data = req->get_data();
+  int nb_chunks = req->get_nb_chunks();
+
+  for (int i=0; i<nb_chunks; i++)
+  {
+    uint64_t offset, size;
+    req->get_chunk(i, &offset, &size);
+
+    if (offset + size > this->size)
+    {
+      this->trace.force_warning("Received out-of-bound request (reqAddr: 0x%lx, reqSize: 0x%lx, memSize: 0x%lx)\n", offset, size, this->size);
+      return vp::IO_REQ_INVALID;
+    }
+
+    while (data && size)
+    {
+      uint64_t page_offset = offset & page_mask;
+      uint64_t iter_size = page_mask + 1 - page_offset;
+      if (iter_size > size)
+        iter_size = size;
+
+      uint8_t *page = this->get_page(offset >> this->page_bits);
+
+      if (req->get_is_write())
+        memcpy(&page[page_offset], data, iter_size);
+      else
+        memcpy(data, &page[page_offset], iter_size);
+
+      offset += iter_size;
+      data += iter_size;
+      size -= iter_size;
+    }
+  }
+
+  return vp::IO_REQ_OK;
+}
+
+vp::io_req_status_e dram::req(void *__this, vp::io_req *req)
+{
+  dram *_this = (dram *)__this;
+  uint64_t offset = req->get_addr();
+
+  _this->trace.msg(vp::trace::LEVEL_TRACE, "Received request (req: %p, offset: 0x%lx, size: 0x%lx, is_write: %d)\n",
+    req, offset, req->get_size(), req->get_is_write());
+
+  // The data is accessed right away, only the timing goes through the controller
+  vp::io_req_status_e err = _this->access(req);
+  if (err != vp::IO_REQ_OK || req->is_debug())
+  {
+    return err;
+  }
+
+  if ((int)_this->queue.size() >= _this->queue_size)
+  {
+    _this->trace.msg(vp::trace::LEVEL_TRACE, "Queue is full, denying request (req: %p)\n", req);
+    _this->stalled.push_back(req);
+    return vp::IO_REQ_DENIED;
+  }
+
+  Dram_entry entry;
+  entry.req = req;
+  entry.bank = (offset / _this->row_size) % _this->nb_banks;
+  entry.row = offset / (_this->row_size * _this->nb_banks);
+  _this->queue.push_back(entry);
+
+  req->arg_push((void *)(long)_this->get_cycles());
+
+  _this->check_state();
+
+  return vp::IO_REQ_PENDING;
+}
+
+void dram::refresh(int64_t cycles)
+{
+  if (this->t_refi == 0 || cycles < this->next_refresh)
+    return;
+
+  // Only the last missed refresh can still delay the next commands
+  int64_t nb_missed = (cycles - this->next_refresh) / this->t_refi;
+  this->next_refresh += nb_missed * this->t_refi;
+  this->nb_refreshes += nb_missed + 1;
+
+  // All banks are precharged and then unavailable during the refresh
+  int64_t start = this->next_refresh;
+  for (Dram_bank &bank: this->banks)
+  {
+    int64_t bank_start = bank.ready;
+    if (bank.open_row != -1)
+    {
+      if (bank.activated + this->t_ras > bank_start)
+        bank_start = bank.activated + this->t_ras;
+      if (bank.write_end + this->t_wr > bank_start)
+        bank_start = bank.write_end + this->t_wr;
+    }
+    if (bank_start > start)
+      start = bank_start;
+  }
+
+  int64_t end = start + this->t_rp + this->t_rfc;
+  for (Dram_bank &bank: this->banks)
+  {
+    bank.open_row = -1;
+    bank.ready = end;
+  }
+
+  this->trace.msg(vp::trace::LEVEL_TRACE, "Refresh (start: %ld, end: %ld)\n", start, end);
+
+  this->next_refresh += this->t_refi;
+}
+
+void dram::schedule(Dram_entry &entry, int64_t cycles)
+{
+  vp::io_req *req = entry.req;
+  Dram_bank &bank = this->banks[entry.bank];
+  bool is_write = req->get_is_write();
+  uint64_t size = req->get_burst_size();
+  int64_t burst_cycles = (size + this->width - 1) / this->width;
+  if (burst_cycles == 0)
+    burst_cycles = 1;
+
+  int64_t start = cycles > bank.ready ? cycles : bank.ready;
+  int64_t cmd;
+
+  if (bank.open_row == entry.row)
+  {
+    this->nb_row_hits++;
+    cmd = start;
+  }
+  else
+  {
+    int64_t activate = start;
+
+    if (bank.open_row == -1)
+    {
+      this->nb_row_misses++;
+    }
+    else
+    {
+      // The open row must be closed first, which is only possible once it has been
+      // open long enough and the last write has been recovered
+      this->nb_row_conflicts++;
+      int64_t precharge = start;
+      if (bank.activated + this->t_ras > precharge)
+        precharge = bank.activated + this->t_ras;
+      if (bank.write_end + this->t_wr > precharge)
+        precharge = bank.write_end + this->t_wr;
+      activate = precharge + this->t_rp;
+    }
+
+    bank.open_row = entry.row;
+    bank.activated = activate;
+    cmd = activate + this->t_rcd;
+  }
+
+  // Read/write turnaround on the shared data bus
+  if (is_write != this->bus_is_write)
+  {
+    int64_t turnaround = this->bus_free + (this->bus_is_write ? this->t_wtr : this->t_rtw);
+    if (turnaround > cmd)
+      cmd = turnaround;
+  }
+
+  int64_t data_start = cmd + (is_write ? this->t_cwl : this->t_cl);
+  if (data_start < this->bus_free)
+    data_start = this->bus_free;
+
+  int64_t data_end = data_start + burst_cycles;
+
+  this->bus_free = data_end;
+  this->bus_is_write = is_write;
+  this->busy_cycles += burst_cycles;
+  this->nb_bytes += size;
+  this->nb_reqs++;
+
+  // Column commands to the same row can be pipelined, one per burst
+  bank.ready = cmd + burst_cycles;
+  if (is_write)
+    bank.write_end = data_end;
+
+  if (this->close_page)
+  {
+    int64_t precharge = bank.ready;
+    if (bank.activated + this->t_ras > precharge)
+      precharge = bank.activated + this->t_ras;
+    if (is_write && data_end + this->t_wr > precharge)
+      precharge = data_end + this->t_wr;
+    bank.open_row = -1;
+    bank.ready = precharge + this->t_rp;
+  }
+
+  entry.end_cycles = data_end + this->latency;
+
+  this->trace.msg(vp::trace::LEVEL_TRACE, "Scheduled request (req: %p, bank: %d, row: %ld, cmd: %ld, end: %ld)\n",
+    req, entry.bank, entry.row, cmd, entry.end_cycles);
+
+  // The next request can be chosen once this command has been issued
+  this->next_sched = cmd > cycles ? cmd : cycles + 1;
+
+  this->inflight.push_back(entry);
+}
+
+void dram::check_state()
+{
+  int64_t cycles = this->get_cycles();
+
+  if (!this->queue.empty() && !this->sched_event->is_enqueued())
+  {
+    int64_t delay = this->next_sched > cycles ? this->next_sched - cycles : 0;
+    this->event_enqueue(this->sched_event, delay > 0 ? delay : 1);
+  }
+
+  if (!this->inflight.empty() && !this->resp_event->is_enqueued())
+  {
+    int64_t end = this->inflight.front().end_cycles;
+    this->event_enqueue(this->resp_event, end > cycles ? end - cycles : 1);
+  }
+}
+
+void dram::sched_handler(void *__this, vp::clock_event *event)
+{
+  dram *_this = (dram *)__this;
+  int64_t cycles = _this->get_cycles();
+
+  if (_this->queue.empty())
+    return;
+
+  if (cycles < _this->next_sched)
+  {
+    _this->check_state();
+    return;
+  }
+
+  _this->refresh(cycles);
+
+  // FR-FCFS, oldest request hitting an open row, or oldest request
+  int elected = 0;
+  for (int i=0; i<(int)_this->queue.size(); i++)
+  {
+    Dram_entry &entry = _this->queue[i];
+    if (_this->banks[entry.bank].open_row == entry.row)
+    {
+      elected = i;
+      break;
+    }
+  }
+
+  Dram_entry entry = _this->queue[elected];
+  _this->queue.erase(_this->queue.begin() + elected);
+  _this->schedule(entry, cycles);
+
+  // A slot is now free in the queue
+  if (!_this->stalled.empty())
+  {
+    vp::io_req *req = _this->stalled.front();
+    _this->stalled.pop_front();
+
+    Dram_entry entry;
+    entry.req = req;
+    entry.bank = (req->get_addr() / _this->row_size) % _this->nb_banks;
+    entry.row = req->get_addr() / (_this->row_size * _this->nb_banks);
+    _this->queue.push_back(entry);
+
+    req->arg_push((void *)(long)cycles);
+    req->get_resp_port()->grant(req);
+  }
+
+  _this->check_state();
+}
+
+void dram::resp_handler(void *__this, vp::clock_event *event)
+{
+  dram *_this = (dram *)__this;
+  int64_t cycles = _this->get_cycles();
+
+  while (!_this->inflight.empty() && _this->inflight.front().end_cycles <= cycles)
+  {
+    vp::io_req *req = _this->inflight.front().req;
+    _this->inflight.pop_front();
+
+    int64_t start_cycles = (long)req->arg_pop();
+    _this->total_latency += cycles - start_cycles;
+
+    _this->trace.msg(vp::trace::LEVEL_TRACE, "Replying to request (req: %p, latency: %ld)\n", req, cycles - start_cycles);
+
+    req->status = vp::IO_REQ_OK;
+    req->get_resp_port()->resp(req);
+  }
+
+  _this->check_state();
+}
+
+int dram::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  in.set_req_meth(&dram::req);
+  new_slave_port("input", &in);
+
+  js::config *config = this->get_js_config();
+
+  // get_child_int returns an int, which would truncate DRAMs of 2GiB or more
+  this->size = config->get_int("size");
+  this->nb_banks = config->get_child_int("nb_banks");
+  this->row_size = config->get_child_int("row_size");
+  this->width = config->get_child_int("width");
+  this->queue_size = config->get_child_int("queue_size");
+  this->close_page = config->get_child_bool("close_page");
+  this->latency = config->get_child_int("latency");
+
+  this->t_rcd = config->get_child_int("t_rcd");
+  this->t_rp = config->get_child_int("t_rp");
+  this->t_cl = config->get_child_int("t_cl");
+  this->t_cwl = config->get_child_int("t_cwl");
+  this->t_ras = config->get_child_int("t_ras");
+  this->t_wr = config->get_child_int("t_wr");
+  this->t_wtr = config->get_child_int("t_wtr");
+  this->t_rtw = config->get_child_int("t_rtw");
+  this->t_rfc = config->get_child_int("t_rfc");
+  this->t_refi = config->get_child_int("t_refi");
+
+  if (this->nb_banks <= 0 || this->row_size == 0 || this->width <= 0 || this->queue_size <= 0)
+  {
+    this->trace.fatal("Invalid DRAM geometry (nb_banks: %d, row_size: %ld, width: %d, queue_size: %d)\n",
+      this->nb_banks, this->row_size, this->width, this->queue_size);
+    return -1;
+  }
+
+  this->page_bits = 16;
+  this->pages = new uint8_t *[(this->size + (1ULL << this->page_bits) - 1) >> this->page_bits]();
+
+  this->banks.resize(this->nb_banks);
+
+  this->sched_event = this->event_new(dram::sched_handler);
+  this->resp_event = this->event_new(dram::resp_handler);
+
+  this->nb_reqs = 0;
+  this->nb_row_hits = 0;
+  this->nb_row_misses = 0;
+  this->nb_row_conflicts = 0;
+  this->nb_refreshes = 0;
+  this->nb_bytes = 0;
+  this->busy_cycles = 0;
+  this->total_latency = 0;
+
+  return 0;
+}
+
+void dram::start()
+{
+  this->trace.msg(vp::trace::LEVEL_INFO, "Instantiating DRAM (size: 0x%lx, nb_banks: %d, row_size: 0x%lx, width: %d, queue_size: %d)\n",
+    this->size, this->nb_banks, this->row_size, this->width, this->queue_size);
+}
+
+void dram::reset(bool active)
+{
+  if (active)
+  {
+    for (Dram_bank &bank: this->banks)
+    {
+      bank.open_row = -1;
+      bank.ready = 0;
+      bank.activated = 0;
+      bank.write_end = 0;
+    }
+
+    this->queue.clear();
+    this->inflight.clear();
+    this->stalled.clear();
+    this->bus_free = 0;
+    this->bus_is_write = false;
+    this->next_refresh = this->t_refi;
+    this->next_sched = 0;
+  }
+}
+
+void dram::stop()
+{
+  int64_t cycles = this->get_cycles();
+
+  if (this->nb_reqs == 0)
+    return;
+
+  this->trace.msg(vp::trace::LEVEL_INFO, "DRAM statistics (requests: %ld, row hits: %ld, row misses: %ld, row conflicts: %ld, refreshes: %ld, row hit rate: %f, average latency: %f)\n",
+    this->nb_reqs, this->nb_row_hits, this->nb_row_misses, this->nb_row_conflicts, this->nb_refreshes,
+    (float)this->nb_row_hits / this->nb_reqs, (float)this->total_latency / this->nb_reqs);
+
+  if (cycles > 0)
+  {
+    // Bandwidth in bytes per cycle, and in MB/s from the clock period in ps
+    this->trace.msg(vp::trace::LEVEL_INFO, "DRAM bandwidth (bytes: %ld, bytes per cycle: %f, MB/s: %f, bus utilization: %f)\n",
+      this->nb_bytes, (float)this->nb_bytes / cycles, (double)this->nb_bytes * 1e6 / ((double)cycles * this->get_period()),
+      (float)this->busy_cycles / cycles);
+  }
+}
+
+extern "C" vp::component *vp_constructor(js::config *config)
+{
+  return new dram(config);
+}
@@ -50,7 +50,10 @@ public:
   {
     tsocket.register_nb_transport_fw(this, &at_bus::nb_transport_fw);
     tsocket.register_transport_dbg(this, &at_bus::transport_dbg);
+    tsocket.register_b_transport(this, &at_bus::b_transport);
+    tsocket.register_get_direct_mem_ptr(this, &at_bus::get_direct_mem_ptr);
     isocket.register_nb_transport_bw(this, &at_bus::nb_transport_bw);
+    isocket.register_invalidate_direct_mem_ptr(this, &at_bus::invalidate_direct_mem_ptr);
   }
 
   void end_of_elaboration()
@@ -72,8 +75,12 @@ public:
   // Module interface - forward path
   tlm::tlm_sync_enum nb_transport_fw(int id, tlm::tlm_generic_payload &p, tlm::tlm_phase &phase, sc_core::sc_time &d);
   unsigned int transport_dbg(int id, tlm::tlm_generic_payload &p);
+  // Blocking transport and DMI requests are simply forwarded to the decoded target
+  void b_transport(int id, tlm::tlm_generic_payload &p, sc_core::sc_time &d);
+  bool get_direct_mem_ptr(int id, tlm::tlm_generic_payload &p, tlm::tlm_dmi &dmi);
   // Module interface - backward path
   tlm::tlm_sync_enum nb_transport_bw(int id, tlm::tlm_generic_payload &p, tlm::tlm_phase &phase, sc_core::sc_time &d);
+  void invalidate_direct_mem_ptr(int id, sc_dt::uint64 start, sc_dt::uint64 end);
 
 private:
   // Total transactions counter
@@ -448,6 +455,33 @@ unsigned int at_bus::transport_dbg(int id, tlm::tlm_generic_payload &p)
   return isocket[dsock]->transport_dbg(p);
 }
 
+void at_bus::b_transport(int id, tlm::tlm_generic_payload &p, sc_core::sc_time &d)
+{
+  sc_dt::uint64 masked_address;
+  int dsock = decode_address(p.get_address(), masked_address);
+  assert(dsock < isocket.size());
+  p.set_address(masked_address);
+  isocket[dsock]->b_transport(p, d);
+}
+
+bool at_bus::get_direct_mem_ptr(int id, tlm::tlm_generic_payload &p, tlm::tlm_dmi &dmi)
+{
+  sc_dt::uint64 masked_address;
+  int dsock = decode_address(p.get_address(), masked_address);
+  assert(dsock < isocket.size());
+  p.set_address(masked_address);
+  // The address decoder does not translate addresses, so the DMI region can be
+  // returned as is
+  return isocket[dsock]->get_direct_mem_ptr(p, dmi);
+}
+
+void at_bus::invalidate_direct_mem_ptr(int id, sc_dt::uint64 start, sc_dt::uint64 end)
+{
+  for (auto i = 0; i < tsocket.size(); ++i) {
+    tsocket[i]->invalidate_direct_mem_ptr(start, end);
+  }
+}
+
 } // namespace ems
 
 #endif /* __EMS_AT_BUS_H__ */
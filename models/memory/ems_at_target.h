@@ -56,6 +56,7 @@ public:
     internal_latency = sc_core::sc_time(internal_latency_ps, SC_PS);
     tsocket.register_nb_transport_fw(this, &at_target::nb_transport_fw);
     tsocket.register_transport_dbg(this, &at_target::transport_dbg);
+    tsocket.register_get_direct_mem_ptr(this, &at_target::get_direct_mem_ptr);
 
 #ifdef EMS_TARGET_USE_CALLOC
     mem = reinterpret_cast<unsigned char*>(calloc(MEM_SIZE, sizeof(char)));
@@ -90,6 +91,7 @@ public:
   // Module interface
   tlm::tlm_sync_enum nb_transport_fw(tlm::tlm_generic_payload &p, tlm::tlm_phase &phase, sc_core::sc_time &delay);
   unsigned int transport_dbg(tlm::tlm_generic_payload &p);
+  bool get_direct_mem_ptr(tlm::tlm_generic_payload &p, tlm::tlm_dmi &dmi);
 
 private:
   unsigned int execute(tlm::tlm_generic_payload *p);
@@ -161,11 +163,11 @@ unsigned int at_target::execute(tlm::tlm_generic_payload *p)
 
   switch (cmd) {
     case tlm::TLM_READ_COMMAND:
-      memcpy(dptr, mem, dlen);
+      memcpy(dptr, &mem[addr], dlen);
       //debug(name() << " READ addr: 0x" << std::setfill('0') << std::setw(16) << std::hex << addr << std::dec << " dlen: " << dlen);
       break;
     case tlm::TLM_WRITE_COMMAND:
-      memcpy(mem, dptr, dlen);
+      memcpy(&mem[addr], dptr, dlen);
       //debug(name() << " WRITE addr: 0x" << std::setfill('0') << std::setw(16) << std::hex << addr << std::dec << " dlen: " << dlen);
       break;
     default:
@@ -297,6 +299,21 @@ unsigned int at_target::transport_dbg(tlm::tlm_generic_payload &p)
   return execute(&p);
 }
 
+// The whole memory is granted, with the latency of one access of bytes_per_access bytes
+bool at_target::get_direct_mem_ptr(tlm::tlm_generic_payload &p, tlm::tlm_dmi &dmi)
+{
+  if (!mem)
+    return false;
+
+  dmi.allow_read_write();
+  dmi.set_dmi_ptr(mem);
+  dmi.set_start_address(0);
+  dmi.set_end_address(sc_dt::uint64(MEM_SIZE) - 1);
+  dmi.set_read_latency(accept_delay + internal_latency);
+  dmi.set_write_latency(accept_delay + internal_latency);
+  return true;
+}
+
 } // namespace ems
 
 #endif /* __EMS_TARGET_H__ */
@@ -25,6 +25,7 @@
 #include <tlm.h>
 #include <tlm_utils/peq_with_cb_and_phase.h>
 #include <tlm_utils/simple_initiator_socket.h>
+#include <vector>
 
 #include "ems_common.h"
 
@@ -48,15 +49,32 @@ public:
   {
     resp_accept_delay = sc_core::sc_time(accept_delay_ps, SC_PS);
     isocket.register_nb_transport_bw(this, &gvsoc_tlm_br::nb_transport_bw);
+    isocket.register_invalidate_direct_mem_ptr(this, &gvsoc_tlm_br::invalidate_direct_mem_ptr);
     SC_THREAD(run);
   }
 
   // Module interface - backward path only
   tlm::tlm_sync_enum nb_transport_bw(tlm::tlm_generic_payload &p, tlm::tlm_phase &phase, sc_core::sc_time &d);
+  void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end);
+
+  // Serve the request synchronously through the DMI pointer granted by the target,
+  // returns false if the request is not covered by a valid DMI region
+  bool dmi_access(vp::io_req *req);
+  // Serve a debug request through the debug transport interface
+  void debug_access(vp::io_req *req);
+
+  // Use the blocking transport interface, see run_blocking
+  bool blocking = false;
+  // Request a DMI pointer from the target when the bridge starts
+  bool dmi_enabled = false;
 
 private:
   // Thread process member function
   void run();
+  void run_blocking();
+  void dmi_init();
+  // Respond to a request once all its transactions are completed
+  void complete(vp::io_req *req);
   // Conversion vp::io_req to tlm::tlm_generic_payload
   void req_to_gp(vp::io_req *r, tlm::tlm_generic_payload *p, uint32_t tid, bool last);
   // Called at the end of the lifetime of a transaction to inspect it
@@ -74,6 +92,8 @@ private:
   ems::mm mm;
   sc_core::sc_time resp_accept_delay;
   uint32_t bytes_per_access;
+  tlm::tlm_dmi dmi;
+  bool dmi_valid = false;
 };
 
 void gvsoc_tlm_br::req_to_gp(vp::io_req *r, tlm::tlm_generic_payload *p, uint32_t tid, bool last)
@@ -177,6 +197,115 @@ tlm::tlm_sync_enum gvsoc_tlm_br::nb_transport_bw(tlm::tlm_generic_payload &p, tl
   return tlm::TLM_ACCEPTED;
 }
 
+void gvsoc_tlm_br::invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end)
+{
+  if (dmi_valid && start <= dmi.get_end_address() && end >= dmi.get_start_address()) {
+    dmi_valid = false;
+  }
+}
+
+void gvsoc_tlm_br::dmi_init()
+{
+  tlm::tlm_generic_payload p;
+  p.set_command(tlm::TLM_READ_COMMAND);
+  p.set_address(0);
+  dmi_valid = isocket->get_direct_mem_ptr(p, dmi);
+  debug(name() << " DMI " << (dmi_valid ? "granted" : "refused"));
+}
+
+bool gvsoc_tlm_br::dmi_access(vp::io_req *req)
+{
+  uint64_t addr = req->get_addr();
+  uint64_t size = req->get_size();
+  bool is_write = req->get_is_write();
+
+  if (!dmi_valid || addr < dmi.get_start_address() || addr + size - 1 > dmi.get_end_address() ||
+      (is_write && !dmi.is_write_allowed()) || (!is_write && !dmi.is_read_allowed())) {
+    return false;
+  }
+
+  unsigned char *ptr = dmi.get_dmi_ptr() + (addr - dmi.get_start_address());
+  if (is_write) {
+    memcpy(ptr, req->get_data(), size);
+  } else {
+    memcpy(req->get_data(), ptr, size);
+  }
+
+  // DMI latencies are given for one access of bytes_per_access bytes
+  uint64_t n_trans = (size + bytes_per_access - 1) / bytes_per_access;
+  sc_core::sc_time latency = (is_write ? dmi.get_write_latency() : dmi.get_read_latency()) * double(n_trans);
+  if (vp_component->get_clock()) {
+    req->inc_latency((int64_t)(latency.to_seconds() * 1e12) / vp_component->get_period());
+  }
+
+  return true;
+}
+
+void gvsoc_tlm_br::debug_access(vp::io_req *req)
+{
+  tlm::tlm_generic_payload p;
+  p.set_command(req->get_is_write() ? tlm::TLM_WRITE_COMMAND : tlm::TLM_READ_COMMAND);
+  p.set_address(req->get_addr());
+  p.set_data_ptr(req->get_data());
+  p.set_data_length(req->get_size());
+  p.set_streaming_width(req->get_size());
+  isocket->transport_dbg(p);
+}
+
+void gvsoc_tlm_br::complete(vp::io_req *req)
+{
+  vp_component->current_reqs--;
+
+  req->get_resp_port()->resp(req);
+
+  if (vp_component->current_reqs >= vp_component->max_reqs) {
+    vp::io_req *stalled_req = vp_component->first_stalled_req;
+    vp_component->first_stalled_req = vp_component->first_stalled_req->get_next();
+    stalled_req->get_resp_port()->grant(stalled_req);
+  }
+
+  // The engine can run ahead of SystemC again once no request is in flight
+  vp_component->get_time_engine()->systemc_sync_release();
+}
+
+// Loosely-timed mode. All pending requests are sent back-to-back using the blocking
+// transport interface, accumulating the annotated delays as a local time offset,
+// and the bridge synchronizes with SystemC only once for the whole batch. All the
+// requests of the batch are then responded at the end of the batch.
+void gvsoc_tlm_br::run_blocking()
+{
+  sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+  std::vector<vp::io_req *> batch;
+
+  while (vp_component->first_pending_reqs) {
+    vp::io_req *req = vp_component->first_pending_reqs;
+    vp_component->first_pending_reqs = req->get_next();
+
+    uint32_t nt = req->get_size() / bytes_per_access;
+    uint32_t n_trans = nt > 0 ? nt : 1;
+
+    for (auto t = 0; t < n_trans; t++) {
+      tlm::tlm_generic_payload *p = mm.palloc();
+      p->acquire();
+      req_to_gp(req, p, t, t == (n_trans - 1));
+      isocket->b_transport(*p, delay);
+      if (p->is_response_error()) {
+        debug(name() << " Request p: " << p << " response error" << p->get_response_string());
+        SC_REPORT_ERROR(name(), p->get_response_string().c_str());
+      }
+      p->release();
+    }
+
+    batch.push_back(req);
+  }
+
+  wait(delay);
+
+  for (vp::io_req *req : batch) {
+    complete(req);
+  }
+}
+
 void gvsoc_tlm_br::run()
 {
   tlm::tlm_generic_payload *p;
@@ -184,11 +313,27 @@ void gvsoc_tlm_br::run()
   sc_core::sc_time delay;
   tlm::tlm_sync_enum status;
 
+  if (dmi_enabled) {
+    dmi_init();
+  }
+
   while (1) {
     while (vp_component->current_reqs == 0) {
       wait(event);
     }
 
+    // GVSoC may have run ahead of SystemC within the synchronization quantum, the
+    // requests are sent at the GVSoC time they were received
+    int64_t lag = vp_component->get_time() - (int64_t)sc_time_stamp().to_double();
+    if (lag > 0) {
+      wait(lag, SC_PS);
+    }
+
+    if (blocking) {
+      run_blocking();
+      continue;
+    }
+
     vp::io_req *req = vp_component->first_pending_reqs;
     vp_component->first_pending_reqs = vp_component->first_pending_reqs->get_next();
 
@@ -241,15 +386,7 @@ void gvsoc_tlm_br::run()
 
     wait(all_trans_completed);
 
-    vp_component->current_reqs--;
-
-    req->get_resp_port()->resp(req);
-
-    if (vp_component->current_reqs >= vp_component->max_reqs) {
-      vp::io_req *stalled_req = vp_component->first_stalled_req;
-      vp_component->first_stalled_req = vp_component->first_stalled_req->get_next();
-      stalled_req->get_resp_port()->grant(stalled_req);
-    }
+    complete(req);
   }
 }
 
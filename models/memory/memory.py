@@ -28,10 +28,28 @@ class Memory(st.Component):
         The path to a binary file which should be preloaded at beginning of the memory.
     power_trigger: bool
         True if the memory should trigger power report generation based on dedicated accesses
+    sparse: bool
+        True if the memory should be allocated by pages when they are first accessed, instead of
+        allocating it entirely at startup. This is useful for big memories which are only partially
+        used, but the memory cannot be directly accessed through the meminfo interface.
+    page_size: int
+        Size in bytes of the pages in sparse mode. Must be a power of 2.
+    mmap_stim_file: bool
+        True if the stimuli file should be mapped copy-on-write instead of being read. The pages
+        which are not written are then shared between all the simulations using the same file.
+    writeback: bool
+        True if the stimuli file should be mapped so that the memory writes are propagated to it.
+    check: bool
+        True if reads of bytes which have never been written should be reported and make the access fail.
+    check_ranges: list
+        List of [base, size] offset ranges where uninitialized accesses are checked when check is
+        True. The whole memory is checked if the list is empty.
     
     """
 
-    def __init__(self, parent, name, size: int, stim_file: str=None, power_trigger: bool=False, align:int=0):
+    def __init__(self, parent, name, size: int, stim_file: str=None, power_trigger: bool=False, align:int=0,
+            sparse: bool=False, page_size: int=0x10000, mmap_stim_file: bool=False,
+            writeback: bool=False, check: bool=False, check_ranges: list=None):
 
         super(Memory, self).__init__(parent, name)
 
@@ -42,5 +60,89 @@ class Memory(st.Component):
             'stim_file': stim_file,
             'power_trigger': power_trigger,
             'width_bits': 2,
-            'align': align
-        })
\ No newline at end of file
+            'align': align,
+            'sparse': sparse,
+            'page_size': page_size,
+            'mmap_stim_file': mmap_stim_file,
+            'writeback': writeback,
+            'check': check,
+            'check_ranges': check_ranges if check_ranges is not None else []
+        })
+
+class Dram(st.Component):
+    """
+    DRAM timing model
+
+    Native DRAM controller and device model, with banks, row buffers, refresh and read/write
+    turnaround, and FR-FCFS scheduling over a request queue. All timings are in cycles of the
+    component clock.
+    The default timings are taken from a preset, and can be overridden one by one through the
+    keyword arguments (e.g. t_cl=14).
+
+    Attributes
+    ----------
+    size : int
+        The size of the memory.
+    preset : str
+        Default geometry and timings, can be 'ddr3', 'lpddr4' or 'hyperram'.
+    nb_banks : int
+        Number of banks. Addresses are mapped as row:bank:column.
+    row_size : int
+        Size in bytes of a row.
+    width : int
+        Number of bytes transferred per cycle on the data bus.
+    queue_size : int
+        Number of requests the controller can hold. Requests are denied when it is full.
+    close_page : bool
+        True if rows should be precharged after each access instead of being kept open.
+    latency : int
+        Fixed latency added by the controller to each request.
+    t_rcd, t_rp, t_cl, t_cwl, t_ras, t_wr, t_wtr, t_rtw, t_rfc, t_refi : int
+        Activate to read/write, precharge, read latency, write latency, activate to precharge,
+        write recovery, write to read, read to write, refresh duration and refresh interval.
+        Refresh is disabled if t_refi is 0.
+    """
+
+    presets = {
+        'ddr3': {
+            'nb_banks': 8, 'row_size': 8192, 'width': 16, 'close_page': False,
+            't_rcd': 11, 't_rp': 11, 't_cl': 11, 't_cwl': 8, 't_ras': 28, 't_wr': 12,
+            't_wtr': 6, 't_rtw': 2, 't_rfc': 208, 't_refi': 6240
+        },
+        'lpddr4': {
+            'nb_banks': 8, 'row_size': 2048, 'width': 8, 'close_page': False,
+            't_rcd': 29, 't_rp': 34, 't_cl': 28, 't_cwl': 14, 't_ras': 68, 't_wr': 29,
+            't_wtr': 16, 't_rtw': 8, 't_rfc': 448, 't_refi': 6246
+        },
+        'hyperram': {
+            'nb_banks': 1, 'row_size': 1024, 'width': 2, 'close_page': True,
+            't_rcd': 12, 't_rp': 4, 't_cl': 0, 't_cwl': 0, 't_ras': 0, 't_wr': 0,
+            't_wtr': 0, 't_rtw': 0, 't_rfc': 0, 't_refi': 0
+        }
+    }
+
+    def __init__(self, parent, name, size: int, preset: str='ddr3', queue_size: int=16, latency: int=0,
+            **timings):
+
+        super(Dram, self).__init__(parent, name)
+
+        self.set_component('memory.dram_impl')
+
+        if preset not in Dram.presets:
+            raise RuntimeError('Unknown DRAM preset: ' + preset)
+
+        config = Dram.presets[preset].copy()
+
+        for key in timings.keys():
+            if key not in config:
+                raise RuntimeError('Unknown DRAM parameter: ' + key)
+
+        config.update(timings)
+
+        config.update({
+            'size': size,
+            'queue_size': queue_size,
+            'latency': latency
+        })
+
+        self.add_properties(config)
@@ -22,8 +22,21 @@
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
 #include <vp/itf/wire.hpp>
+#include <vp/mem_file.hpp>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
+#include <math.h>
+
+// Address range where uninitialized accesses are checked, with one bit per byte telling
+// if the byte has been written
+class Memory_check_range
+{
+public:
+  uint64_t base;
+  uint64_t size;
+  uint64_t *bitmap;
+};
 
 class memory : public vp::component
 {
@@ -44,6 +57,14 @@ private:
   static void meminfo_sync_back(void *__this, void **value);
   static void meminfo_sync(void *__this, void *value);
 
+  vp::io_req_status_e access(uint64_t offset, uint64_t size, uint8_t *data, bool is_write);
+  inline uint8_t *get_page(uint64_t index);
+  void sparse_access(uint64_t offset, uint64_t size, uint8_t *data, bool is_write);
+
+  void check_add_range(uint64_t base, uint64_t size);
+  void check_set(Memory_check_range *range, uint64_t offset, uint64_t size);
+  int64_t check_get_uninit(Memory_check_range *range, uint64_t offset, uint64_t size);
+
   vp::trace     trace;
   vp::io_slave in;
 
@@ -52,7 +73,13 @@ private:
   int width_bits = 0;
 
   uint8_t *mem_data;
-  uint8_t *check_mem;
+  std::vector<Memory_check_range> check_ranges;
+
+  // In sparse mode, the memory is allocated by pages when they are first accessed,
+  // instead of allocating and initializing the whole memory at startup
+  bool sparse = false;
+  int page_bits;
+  uint8_t **pages = NULL;
 
   int64_t next_packet_start;
 
@@ -80,6 +107,108 @@ memory::memory(js::config *config)
 
 }
 
+inline uint8_t *memory::get_page(uint64_t index)
+{
+  uint8_t *page = this->pages[index];
+  if (page == NULL)
+  {
+    uint64_t page_size = 1ULL << this->page_bits;
+
+    this->trace.msg(vp::trace::LEVEL_DEBUG, "Allocating page (offset: 0x%lx, size: 0x%lx)\n", index << this->page_bits, page_size);
+
+    page = new uint8_t[page_size];
+    // Initialize the page with the same value as the dense memory to detect
+    // uninitialized variables
+    memset(page, 0x57, page_size);
+    this->pages[index] = page;
+  }
+  return page;
+}
+
+void memory::sparse_access(uint64_t offset, uint64_t size, uint8_t *data, bool is_write)
+{
+  uint64_t page_mask = (1ULL << this->page_bits) - 1;
+
+  while (size)
+  {
+    uint64_t page_offset = offset & page_mask;
+    uint64_t iter_size = page_mask + 1 - page_offset;
+    if (iter_size > size)
+      iter_size = size;
+
+    uint8_t *page = this->get_page(offset >> this->page_bits);
+
+    if (is_write)
+      memcpy((void *)&page[page_offset], (void *)data, iter_size);
+    else
+      memcpy((void *)data, (void *)&page[page_offset], iter_size);
+
+    offset += iter_size;
+    data += iter_size;
+    size -= iter_size;
+  }
+}
+
+void memory::check_add_range(uint64_t base, uint64_t size)
+{
+  this->trace.msg("Checking uninitialized accesses (base: 0x%lx, size: 0x%lx)\n", base, size);
+
+  Memory_check_range range;
+  range.base = base;
+  range.size = size;
+  range.bitmap = new uint64_t[(size + 63) / 64]();
+  this->check_ranges.push_back(range);
+}
+
+void memory::check_set(Memory_check_range *range, uint64_t offset, uint64_t size)
+{
+  uint64_t *bitmap = range->bitmap;
+  uint64_t first = offset / 64;
+  uint64_t last = (offset + size - 1) / 64;
+  uint64_t first_mask = ~0ULL << (offset % 64);
+  uint64_t last_mask = ~0ULL >> (63 - (offset + size - 1) % 64);
+
+  if (first == last)
+  {
+    bitmap[first] |= first_mask & last_mask;
+    return;
+  }
+
+  bitmap[first] |= first_mask;
+  for (uint64_t i=first+1; i<last; i++)
+  {
+    bitmap[i] = ~0ULL;
+  }
+  bitmap[last] |= last_mask;
+}
+
+int64_t memory::check_get_uninit(Memory_check_range *range, uint64_t offset, uint64_t size)
+{
+  uint64_t *bitmap = range->bitmap;
+  uint64_t first = offset / 64;
+  uint64_t last = (offset + size - 1) / 64;
+  uint64_t first_mask = ~0ULL << (offset % 64);
+  uint64_t last_mask = ~0ULL >> (63 - (offset + size - 1) % 64);
+
+  // Look for the first word with a byte which has not been written
+  for (uint64_t i=first; i<=last; i++)
+  {
+    uint64_t mask = ~0ULL;
+    if (i == first)
+      mask &= first_mask;
+    if (i == last)
+      mask &= last_mask;
+
+    uint64_t uninit = ~bitmap[i] & mask;
+    if (uninit)
+    {
+      return i * 64 + __builtin_ctzll(uninit);
+    }
+  }
+
+  return -1;
+}
+
 vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
 {
   memory *_this = (memory *)__this;
@@ -98,10 +227,10 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
 
   if (!req->is_debug())
   {
-    // Impact the memory bandwith on the packet
+    // Impact the memory bandwith on the packet, bursts are accounted as a whole
     if (_this->width_bits != 0) {
   #define MAX(a,b) (((a)>(b))?(a):(b))
-      int duration = MAX(size >> _this->width_bits, 1);
+      int duration = MAX(req->get_burst_size() >> _this->width_bits, 1);
       req->set_duration(duration);
       int64_t cycles = _this->get_cycles();
       int64_t diff = _this->next_packet_start - cycles;
@@ -154,31 +283,80 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
   #endif
   }
 
-  if (offset + size > _this->size) {
-    _this->trace.force_warning("Received out-of-bound request (reqAddr: 0x%x, reqSize: 0x%x, memSize: 0x%x)\n", offset, size, _this->size);
+  if (req->get_burst() == NULL)
+  {
+    return _this->access(offset, size, data, req->get_is_write());
+  }
+
+  // Bursts are handled in one call, chunk by chunk, their data being contiguous
+  int nb_chunks = req->get_nb_chunks();
+  for (int i=0; i<nb_chunks; i++)
+  {
+    req->get_chunk(i, &offset, &size);
+
+    vp::io_req_status_e err = _this->access(offset, size, data, req->get_is_write());
+    if (err != vp::IO_REQ_OK)
+    {
+      return err;
+    }
+
+    if (data)
+      data += size;
+  }
+
+  return vp::IO_REQ_OK;
+}
+
+vp::io_req_status_e memory::access(uint64_t offset, uint64_t size, uint8_t *data, bool is_write)
+{
+  if (offset + size > this->size) {
+    this->trace.force_warning("Received out-of-bound request (reqAddr: 0x%x, reqSize: 0x%x, memSize: 0x%x)\n", offset, size, this->size);
     return vp::IO_REQ_INVALID;
   }
 
-  if (req->get_is_write()) {
-    if (_this->check_mem) {
-      for (unsigned int i=0; i<size; i++) {
-        _this->check_mem[(offset + i) / 8] |= 1 << ((offset + i) % 8);
+  // Only the part of the access which falls into each checked range is considered
+  for (Memory_check_range &range: this->check_ranges)
+  {
+    if (size == 0 || offset + size <= range.base || offset >= range.base + range.size)
+      continue;
+
+    uint64_t check_offset = offset > range.base ? offset - range.base : 0;
+    uint64_t check_end = offset + size - range.base;
+    if (check_end > range.size)
+      check_end = range.size;
+
+    if (is_write)
+    {
+      this->check_set(&range, check_offset, check_end - check_offset);
+    }
+    else
+    {
+      int64_t uninit = this->check_get_uninit(&range, check_offset, check_end - check_offset);
+      if (uninit != -1)
+      {
+        this->trace.force_warning("Uninitialized access (offset: 0x%lx, size: 0x%lx, first uninitialized byte: 0x%lx)\n",
+          offset, size, range.base + uninit);
+        return vp::IO_REQ_INVALID;
       }
     }
+  }
+
+  if (is_write) {
     if (data)
-      memcpy((void *)&_this->mem_data[offset], (void *)data, size);
-  } else {
-    if (_this->check_mem) {
-      for (unsigned int i=0; i<size; i++) {
-        int access = (_this->check_mem[(offset + i) / 8] >> ((offset + i) % 8)) & 1;
-        if (!access) {
-          //trace.msg("Unitialized access (offset: 0x%x, size: 0x%x, isRead: %d)\n", offset, size, isRead);
-          return vp::IO_REQ_INVALID;
-        }
-      }
+    {
+      if (this->sparse)
+        this->sparse_access(offset, size, data, true);
+      else
+        memcpy((void *)&this->mem_data[offset], (void *)data, size);
     }
+  } else {
     if (data)
-      memcpy((void *)data, (void *)&_this->mem_data[offset], size);
+    {
+      if (this->sparse)
+        this->sparse_access(offset, size, data, false);
+      else
+        memcpy((void *)data, (void *)&this->mem_data[offset], size);
+    }
   }
 
   return vp::IO_REQ_OK;
@@ -202,6 +380,13 @@ void memory::power_ctrl_sync(void *__this, bool value)
 void memory::meminfo_sync_back(void *__this, void **value)
 {
     memory *_this = (memory *)__this;
+    if (_this->sparse)
+    {
+      // There is no contiguous memory area to export in sparse mode
+      _this->trace.force_warning("Memory information requested on sparse memory\n");
+      *value = NULL;
+      return;
+    }
     *value = _this->mem_data;
 }
 
@@ -209,6 +394,8 @@ void memory::meminfo_sync(void *__this, void *value)
 {
     memory *_this = (memory *)__this;
     _this->mem_data = (uint8_t *)value;
+    // The memory area is now provided from outside, switch back to dense mode
+    _this->sparse = false;
 }
 
 
@@ -241,14 +428,50 @@ int memory::build()
 
 void memory::start()
 {
-  size = get_config_int("size");
+  // get_config_int returns an int, which would truncate memories of 2GiB or more
+  size = this->get_js_config()->get_int("size");
   check = get_config_bool("check");
   width_bits = get_config_int("width_bits");
   int align = get_config_int("align");
+  sparse = get_config_bool("sparse");
+  bool writeback = get_config_bool("writeback");
+  bool mapped = writeback || get_config_bool("mmap_stim_file");
 
-  trace.msg("Building memory (size: 0x%x, check: %d)\n", size, check);
+  string stim_file = "";
+  js::config *stim_file_conf = this->get_js_config()->get("stim_file");
+  if (stim_file_conf != NULL)
+  {
+    stim_file = stim_file_conf->get_str();
+  }
 
-  if (align)
+  // The memory can only be mapped on a stimuli file
+  mapped = mapped && stim_file != "";
+  if (mapped)
+  {
+    sparse = false;
+  }
+
+  trace.msg("Building memory (size: 0x%x, check: %d, sparse: %d, mapped: %d)\n", size, check, sparse, mapped);
+
+  if (mapped)
+  {
+    trace.msg("Mapping memory on stimuli file (path: %s, writeback: %d)\n", stim_file.c_str(), writeback);
+
+    mem_data = vp::mem_file_map(stim_file, size, 0x57, writeback);
+    if (mem_data == NULL)
+    {
+      this->trace.fatal("Unable to map stim file: %s, %s\n", stim_file.c_str(), strerror(errno));
+      return;
+    }
+  }
+  else if (sparse)
+  {
+    int page_size = get_config_int("page_size");
+    page_bits = page_size ? log2(page_size) : 16;
+    pages = new uint8_t *[(size + (1ULL << page_bits) - 1) >> page_bits]();
+    mem_data = NULL;
+  }
+  else if (align)
   {
     mem_data = (uint8_t *)aligned_alloc(align, size);
   }
@@ -257,43 +480,82 @@ void memory::start()
     mem_data = new uint8_t[size];
   }
 
-  // Special option to check for uninitialized accesses
+  // Special option to check for uninitialized accesses, either on specific ranges
+  // or on the whole memory
   if (check)
   {
-    check_mem = new uint8_t[(size + 7)/8];
-  }
-  else
-  {
-    check_mem = NULL;
+    js::config *ranges = get_js_config()->get("check_ranges");
+    if (ranges != NULL && ranges->get_elems().size() != 0)
+    {
+      for (auto range: ranges->get_elems())
+      {
+        uint64_t base = range->get_elem(0)->get_int();
+        uint64_t range_size = range->get_elem(1)->get_int();
+
+        if (base >= size || range_size == 0)
+          continue;
+
+        if (base + range_size > size)
+          range_size = size - base;
+
+        this->check_add_range(base, range_size);
+      }
+    }
+    else
+    {
+      this->check_add_range(0, size);
+    }
   }
 
 
   // Initialize the memory with a special value to detect uninitialized
   // variables
-  memset(mem_data, 0x57, size);
+  if (!sparse && !mapped)
+  {
+    memset(mem_data, 0x57, size);
+  }
 
 
   // Preload the memory
-  js::config *stim_file_conf = this->get_js_config()->get("stim_file");
-  if (stim_file_conf != NULL)
+  if (stim_file != "" && !mapped)
   {
-    string path = stim_file_conf->get_str();
-    if (path != "")
-    {
-      trace.msg("Preloading memory with stimuli file (path: %s)\n", path.c_str());
+    string path = stim_file;
+
+    trace.msg("Preloading memory with stimuli file (path: %s)\n", path.c_str());
 
-      FILE *file = fopen(path.c_str(), "rb");
-      if (file == NULL)
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+    {
+      this->trace.fatal("Unable to open stim file: %s, %s\n", path.c_str(), strerror(errno));
+      return;
+    }
+    if (sparse)
+    {
+      // Only the pages covered by the file get allocated
+      uint64_t page_size = 1ULL << page_bits;
+      uint8_t *buffer = new uint8_t[page_size];
+      uint64_t offset = 0;
+      size_t read_size;
+      while (offset < size && (read_size = fread(buffer, 1, page_size, file)) > 0)
       {
-        this->trace.fatal("Unable to open stim file: %s, %s\n", path.c_str(), strerror(errno));
-        return;
+        if (offset + read_size > size)
+          read_size = size - offset;
+        this->sparse_access(offset, read_size, buffer, true);
+        offset += read_size;
       }
-      if (fread(this->mem_data, 1, size, file) == 0)
+      delete[] buffer;
+
+      if (offset == 0)
       {
         this->trace.fatal("Failed to read stim file: %s, %s\n", path.c_str(), strerror(errno));
         return;
       }
     }
+    else if (fread(this->mem_data, 1, size, file) == 0)
+    {
+      this->trace.fatal("Failed to read stim file: %s, %s\n", path.c_str(), strerror(errno));
+      return;
+    }
   }
 
   this->background_power.leakage_power_start();
@@ -37,6 +37,7 @@ private:
     static void edge_handler(void *__this, vp::clock_event *event);
     void raise_edge();
     static void power_sync(void *__this, bool active);
+    void sync_phase();
 
     vp::wire_slave<bool> power_itf;
     vp::clock_master clock_ctrl_itf;
@@ -48,6 +49,11 @@ private:
     float powerup_time;
     bool powered_on;
     int64_t start_time;
+    // True if all the slaves compute the edges from the frequency and phase, in which case
+    // edges are only generated while the frequency is ramping up
+    bool analytic;
+    // True if the phase must be sent to analytic slaves on the next edge
+    bool phase_pending;
 };
 
 void Clock::edge_handler(void *__this, vp::clock_event *event)
@@ -62,7 +68,9 @@ void Clock::raise_edge()
     {
         this->get_trace()->msg(vp::trace::LEVEL_TRACE, "Changing clock level (level: %d)\n", value);
 
-        if (this->target_frequency && this->clock_ctrl_itf.is_bound())
+        bool ramp = this->target_frequency && this->clock_ctrl_itf.is_bound();
+
+        if (ramp)
         {
             int64_t diff_time = this->get_time()- this->start_time;
             if (diff_time >= this->powerup_time)
@@ -78,12 +86,36 @@ void Clock::raise_edge()
         }
 
         this->clock_sync_itf.sync(value);
+
+        // Analytic slaves get the phase on the first edge and on each edge of the ramp, as
+        // the frequency is then changing, and compute the other edges by themselves.
+        // This is done even if other slaves still need the edges.
+        if (ramp || this->phase_pending)
+        {
+            this->sync_phase();
+            this->phase_pending = false;
+        }
+
         this->value ^= 1;
-        this->event_enqueue(this->event, 1);
+
+        // Once the frequency is stable, edges are only needed if some slaves are not analytic
+        if (!this->analytic || (this->target_frequency && this->clock_ctrl_itf.is_bound()))
+        {
+            this->event_enqueue(this->event, 1);
+        }
     }
 }
 
 
+void Clock::sync_phase()
+{
+    this->get_trace()->msg(vp::trace::LEVEL_TRACE, "Sending clock phase (level: %d, frequency: %ld)\n", value, this->get_clock()->get_frequency() / 2);
+
+    this->clock_sync_itf.set_phase_frequency(this->get_clock()->get_frequency() / 2);
+    this->clock_sync_itf.sync_phase(this->get_time(), value);
+}
+
+
 void Clock::power_sync(void *__this, bool active)
 {
     Clock *_this = (Clock *)__this;
@@ -96,6 +128,7 @@ void Clock::power_sync(void *__this, bool active)
         {
             _this->target_frequency = _this->frequency;
             _this->start_time = _this->get_time();
+            _this->phase_pending = true;
             _this->event_enqueue(_this->event, 1);
         }
         else
@@ -104,6 +137,10 @@ void Clock::power_sync(void *__this, bool active)
             {
                 _this->event_cancel(_this->event);
             }
+
+            // Analytic slaves can not see that edges are not generated anymore, tell them
+            // the clock is stopped
+            _this->clock_sync_itf.set_phase_frequency(0);
         }
     }
 
@@ -125,6 +162,8 @@ int Clock::build()
     this->new_master_port("clock_ctrl", &this->clock_ctrl_itf);
     this->new_master_port("clock_sync", &this->clock_sync_itf);
     this->value = 0;
+    this->analytic = false;
+    this->phase_pending = false;
     this->powerup_time = this->get_js_config()->get_child_int("powerup_time");
     this->powered_on = this->get_js_config()->get("powered_on") == NULL || this->get_js_config()->get_child_bool("powered_on");
 
@@ -137,6 +176,8 @@ void Clock::reset(bool active)
     {
         this->frequency = this->get_clock()->get_frequency();
         this->clock_sync_itf.set_frequency(this->get_clock()->get_frequency() / 2);
+        this->analytic = this->clock_sync_itf.is_analytic();
+        this->phase_pending = true;
 
         if (this->powered_on)
         {
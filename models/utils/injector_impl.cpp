@@ -21,12 +21,15 @@
 
 #include <vp/vp.hpp>
 #include <vp/launcher_internal.hpp>
+#include <vp/launcher_ring.hpp>
 #include <vp/itf/io.hpp>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <vector>
 
 class injector : public vp::component {
 
@@ -36,6 +39,7 @@ public:
 
   int build();
   void start();
+  void stop();
 
 private:
 
@@ -49,8 +53,20 @@ private:
   FILE *snd_file;
   FILE *rcv_file;
 
+  // Shared-memory transport, NULL if pipes are used
+  Gv_ring *to_sim = NULL;
+  Gv_ring *to_host = NULL;
+  std::vector<uint8_t> read_data;
+
+  // Requests and responses to the host are sent from both the engine thread and the
+  // binding thread, which may hold the engine lock, so they go through a sender which
+  // never waits for the transport
+  Gv_ring_sender *sender = NULL;
+
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
   void binding_routine();
+  void binding_ring_routine();
+  int open_ring(int fd);
 
 };
 
@@ -71,7 +87,7 @@ vp::io_req_status_e injector::req(void *__this, vp::io_req *req)
 
   _this->trace.msg("IO access (offset: 0x%lx, size: 0x%lx, is_write: %d)\n", offset, size, req->get_is_write());
 
-  if (_this->snd_file == NULL)
+  if (_this->sender == NULL)
   {
     _this->trace.force_warning("Accessing injector while it is not connected\n");
     return vp::IO_REQ_INVALID;
@@ -82,9 +98,7 @@ vp::io_req_status_e injector::req(void *__this, vp::io_req *req)
     .binding=(void *)_this->binding_context, .req=req
   };
 
-  if (fwrite((void *)&desc, sizeof(desc), 1, _this->snd_file) != 1) return vp::IO_REQ_INVALID;
-  if (is_write && fwrite(data, size, 1, _this->snd_file) != 1) return vp::IO_REQ_INVALID;
-  fflush(_this->snd_file);
+  _this->sender->send(&desc, sizeof(desc), data, is_write ? size : 0);
 
   return vp::IO_REQ_PENDING;
 }
@@ -131,10 +145,7 @@ void injector::binding_routine()
 
       req.type = GV_IOREQ_DESC_TYPE_RESPONSE;
 
-      if (fwrite(&req, sizeof(req), 1, snd_file) != 1) return;
-      if (!req.is_write && fwrite((void *)data, req.size, 1, snd_file) != 1) return;
-
-      fflush(snd_file);
+      this->sender->send(&req, sizeof(req), data, req.is_write ? 0 : req.size);
     }
     else
     {
@@ -151,6 +162,90 @@ void injector::binding_routine()
   }
 }
 
+void injector::binding_ring_routine()
+{
+  this->get_clock()->get_engine()->wait_running();
+
+  while(1)
+  {
+    size_t size;
+    uint8_t *record = (uint8_t *)this->to_sim->peek(&size);
+    if (record == NULL)
+      return;
+
+    gv_ioreq_desc_t req = *(gv_ioreq_desc_t *)record;
+    uint8_t *payload = record + sizeof(req);
+
+    if (req.type == GV_IOREQ_DESC_TYPE_REQUEST)
+    {
+      this->trace.msg("Received IO req from external binding (addr: 0x%llx, size: 0x%llx, is_write: %d)\n", req.addr, req.size, req.is_write);
+
+      // Write data is used directly from the ring, which is only released once the
+      // access is done
+      uint8_t *data = payload;
+      if (!req.is_write)
+      {
+        if (this->read_data.size() < req.size)
+          this->read_data.resize(req.size);
+        data = this->read_data.data();
+      }
+
+      this->get_clock()->get_engine()->lock();
+
+      vp::io_req *io_req = &ext_req;
+      io_req->init();
+      io_req->set_addr(req.addr);
+      io_req->set_size(req.size);
+      io_req->set_is_write(req.is_write);
+      io_req->set_data(data);
+
+      this->get_clock()->sync();
+
+      int err = this->out.req(io_req);
+
+      req.user_req.state = err != vp::IO_REQ_OK ? GV_IOREQ_DONE_ERROR : GV_IOREQ_DONE;
+      req.user_req.latency = this->get_time() + io_req->get_latency() + io_req->get_duration();
+
+      this->get_clock()->get_engine()->unlock();
+
+      this->to_sim->pop();
+
+      req.type = GV_IOREQ_DESC_TYPE_RESPONSE;
+
+      // Responses are sent with a single doorbell until no more request is pending
+      this->sender->send(&req, sizeof(req), data, req.is_write ? 0 : req.size, !this->to_sim->pending());
+    }
+    else
+    {
+      vp::io_req *ioreq = (vp::io_req *)req.req;
+      if (!ioreq->get_is_write())
+        memcpy(ioreq->get_data(), payload, ioreq->get_size());
+      this->to_sim->pop();
+
+      this->get_clock()->get_engine()->lock();
+      ioreq->set_latency(0);
+      ioreq->get_resp_port()->resp(ioreq);
+      this->get_clock()->get_engine()->unlock();
+    }
+  }
+}
+
+int injector::open_ring(int fd)
+{
+  struct stat info;
+  if (fstat(fd, &info) == -1)
+    return -1;
+
+  void *shm = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (shm == MAP_FAILED)
+    return -1;
+
+  this->to_sim = new Gv_ring(shm, GV_IOREQ_RING_TO_SIM);
+  this->to_host = new Gv_ring(shm, GV_IOREQ_RING_TO_HOST);
+
+  return 0;
+}
+
 int injector::build()
 {
   in.set_req_meth(&injector::req);
@@ -165,6 +260,16 @@ int injector::build()
 
   this->binding_context = (void *)(long)this->get_js_config()->get_int("context");
 
+  if (this->get_js_config()->get("ring_fd") != NULL)
+  {
+    int ring_fd = this->get_js_config()->get_int("ring_fd");
+    if (this->open_ring(ring_fd))
+    {
+      snprintf(vp_error, VP_ERROR_SIZE, "Failed to map IO request rings: %s",  strerror(errno));
+      return -1;
+    }
+  }
+
   if (snd_fd != -1)
   {
     snd_file = fdopen(snd_fd, "w");
@@ -179,6 +284,11 @@ int injector::build()
     snd_file = NULL;
   }
 
+  if (this->to_host || snd_file)
+  {
+    this->sender = new Gv_ring_sender(this->to_host, snd_file);
+  }
+
   if (rcv_fd != -1)
   {
     rcv_file = fdopen(rcv_fd, "r");
@@ -198,13 +308,27 @@ int injector::build()
 
 void injector::start()
 {
-  if (rcv_file)
+  if (this->to_sim)
+  {
+    this->get_clock()->retain();
+    new std::thread(&injector::binding_ring_routine, this);
+  }
+  else if (rcv_file)
   {
     this->get_clock()->retain();
     new std::thread(&injector::binding_routine, this);
   }
 }
 
+void injector::stop()
+{
+  // Let the host binding thread know that no more request will come
+  if (this->to_host)
+  {
+    this->to_host->close();
+  }
+}
+
 extern "C" vp::component *vp_constructor(js::config *config)
 {
   return new injector(config);
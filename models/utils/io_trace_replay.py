@@ -0,0 +1,50 @@
+#
+# Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+
+import gsystree as st
+
+class Io_trace_replay(st.Component):
+    """
+    Replays a memory access trace recorded by a master (e.g. an ISS with io_trace set)
+
+    The stream is sent on the output port, which can be connected to any IO interconnect
+    or memory, to evaluate them without simulating the master.
+
+    Attributes
+    ----------
+    file : str
+        Path to the trace file.
+    master : int, optional
+        Only replay the accesses of this master, -1 to replay all of them (default: -1).
+    fetch : bool, optional
+        True if instruction fetches should be replayed as well as data accesses (default: True).
+    timed : bool, optional
+        True if each access should be sent at its recorded timestamp, or as soon as the previous
+        one is done if this is later, False if they should be sent back-to-back (default: True).
+    """
+
+    def __init__(self, parent, name, file, master=-1, fetch=True, timed=True):
+        super(Io_trace_replay, self).__init__(parent, name)
+
+        self.set_component('utils.io_trace_replay_impl')
+
+        self.add_properties({
+            'file': file,
+            'master': master,
+            'fetch': fetch,
+            'timed': timed
+        })
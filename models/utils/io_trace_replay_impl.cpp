@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <vp/trace/io_trace.hpp>
+#include <string.h>
+#include <vector>
+
+// Replays a stream of memory accesses recorded by a master (see vp::Io_trace_writer)
+// on an IO interconnect, so that memory-side components can be studied without
+// simulating the masters.
+// Requests are sent one at a time, in the recorded order. In timed mode, each
+// request is sent at its recorded timestamp, or as soon as the previous one is
+// done if this is later. Otherwise they are sent back-to-back.
+
+class io_trace_replay : public vp::component
+{
+
+public:
+
+  io_trace_replay(js::config *config);
+
+  int build();
+  void start();
+  void stop();
+
+private:
+
+  static void send_handler(void *__this, vp::clock_event *event);
+  static void response(void *__this, vp::io_req *req);
+
+  void handle_done(int64_t latency);
+  void schedule_next(int64_t min_cycles);
+
+  vp::trace     trace;
+  vp::io_master out;
+
+  vp::io_req req;
+  vp::clock_event *send_event;
+  vp::Io_trace_reader *reader = NULL;
+  vp::io_trace_record_t record;
+  std::vector<uint8_t> data;
+
+  bool timed;
+  bool replay_fetch;
+  int master;
+
+  int64_t trace_start_timestamp = -1;
+  int64_t replay_start_timestamp;
+  int64_t req_timestamp;
+
+  int64_t nb_reads = 0;
+  int64_t nb_writes = 0;
+  int64_t nb_errors = 0;
+  int64_t total_latency = 0;
+  int64_t total_recorded_latency = 0;
+};
+
+
+io_trace_replay::io_trace_replay(js::config *config)
+: vp::component(config)
+{
+}
+
+
+void io_trace_replay::schedule_next(int64_t min_cycles)
+{
+  // Look for the next record which should be replayed
+  while(1)
+  {
+    vp::io_trace_record_t *record = this->reader->next();
+    if (record == NULL)
+    {
+      this->trace.msg(vp::trace::LEVEL_INFO, "Reached end of trace\n");
+      return;
+    }
+
+    if ((this->master != -1 && record->master != this->master) ||
+      (!this->replay_fetch && (record->flags & vp::IO_TRACE_FLAGS_FETCH)))
+      continue;
+
+    this->record = *record;
+    break;
+  }
+
+  if (this->trace_start_timestamp == -1)
+  {
+    this->trace_start_timestamp = this->record.timestamp;
+  }
+
+  int64_t cycles = min_cycles;
+
+  if (this->timed)
+  {
+    int64_t delay = (this->record.timestamp - this->trace_start_timestamp) -
+      (this->get_time() - this->replay_start_timestamp);
+    int64_t delay_cycles = delay / this->get_period();
+
+    if (delay_cycles > cycles)
+    {
+      cycles = delay_cycles;
+    }
+  }
+
+  this->event_enqueue(this->send_event, cycles);
+}
+
+
+void io_trace_replay::handle_done(int64_t latency)
+{
+  this->total_latency += latency;
+  this->total_recorded_latency += this->record.latency;
+
+  this->schedule_next(latency + 1);
+}
+
+
+void io_trace_replay::send_handler(void *__this, vp::clock_event *event)
+{
+  io_trace_replay *_this = (io_trace_replay *)__this;
+  vp::io_trace_record_t *record = &_this->record;
+  bool is_write = record->flags & vp::IO_TRACE_FLAGS_WRITE;
+
+  if (record->size > _this->data.size())
+  {
+    _this->data.resize(record->size);
+  }
+
+  _this->trace.msg(vp::trace::LEVEL_TRACE, "Replaying access (addr: 0x%lx, size: 0x%x, is_write: %d, recorded latency: %ld)\n",
+    record->addr, record->size, is_write, record->latency);
+
+  vp::io_req *req = &_this->req;
+  req->init();
+  req->set_addr(record->addr);
+  req->set_size(record->size);
+  req->set_is_write(is_write);
+  req->set_data(_this->data.data());
+
+  if (is_write)
+    _this->nb_writes++;
+  else
+    _this->nb_reads++;
+
+  _this->req_timestamp = _this->get_time();
+
+  vp::io_req_status_e err = _this->out.req(req);
+
+  if (err == vp::IO_REQ_OK)
+  {
+    _this->handle_done(req->get_full_latency());
+  }
+  else if (err == vp::IO_REQ_INVALID)
+  {
+    _this->trace.msg(vp::trace::LEVEL_WARNING, "Invalid access (addr: 0x%lx, size: 0x%x, is_write: %d)\n",
+      record->addr, record->size, is_write);
+    _this->nb_errors++;
+    _this->handle_done(0);
+  }
+}
+
+
+void io_trace_replay::response(void *__this, vp::io_req *req)
+{
+  io_trace_replay *_this = (io_trace_replay *)__this;
+  int64_t elapsed = (_this->get_time() - _this->req_timestamp) / _this->get_period();
+
+  _this->handle_done(elapsed + req->get_full_latency());
+}
+
+
+int io_trace_replay::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  out.set_resp_meth(&io_trace_replay::response);
+  new_master_port("output", &out);
+
+  this->send_event = this->event_new(io_trace_replay::send_handler);
+
+  this->timed = this->get_js_config()->get_child_bool("timed");
+  this->replay_fetch = this->get_js_config()->get_child_bool("fetch");
+  this->master = this->get_js_config()->get_child_int("master");
+
+  return 0;
+}
+
+
+void io_trace_replay::start()
+{
+  std::string path = this->get_js_config()->get_child_str("file");
+
+  this->reader = new vp::Io_trace_reader(path);
+  if (!this->reader->is_open())
+  {
+    this->trace.fatal("Unable to open IO trace file (path: %s)\n", path.c_str());
+    return;
+  }
+
+  this->replay_start_timestamp = this->get_time();
+
+  this->schedule_next(1);
+}
+
+
+void io_trace_replay::stop()
+{
+  int64_t nb_reqs = this->nb_reads + this->nb_writes;
+
+  if (nb_reqs)
+  {
+    this->trace.msg(vp::trace::LEVEL_INFO, "Replay statistics (reads: %ld, writes: %ld, errors: %ld, average latency: %f, recorded average latency: %f)\n",
+      this->nb_reads, this->nb_writes, this->nb_errors, (float)this->total_latency / nb_reqs,
+      (float)this->total_recorded_latency / nb_reqs);
+  }
+
+  if (this->reader)
+  {
+    delete this->reader;
+    this->reader = NULL;
+  }
+}
+
+
+extern "C" vp::component *vp_constructor(js::config *config)
+{
+  return new io_trace_replay(config);
+}
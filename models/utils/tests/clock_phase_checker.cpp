@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+// Test component for the analytic mode of the clock generator.
+// It is bound to the same generator output through 2 ports, one getting the edges and one
+// in analytic mode, which is the mixed case where the generator must keep on generating
+// edges while still giving the phase to the analytic slaves.
+// If its power port is bound, it powers the generator on when the reset is released, so
+// that the frequency ramp is also checked.
+// After check_cycles cycles of its own clock, it compares the number of rising edges it
+// received with the number it computed from the frequency and phase, and stops the
+// simulation with status 0 if they match, and 1 otherwise.
+
+#include <vp/vp.hpp>
+#include <vp/itf/clock.hpp>
+#include <vp/itf/wire.hpp>
+#include <stdio.h>
+#include <math.h>
+
+class Clock_phase_checker : public vp::component
+{
+
+public:
+    Clock_phase_checker(js::config *config);
+
+    int build();
+    void reset(bool active);
+
+private:
+    static void edge_sync(void *__this, bool value);
+    static void phase_set_frequency(void *__this, int64_t frequency);
+    static void phase_sync(void *__this, int64_t time, bool value);
+    static void check_handler(void *__this, vp::clock_event *event);
+    int64_t get_phase_edges(int64_t time, bool inclusive);
+
+    vp::trace trace;
+    vp::clock_slave edge_itf;
+    vp::clock_slave phase_itf;
+    vp::wire_master<bool> power_itf;
+    vp::clock_event *check_event;
+    int64_t check_cycles;
+
+    int64_t nb_edges;           // Rising edges received on the edge port
+    int64_t nb_phase_edges;     // Rising edges computed on the analytic port, until phase_time
+    int64_t frequency;          // Last frequency received on the analytic port
+    int64_t phase_frequency;    // Frequency since the last phase
+    int64_t phase_time;
+    bool phase_value;
+};
+
+
+Clock_phase_checker::Clock_phase_checker(js::config *config)
+    : vp::component(config)
+{
+}
+
+
+void Clock_phase_checker::edge_sync(void *__this, bool value)
+{
+    Clock_phase_checker *_this = (Clock_phase_checker *)__this;
+    if (value)
+    {
+        _this->nb_edges++;
+    }
+}
+
+
+void Clock_phase_checker::phase_set_frequency(void *__this, int64_t frequency)
+{
+    Clock_phase_checker *_this = (Clock_phase_checker *)__this;
+    _this->frequency = frequency;
+}
+
+
+void Clock_phase_checker::phase_sync(void *__this, int64_t time, bool value)
+{
+    Clock_phase_checker *_this = (Clock_phase_checker *)__this;
+
+    _this->trace.msg(vp::trace::LEVEL_TRACE, "Received phase (time: %ld, value: %d, frequency: %ld)\n", time, value, _this->frequency);
+
+    // Account the edges computed since the previous phase, and the one of this phase
+    _this->nb_phase_edges = _this->get_phase_edges(time, false) + value;
+    _this->phase_time = time;
+    _this->phase_value = value;
+    _this->phase_frequency = _this->frequency;
+}
+
+
+int64_t Clock_phase_checker::get_phase_edges(int64_t time, bool inclusive)
+{
+    if (this->phase_time == -1 || this->phase_frequency == 0)
+    {
+        return this->nb_phase_edges;
+    }
+
+    // The clock toggles at twice the frequency. Edge k after the phase is at
+    // phase_time + k*half_period and is a rising edge if its level is 1.
+    double half_period = 1e12 / this->phase_frequency / 2;
+    double nb_periods = (time - this->phase_time) / half_period;
+    int64_t nb_toggles = inclusive ? floor(nb_periods) : ceil(nb_periods) - 1;
+
+    if (nb_toggles <= 0)
+    {
+        return this->nb_phase_edges;
+    }
+
+    return this->nb_phase_edges + (this->phase_value ? nb_toggles / 2 : (nb_toggles + 1) / 2);
+}
+
+
+void Clock_phase_checker::check_handler(void *__this, vp::clock_event *event)
+{
+    Clock_phase_checker *_this = (Clock_phase_checker *)__this;
+
+    int64_t nb_phase_edges = _this->get_phase_edges(_this->get_time(), true);
+
+    // The check may be done at the same timestamp as an edge, before or after it, so
+    // one edge of difference is accepted
+    bool failed = _this->nb_edges == 0 || llabs(_this->nb_edges - nb_phase_edges) > 1;
+
+    printf("Clock phase check %s (edges: %ld, computed edges: %ld)\n", failed ? "failed" : "passed",
+        _this->nb_edges, nb_phase_edges);
+
+    _this->get_clock()->stop_engine(failed);
+}
+
+
+int Clock_phase_checker::build()
+{
+    this->traces.new_trace("trace", &this->trace, vp::DEBUG);
+
+    this->edge_itf.set_sync_meth(&Clock_phase_checker::edge_sync);
+    this->new_slave_port("edge", &this->edge_itf);
+
+    this->phase_itf.set_set_frequency_meth(&Clock_phase_checker::phase_set_frequency);
+    this->phase_itf.set_sync_phase_meth(&Clock_phase_checker::phase_sync);
+    this->new_slave_port("phase", &this->phase_itf);
+
+    this->new_master_port("power", &this->power_itf);
+
+    this->check_event = this->event_new(&Clock_phase_checker::check_handler);
+    this->check_cycles = this->get_js_config()->get_child_int("check_cycles");
+
+    return 0;
+}
+
+
+void Clock_phase_checker::reset(bool active)
+{
+    if (active)
+    {
+        this->nb_edges = 0;
+        this->nb_phase_edges = 0;
+        this->frequency = 0;
+        this->phase_frequency = 0;
+        this->phase_time = -1;
+        this->phase_value = 0;
+    }
+    else
+    {
+        this->event_enqueue(this->check_event, this->check_cycles);
+
+        if (this->power_itf.is_bound())
+        {
+            this->power_itf.sync(true);
+        }
+    }
+}
+
+
+extern "C" vp::component *vp_constructor(js::config *config)
+{
+    return new Clock_phase_checker(config);
+}